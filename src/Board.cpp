@@ -7,6 +7,7 @@
 #include <OffsetView.h>
 #include <RegionFileFormat.h>
 #include <ResourceBase.h>
+#include <sim/SimThread.h>
 #include <Tile.h>
 #include <TileWidth.h>
 
@@ -111,7 +112,12 @@ Board::Board() :    // FIXME we really should be doing member initialization lis
     lastVisibleArea_(0, 0, 0, 0),
     lastTopLeft_(0),
     debugChunkBorder_(sf::Lines),
-    debugDrawChunkBorder_(false) {
+    debugDrawChunkBorder_(false),
+    debugChunkHeat_(),
+    debugChunkHeatmap_(sf::Triangles),
+    tileChangeListeners_(),
+    simThread_(nullptr),
+    staleSnapshotChunks_() {
 
     static StaticInit staticInit;
     staticInit_ = &staticInit;
@@ -164,9 +170,17 @@ void Board::setRenderArea(const OffsetView& offsetView, float zoom) {
             ChunkCoords::toPair(visibleArea.getFirst()), ChunkCoords::toPair(visibleArea.getSecond())
         );
         lastVisibleArea_ = visibleArea;
+
+        // New chunks may get loaded, so the simulation can't be running.
+        if (simThread_ != nullptr) {
+            sim::SimThread::PauseGuard pauseGuard(*simThread_);
+            fileStorage_->updateVisibleChunks(*this, lastVisibleArea_);
+        }
     }
 
-    fileStorage_->updateVisibleChunks(*this, lastVisibleArea_);
+    if (simThread_ == nullptr) {
+        fileStorage_->updateVisibleChunks(*this, lastVisibleArea_);
+    }
     updateRender();
     currentChunkRender.updateVisibleArea(chunkDrawables_, lastVisibleArea_, lastTopLeft_, offsetView.getView().getTransform());
 }
@@ -232,7 +246,7 @@ const sf::String& Board::getNotesString() const {
     return notesText_.getString();
 }
 
-const std::unordered_map<ChunkCoords::repr, Chunk>& Board::getLoadedChunks() const {
+const ChunkTable<Chunk>& Board::getLoadedChunks() const {
     return chunks_;
 }
 
@@ -247,9 +261,10 @@ bool Board::isChunkLoaded(ChunkCoords::repr coords) const {
 
 void Board::loadChunk(Chunk&& chunk) {
     ChunkCoords::repr coords = chunk.getCoords();
-    auto chunkIter = chunks_.emplace(coords, std::move(chunk)).first;
+    auto chunkIter = chunks_.try_emplace(coords, std::move(chunk)).first;
     chunkIter->second.setLodRenderer(this);
-    chunkDrawables_[coords].setChunk(&chunkIter->second);
+    setChunkDrawable(coords, &chunkIter->second);
+    notifyChunkLoaded(coords);
 }
 
 Chunk& Board::accessChunk(ChunkCoords::repr coords) {
@@ -262,11 +277,38 @@ Chunk& Board::accessChunk(ChunkCoords::repr coords) {
     }
 
     spdlog::debug("Allocating new chunk at {}.", ChunkCoords::toPair(coords));
-    chunk = chunks_.emplace(std::piecewise_construct, std::forward_as_tuple(coords), std::forward_as_tuple(static_cast<LodRenderer*>(this), coords)).first;
-    chunkDrawables_[coords].setChunk(&chunk->second);
+    chunk = chunks_.try_emplace(coords, static_cast<LodRenderer*>(this), coords).first;
+    setChunkDrawable(coords, &chunk->second);
     return chunk->second;
 }
 
+Chunk* Board::findChunk(ChunkCoords::repr coords) {
+    auto chunk = chunks_.find(coords);
+    if (chunk != chunks_.end()) {
+        return &chunk->second;
+    }
+    if (fileStorage_->loadChunk(*this, coords)) {
+        return &chunks_.find(coords)->second;
+    }
+    return nullptr;
+}
+
+Chunk* Board::findLoadedChunk(ChunkCoords::repr coords) {
+    auto chunk = chunks_.find(coords);
+    return (chunk != chunks_.end() ? &chunk->second : nullptr);
+}
+
+bool Board::unloadChunk(ChunkCoords::repr coords) {
+    auto chunk = chunks_.find(coords);
+    if (chunk == chunks_.end() || lastVisibleArea_.contains(coords) || !fileStorage_->unloadChunk(*this, chunk->second)) {
+        return false;
+    }
+    spdlog::debug("Unloading chunk at {}.", ChunkCoords::toPair(coords));
+    chunks_.erase(chunk);
+    setChunkDrawable(coords, nullptr);
+    return true;
+}
+
 Tile Board::accessTile(int x, int y) {
     // First method using floor division and positive modulus:
     // chunkCoordinate = static_cast<int>(std::floor(static_cast<double>(x) / Chunk::WIDTH))
@@ -349,6 +391,43 @@ std::pair<sf::Vector2i, sf::Vector2i> Board::getHighlightedBounds() {
     return {firstTile, secondTile};
 }
 
+void Board::addTileChangeListener(TileChangeListener* listener) {
+    tileChangeListeners_.push_back(listener);
+}
+
+void Board::removeTileChangeListener(TileChangeListener* listener) {
+    tileChangeListeners_.erase(std::remove(tileChangeListeners_.begin(), tileChangeListeners_.end(), listener), tileChangeListeners_.end());
+}
+
+void Board::notifyTileChanged(const sf::Vector2i& pos, TileChange::t change) {
+    for (auto listener : tileChangeListeners_) {
+        listener->tileChanged(pos, change);
+    }
+}
+
+void Board::setSimThread(sim::SimThread* simThread) {
+    simThread_ = simThread;
+    staleSnapshotChunks_.clear();
+    for (auto& chunkDrawable : chunkDrawables_) {
+        if (chunkDrawable.first != LodRenderer::EMPTY_CHUNK_COORDS && chunkDrawable.second.getChunk() != nullptr) {
+            chunkDrawable.second.setSnapshotEnabled(simThread != nullptr);
+            chunkDrawable.second.markDirty();
+        }
+    }
+}
+
+void Board::refreshStateSnapshots() {
+    for (auto coords : staleSnapshotChunks_) {
+        auto chunkDrawable = chunkDrawables_.find(coords);
+        if (chunkDrawable != chunkDrawables_.end() && chunkDrawable->second.isSnapshotEnabled() && chunkDrawable->second.getChunk() != nullptr) {
+            chunkDrawable->second.updateSnapshot();
+            // Let the chunk report the next edit, even if it doesn't get drawn before then.
+            chunkDrawable->second.getChunk()->markAsDrawn();
+        }
+    }
+    staleSnapshotChunks_.clear();
+}
+
 void Board::newBoard(const sf::Vector2u& size) {
     setMaxSize(size);
     if (maxSize_.x == 0) {
@@ -361,6 +440,7 @@ void Board::newBoard(const sf::Vector2u& size) {
     notesText_.setString("");
 
     clearChunks();
+    notifyBoardReloaded();
 }
 
 bool Board::loadFromFile(const fs::path& filename) {
@@ -386,6 +466,7 @@ bool Board::loadFromFile(const fs::path& filename) {
 
         clearChunks();
         fileStorage_->loadFromFile(*this, filename, boardFile);
+        notifyBoardReloaded();
     } catch (FileStorageError& ex) {
         spdlog::error(ex.what());
         newBoard();
@@ -436,6 +517,10 @@ void Board::debugSetDrawChunkBorder(bool enabled) {
     debugDrawChunkBorder_ = enabled;
 }
 
+void Board::debugSetChunkHeat(const std::vector<std::pair<ChunkCoords::repr, float>>& chunkHeat) {
+    debugChunkHeat_ = chunkHeat;
+}
+
 unsigned int Board::debugGetChunksDrawn() const {
     return lastVisibleArea_.width * lastVisibleArea_.height;
 }
@@ -443,6 +528,7 @@ unsigned int Board::debugGetChunksDrawn() const {
 void Board::clearChunks() {
     chunks_.clear();
     chunkDrawables_.clear();
+    staleSnapshotChunks_.clear();
     for (size_t i = 0; i < chunkRenderCache_.size(); ++i) {
         chunkRenderCache_[i].setLod(static_cast<int>(i));
         chunkRenderCache_[i].clear();
@@ -450,6 +536,18 @@ void Board::clearChunks() {
     chunkDrawables_[LodRenderer::EMPTY_CHUNK_COORDS].setChunk(emptyChunk_.get());
 }
 
+void Board::notifyBoardReloaded() {
+    for (auto listener : tileChangeListeners_) {
+        listener->boardReloaded();
+    }
+}
+
+void Board::notifyChunkLoaded(ChunkCoords::repr coords) {
+    for (auto listener : tileChangeListeners_) {
+        listener->chunkLoaded(coords);
+    }
+}
+
 void Board::pruneChunkDrawables() {
     spdlog::debug("Pruning chunkDrawables, size is {}.", chunkDrawables_.size());
     auto newLast = std::remove_if(chunkDrawables_.begin(), chunkDrawables_.end(), [](const decltype(chunkDrawables_)::value_type& chunkDrawable) {
@@ -463,6 +561,25 @@ void Board::pruneChunkDrawables() {
     chunkDrawables_.erase(newLast, chunkDrawables_.end());
 }
 
+void Board::setChunkDrawable(ChunkCoords::repr coords, const Chunk* chunk) {
+    auto& chunkDrawable = chunkDrawables_[coords];
+    chunkDrawable.setChunk(chunk);
+    chunkDrawable.setSnapshotEnabled(simThread_ != nullptr);
+}
+
+void Board::applyStateSnapshot() {
+    if (simThread_ == nullptr || !simThread_->consumeSnapshot()) {
+        return;
+    }
+    const auto& snapshot = simThread_->getSnapshot();
+    for (size_t i = 0; i < snapshot.chunkCoords.size(); ++i) {
+        auto chunkDrawable = chunkDrawables_.find(snapshot.chunkCoords[i]);
+        if (chunkDrawable != chunkDrawables_.end() && chunkDrawable->second.isSnapshotEnabled()) {
+            chunkDrawable->second.updateSnapshot(&snapshot.tiles[i * Chunk::WIDTH * Chunk::WIDTH]);
+        }
+    }
+}
+
 void Board::updateRender() {    // FIXME move this whole piece into ChunkRender? Not sure, it seems to belong in rendering code but moving it may make it difficult to customize deallocation of stale render blocks.
     auto drawChunk = [this](const ChunkDrawable& chunkDrawable, bool& allocatedBlock, ChunkCoords::repr coords) {
         if (chunkDrawable.getRenderIndex(getLevelOfDetail()) == -1) {
@@ -474,6 +591,7 @@ void Board::updateRender() {    // FIXME move this whole piece into ChunkRender?
         chunkRenderCache_[getLevelOfDetail()].drawChunk(chunkDrawable, states);
     };
 
+    applyStateSnapshot();
     bool emptyChunkVisible = false, allocatedBlock = false;
     for (int y = lastVisibleArea_.top; y < lastVisibleArea_.top + lastVisibleArea_.height; ++y) {
         // Optimize lookup of the chunkDrawable in the loop by finding first one
@@ -505,6 +623,9 @@ void Board::updateRender() {    // FIXME move this whole piece into ChunkRender?
 
 void Board::markChunkDrawDirty(ChunkCoords::repr coords) {
     chunkDrawables_.at(coords).markDirty();
+    if (simThread_ != nullptr && coords != LodRenderer::EMPTY_CHUNK_COORDS) {
+        staleSnapshotChunks_.push_back(coords);
+    }
 }
 
 void Board::draw(sf::RenderTarget& target, sf::RenderStates states) const {
@@ -528,6 +649,28 @@ void Board::draw(sf::RenderTarget& target, sf::RenderStates states) const {
             lastVisibleArea_.top - ChunkCoords::y(lastTopLeft_)
         };
 
+        // The heat goes from a faint yellow to a solid red, chunks without any activity are left clear.
+        debugChunkHeatmap_.clear();
+        for (const auto& chunkHeat : debugChunkHeat_) {
+            if (!lastVisibleArea_.contains(chunkHeat.first)) {
+                continue;
+            }
+            const float heat = std::min(std::max(chunkHeat.second, 0.0f), 1.0f);
+            const sf::Color heatColor(255, static_cast<sf::Uint8>(255.0f * (1.0f - heat)), 0, static_cast<sf::Uint8>(48.0f + 144.0f * heat));
+            const float xChunkPos = static_cast<float>((ChunkCoords::x(chunkHeat.first) - ChunkCoords::x(lastTopLeft_)) * chunkWidthTexels);
+            const float yChunkPos = static_cast<float>((ChunkCoords::y(chunkHeat.first) - ChunkCoords::y(lastTopLeft_)) * chunkWidthTexels);
+            const sf::Vector2f corners[4] = {
+                {xChunkPos, yChunkPos},
+                {xChunkPos + chunkWidthTexels, yChunkPos},
+                {xChunkPos + chunkWidthTexels, yChunkPos + chunkWidthTexels},
+                {xChunkPos, yChunkPos + chunkWidthTexels}
+            };
+            for (int i : {0, 1, 2, 0, 2, 3}) {
+                debugChunkHeatmap_.append(sf::Vertex(corners[i], heatColor));
+            }
+        }
+        target.draw(debugChunkHeatmap_, states);
+
         unsigned int i = 0;
         for (int y = 0; y < lastVisibleArea_.height; ++y) {
             auto chunkDrawable = chunkDrawables_.upper_bound(ChunkCoords::pack(lastVisibleArea_.left - 1, lastVisibleArea_.top + y));
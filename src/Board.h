@@ -5,21 +5,27 @@
 #include <ChunkCoordsRange.h>
 #include <ChunkDrawable.h>
 #include <ChunkRender.h>
+#include <ChunkTable.h>
 #include <FileStorage.h>
 #include <Filesystem.h>
 #include <FlatMap.h>
 #include <LodRenderer.h>
+#include <TileChangeListener.h>
 
 #include <array>
 #include <memory>
 #include <SFML/Graphics.hpp>
 #include <string>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 class OffsetView;
 class Tile;
 
+namespace sim {
+    class SimThread;
+}
+
 /**
  * A circuit board with a grid of circuit tiles.
  * 
@@ -28,6 +34,14 @@ class Tile;
  * will load/unload chunks as needed depending on what's visible. Drawing also
  * uses different levels-of-detail based on the zoom level. Boards can also
  * save/load to a file and work with different file formats.
+ *
+ * Chunks stay loaded while they are visible. The simulation can unload the
+ * chunks it no longer needs (outside of the visible area), which only works if
+ * the file storage is able to bring them back.
+ *
+ * While a `sim::SimThread` is attached, the chunks are drawn from the state
+ * snapshots it publishes. Any other access to the chunks must happen while the
+ * thread is paused, and loading chunks for the visible area pauses it.
  */
 class Board : public sf::Drawable, private LodRenderer {
 public:
@@ -50,12 +64,20 @@ public:
     sf::Vector2i getTileUpperBound() const;
     bool getExtraLogicStates() const;
     const sf::String& getNotesString() const;
-    const std::unordered_map<ChunkCoords::repr, Chunk>& getLoadedChunks() const;
+    const ChunkTable<Chunk>& getLoadedChunks() const;
 
     void forceLoadAllChunks();
     bool isChunkLoaded(ChunkCoords::repr coords) const;
     void loadChunk(Chunk&& chunk);
     Chunk& accessChunk(ChunkCoords::repr coords);
+    // Similar to `accessChunk()`, but returns nullptr instead of allocating a new chunk if it doesn't exist.
+    Chunk* findChunk(ChunkCoords::repr coords);
+    // Similar to `findChunk()`, but only returns chunks that are already loaded.
+    Chunk* findLoadedChunk(ChunkCoords::repr coords);
+    // Drops a chunk that isn't visible if the file storage can load it again later (see
+    // `FileStorage::unloadChunk()`). Any pointer to the chunk is invalid after this returns true. While a sim thread
+    // is attached, this must only be called with the thread paused.
+    bool unloadChunk(ChunkCoords::repr coords);
     Tile accessTile(int x, int y);
     Tile accessTile(const sf::Vector2i& pos);
     void removeAllHighlights();
@@ -65,6 +87,14 @@ public:
      * returned lower bound will be greater than the upper bound.
      */
     std::pair<sf::Vector2i, sf::Vector2i> getHighlightedBounds();
+    void addTileChangeListener(TileChangeListener* listener);
+    void removeTileChangeListener(TileChangeListener* listener);
+    // Should be called after a tile is edited (to let the simulation know about the change).
+    void notifyTileChanged(const sf::Vector2i& pos, TileChange::t change);
+    // Attaches the thread running the simulation (or detaches with nullptr), this is done by the thread itself.
+    void setSimThread(sim::SimThread* simThread);
+    // Copies the chunks edited since the last call into their state snapshots. Only called while the thread is paused.
+    void refreshStateSnapshots();
     void newBoard(const sf::Vector2u& size = {64, 64});
     bool loadFromFile(const fs::path& filename);
     bool saveToFile();
@@ -75,6 +105,8 @@ public:
         chunks_.at(i).debugPrintChunk();
     }
     void debugSetDrawChunkBorder(bool enabled);
+    // Shades chunks by how busy they are in the simulation (from 0 to 1), drawn along with the chunk borders.
+    void debugSetChunkHeat(const std::vector<std::pair<ChunkCoords::repr, float>>& chunkHeat);
     unsigned int debugGetChunksDrawn() const;
 
 private:
@@ -86,7 +118,11 @@ private:
     static StaticInit* staticInit_;
 
     void clearChunks();
+    void notifyBoardReloaded();
+    void notifyChunkLoaded(ChunkCoords::repr coords);
     void pruneChunkDrawables();
+    void setChunkDrawable(ChunkCoords::repr coords, const Chunk* chunk);
+    void applyStateSnapshot();
     void updateRender();
     virtual void markChunkDrawDirty(ChunkCoords::repr coords) override;
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
@@ -96,7 +132,7 @@ private:
     sf::Vector2u maxSize_;
     bool extraLogicStates_;
     sf::Text notesText_;
-    std::unordered_map<ChunkCoords::repr, Chunk> chunks_;
+    ChunkTable<Chunk> chunks_;
     std::unique_ptr<Chunk> emptyChunk_;
     FlatMap<ChunkCoords::repr, ChunkDrawable> chunkDrawables_;
     std::array<ChunkRender, LodRenderer::LEVELS_OF_DETAIL> chunkRenderCache_;
@@ -104,4 +140,9 @@ private:
     ChunkCoords::repr lastTopLeft_;
     mutable sf::VertexArray debugChunkBorder_;
     bool debugDrawChunkBorder_;
+    std::vector<std::pair<ChunkCoords::repr, float>> debugChunkHeat_;
+    mutable sf::VertexArray debugChunkHeatmap_;
+    std::vector<TileChangeListener*> tileChangeListeners_;
+    sim::SimThread* simThread_;
+    std::vector<ChunkCoords::repr> staleSnapshotChunks_;
 };
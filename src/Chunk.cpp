@@ -214,6 +214,10 @@ void Chunk::markAsSaved() const {
     dirtyFlags_.reset(ChunkDirtyFlag::unsaved);
 }
 
+void Chunk::markAsUnsaved() const {
+    dirtyFlags_.set(ChunkDirtyFlag::unsaved);
+}
+
 void Chunk::markAsDrawn() const {
     dirtyFlags_.reset(ChunkDirtyFlag::drawPending);
 }
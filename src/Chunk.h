@@ -88,6 +88,7 @@ public:
     uint32_t serialize(std::ostream& out) const;
     void deserialize(std::istream& in);
     void markAsSaved() const;
+    void markAsUnsaved() const;
     void markAsDrawn() const;
     void debugPrintChunk() const;
 
@@ -114,6 +115,7 @@ private:
     void freeEntity(unsigned int tileIndex);
 
     friend class ChunkDrawable;
+    friend class Simulator;
     friend class TileType;
 
     // For simplicity, equality requires that any entities have the same ordering in the entity array for both chunks.
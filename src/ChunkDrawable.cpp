@@ -6,6 +6,7 @@
 #include <Tile.h>
 #include <TileWidth.h>
 
+#include <algorithm>
 #include <cassert>
 
 // Disable a false-positive warning issue with gcc:
@@ -84,6 +85,7 @@ ChunkDrawable::StaticInit::StaticInit() {
 
 ChunkDrawable::ChunkDrawable() :
     chunk_(nullptr),
+    snapshot_(),
     vertices_(sf::Triangles),
     renderIndices_(),
     renderIndicesSum_(-LodRenderer::LEVELS_OF_DETAIL),
@@ -102,6 +104,8 @@ void ChunkDrawable::setChunk(const Chunk* chunk) {
         vertices_.clear();
 
         // FIXME what happens if a chunk unloads, then ChunkRender needs to draw it again or it shows up on screen?
+    } else if (snapshot_ != nullptr) {
+        updateSnapshot();
     } else {
         renderDirty_.set();
     }
@@ -126,6 +130,30 @@ bool ChunkDrawable::hasAnyRenderIndex() const {
     return renderIndicesSum_ != -LodRenderer::LEVELS_OF_DETAIL;
 }
 
+void ChunkDrawable::setSnapshotEnabled(bool enabled) {
+    if (!enabled) {
+        snapshot_.reset();
+    } else if (snapshot_ == nullptr) {
+        snapshot_.reset(new TileData[Chunk::WIDTH * Chunk::WIDTH]);
+        if (chunk_ != nullptr) {
+            updateSnapshot();
+        }
+    }
+}
+
+bool ChunkDrawable::isSnapshotEnabled() const {
+    return snapshot_ != nullptr;
+}
+
+void ChunkDrawable::updateSnapshot(const TileData* tiles) {
+    assert(snapshot_ != nullptr);
+    if (tiles == nullptr) {
+        tiles = chunk_->tiles_;
+    }
+    std::copy(tiles, tiles + Chunk::WIDTH * Chunk::WIDTH, snapshot_.get());
+    renderDirty_.set();
+}
+
 void ChunkDrawable::markDirty() {
     renderDirty_.set();
 }
@@ -139,9 +167,13 @@ void ChunkDrawable::markAsDrawn(int levelOfDetail) const {
     chunk_->markAsDrawn();
 }
 
+const TileData* ChunkDrawable::getTiles() const {
+    return (snapshot_ != nullptr ? snapshot_.get() : chunk_->tiles_);
+}
+
 void ChunkDrawable::updateTileGeometry(unsigned int tileIndex) const {
     sf::Vertex* tileVertices = &vertices_[tileIndex * 6];
-    TileData tileData = chunk_->tiles_[tileIndex];
+    TileData tileData = getTiles()[tileIndex];
 
     unsigned int textureId = staticInit_->textureLookup[tileData.getTextureHash()] + (tileData.highlight ? staticInit_->textureHighlightStart : 0);
 
@@ -196,8 +228,9 @@ void ChunkDrawable::draw(sf::RenderTarget& target, sf::RenderStates states) cons
     target.draw(vertices_, states);
 
     // Second pass for drawing labels on switches and buttons.
+    const TileData* tiles = getTiles();
     for (unsigned int tileIndex = 0; tileIndex < Chunk::WIDTH * Chunk::WIDTH; ++tileIndex) {
-        TileData tileData = chunk_->tiles_[tileIndex];
+        TileData tileData = tiles[tileIndex];
         if (tileData.id == TileId::inSwitch || tileData.id == TileId::inButton) {
             // Use a simple hash operation to look up entry in label cache;
             auto& label = staticInit_->labelCache[tileData.meta % staticInit_->labelCache.size()];
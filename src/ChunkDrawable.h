@@ -4,9 +4,11 @@
 
 #include <array>
 #include <bitset>
+#include <memory>
 #include <SFML/Graphics.hpp>
 
 class Chunk;
+struct TileData;
 
 /**
  * The drawable component of a `Chunk`.
@@ -15,6 +17,9 @@ class Chunk;
  * more suitable to store in a cache-friendly data structure (such as a
  * `FlatMap`). The render index functions refer to the index of a `RenderBlock`
  * within a `ChunkRender` for each level-of-detail.
+ *
+ * When the simulation runs on another thread, the drawable keeps its own copy
+ * of the tiles (the state snapshot) and draws from that instead of the chunk.
  */
 class ChunkDrawable : public sf::Drawable {
 public:
@@ -30,6 +35,11 @@ public:
     void setRenderIndex(int levelOfDetail, int renderIndex);
     int getRenderIndex(int levelOfDetail) const;
     bool hasAnyRenderIndex() const;
+    // Enabling the snapshot copies the current tiles from the chunk.
+    void setSnapshotEnabled(bool enabled);
+    bool isSnapshotEnabled() const;
+    // Copies the tiles from the chunk, or from `tiles` if given, into the snapshot and marks it dirty.
+    void updateSnapshot(const TileData* tiles = nullptr);
     void markDirty();
     bool isRenderDirty(int levelOfDetail) const;
     void markAsDrawn(int levelOfDetail) const;
@@ -44,10 +54,12 @@ private:
     };
     static StaticInit* staticInit_;
 
+    const TileData* getTiles() const;
     void updateTileGeometry(unsigned int tileIndex) const;
     virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
 
     const Chunk* chunk_;
+    std::unique_ptr<TileData[]> snapshot_;
     mutable sf::VertexArray vertices_;
     std::array<int, LodRenderer::LEVELS_OF_DETAIL> renderIndices_;
     int renderIndicesSum_;
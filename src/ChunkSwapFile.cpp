@@ -0,0 +1,225 @@
+#include <ChunkSwapFile.h>
+
+#include <spdlog/fmt/ranges.h>
+#include <spdlog/spdlog.h>
+#include <system_error>
+#include <utility>
+
+ChunkSwapFile::ChunkSwapFile() :
+    mutex_(),
+    fileMutex_(),
+    condition_(),
+    pendingChunks_(),
+    writingCoords_(0),
+    writing_(false),
+    writeQueue_(),
+    records_(),
+    storedCount_(0),
+    filename_(),
+    file_(),
+    fileSize_(0),
+    stopping_(false),
+    writeFailed_(false),
+    thread_() {
+}
+
+ChunkSwapFile::~ChunkSwapFile() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (!filename_.empty()) {
+        file_.close();
+        std::error_code ec;
+        fs::remove(filename_, ec);
+    }
+}
+
+void ChunkSwapFile::store(Chunk&& chunk) {
+    const ChunkCoords::repr coords = chunk.getCoords();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto record = records_.find(coords);
+        if (record != records_.end() && record->second.stored) {
+            record->second.stored = false;
+            --storedCount_;
+        }
+        pendingChunks_.erase(coords);
+        pendingChunks_.emplace(coords, std::move(chunk));
+        writeQueue_.push_back(coords);
+        if (!thread_.joinable()) {
+            thread_ = std::thread(&ChunkSwapFile::writerLoop, this);
+        }
+    }
+    condition_.notify_all();
+}
+
+bool ChunkSwapFile::take(ChunkCoords::repr coords, Chunk& chunk) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this,coords]() {
+        return !isWriting(coords);
+    });
+    auto pending = pendingChunks_.find(coords);
+    if (pending != pendingChunks_.end()) {
+        // The write hasn't happened yet (any entry left in the queue gets skipped).
+        chunk = std::move(pending->second);
+        pendingChunks_.erase(pending);
+        return true;
+    }
+    auto record = records_.find(coords);
+    if (record == records_.end() || !record->second.stored) {
+        return false;
+    }
+    record->second.stored = false;
+    --storedCount_;
+    const Record stored = record->second;
+    lock.unlock();
+
+    // Nothing else writes to this spot until the chunk is stored again, so the read doesn't need the main lock.
+    if (stored.length > 0) {
+        std::lock_guard<std::mutex> fileLock(fileMutex_);
+        file_.seekg(stored.offset, std::ios::beg);
+        chunk.deserialize(file_);
+        if (!file_) {
+            spdlog::error("Failed to read chunk {} from swap file {}.", ChunkCoords::toPair(coords), filename_);
+            file_.clear();
+        }
+    }
+    return true;
+}
+
+bool ChunkSwapFile::contains(ChunkCoords::repr coords) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto record = records_.find(coords);
+    return pendingChunks_.count(coords) > 0 || isWriting(coords) || (record != records_.end() && record->second.stored);
+}
+
+size_t ChunkSwapFile::getStoredCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pendingChunks_.size() + storedCount_ + (isWriting(writingCoords_) ? 1 : 0);
+}
+
+std::vector<ChunkCoords::repr> ChunkSwapFile::getStoredCoords() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ChunkCoords::repr> storedCoords;
+    storedCoords.reserve(pendingChunks_.size() + storedCount_ + 1);
+    for (const auto& pending : pendingChunks_) {
+        storedCoords.push_back(pending.first);
+    }
+    if (isWriting(writingCoords_)) {
+        storedCoords.push_back(writingCoords_);
+    }
+    for (const auto& record : records_) {
+        if (record.second.stored) {
+            storedCoords.push_back(record.first);
+        }
+    }
+    return storedCoords;
+}
+
+void ChunkSwapFile::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() {
+        return (writeQueue_.empty() && !writing_) || writeFailed_;
+    });
+}
+
+void ChunkSwapFile::clear() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    // The record of a chunk being written gets filled in once the write is done, so wait for that first.
+    condition_.wait(lock, [this]() {
+        return !writing_;
+    });
+    pendingChunks_.clear();
+    writeQueue_.clear();
+    records_.clear();
+    storedCount_ = 0;
+    fileSize_ = 0;
+    writeFailed_ = false;
+}
+
+void ChunkSwapFile::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        condition_.wait(lock, [this]() {
+            return stopping_ || (!writeQueue_.empty() && !writeFailed_);
+        });
+        if (stopping_) {
+            return;
+        }
+        const ChunkCoords::repr coords = writeQueue_.front();
+        writeQueue_.pop_front();
+        auto pending = pendingChunks_.find(coords);
+        if (pending == pendingChunks_.end()) {
+            condition_.notify_all();
+            continue;
+        }
+
+        // The chunk moves out for the write and the lock is released, so storing other chunks doesn't wait on the
+        // disk. The spot in the file is picked first since it depends on the other records.
+        Chunk chunk(std::move(pending->second));
+        pendingChunks_.erase(pending);
+        writingCoords_ = coords;
+        writing_ = true;
+        auto& record = records_.emplace(coords, Record{0, 0, 0, false}).first->second;
+        const uint32_t length = chunk.serializeLength();
+        if (length > record.capacity) {
+            record.offset = fileSize_;
+            record.capacity = length;
+            fileSize_ += length;
+        }
+        const uint64_t offset = record.offset;
+        lock.unlock();
+
+        uint32_t writtenLength = 0;
+        const bool written = writeChunk(chunk, offset, writtenLength);
+
+        lock.lock();
+        writing_ = false;
+        if (!written) {
+            writeFailed_ = true;
+            // The chunk stays in memory, unless a newer copy was stored during the write.
+            pendingChunks_.emplace(coords, std::move(chunk));
+        } else if (pendingChunks_.count(coords) == 0) {
+            auto& writtenRecord = records_[coords];
+            writtenRecord.length = writtenLength;
+            writtenRecord.stored = true;
+            ++storedCount_;
+        }
+        condition_.notify_all();
+    }
+}
+
+bool ChunkSwapFile::writeChunk(const Chunk& chunk, uint64_t offset, uint32_t& length) {
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    if (filename_.empty()) {
+        try {
+            filename_ = details::fs_mktemp(false, "cs2_swap.XXXXXXXXXX");
+        } catch (fs::filesystem_error& ex) {
+            spdlog::error("Unable to create swap file, unloaded chunks stay in memory: {}", ex.what());
+            return false;
+        }
+        file_.open(filename_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    }
+    if (!file_.is_open()) {
+        spdlog::error("Unable to open swap file {}, unloaded chunks stay in memory.", filename_);
+        return false;
+    }
+
+    file_.seekp(offset, std::ios::beg);
+    length = chunk.serialize(file_);
+    if (!file_) {
+        spdlog::error("File I/O error while writing swap file {}, unloaded chunks stay in memory.", filename_);
+        file_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool ChunkSwapFile::isWriting(ChunkCoords::repr coords) const {
+    return writing_ && writingCoords_ == coords && pendingChunks_.count(coords) == 0;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <Chunk.h>
+#include <ChunkCoords.h>
+#include <Filesystem.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Temporary file for chunks that get unloaded with unsaved changes, so a board
+ * that doesn't fit in memory can still be simulated without saving edits into
+ * the user's files behind their back.
+ *
+ * Chunks are handed over with `store()` and written out by a background
+ * thread, the caller never waits on the disk. Until the write starts the chunk
+ * stays in memory and `take()` gives it straight back, a `take()` during the
+ * write of that chunk waits for it to finish. Each chunk keeps its spot in the
+ * file, and gets written to the same spot next time if it still fits.
+ *
+ * The file is created on the first write and removed again in the destructor.
+ * If the file can't be written then chunks just stay in memory.
+ */
+class ChunkSwapFile {
+public:
+    ChunkSwapFile();
+    ~ChunkSwapFile();
+    ChunkSwapFile(const ChunkSwapFile& rhs) = delete;
+    ChunkSwapFile& operator=(const ChunkSwapFile& rhs) = delete;
+
+    // Takes ownership of the chunk, it gets written out in the background.
+    void store(Chunk&& chunk);
+    // Moves a stored chunk back into `chunk` (which should be newly constructed). Returns false if it wasn't stored.
+    bool take(ChunkCoords::repr coords, Chunk& chunk);
+    bool contains(ChunkCoords::repr coords) const;
+    size_t getStoredCount() const;
+    std::vector<ChunkCoords::repr> getStoredCoords() const;
+    // Blocks until the chunks handed over so far have been written.
+    void flush();
+    // Drops all stored chunks, the file is kept around to reuse.
+    void clear();
+
+private:
+    struct Record {
+        uint64_t offset;
+        uint32_t capacity, length;
+        bool stored;
+    };
+
+    void writerLoop();
+    // Writes the chunk at `offset`, this only locks `fileMutex_`. Returns false if the write failed.
+    bool writeChunk(const Chunk& chunk, uint64_t offset, uint32_t& length);
+    // True if the only copy of the chunk is the one being written.
+    bool isWriting(ChunkCoords::repr coords) const;
+
+    // The `mutex_` guards everything but the file, which has its own lock so that the other calls don't wait on
+    // the disk. Both are only held together in that order.
+    mutable std::mutex mutex_;
+    std::mutex fileMutex_;
+    std::condition_variable condition_;
+    std::unordered_map<ChunkCoords::repr, Chunk> pendingChunks_;
+    ChunkCoords::repr writingCoords_;
+    bool writing_;
+    std::deque<ChunkCoords::repr> writeQueue_;
+    std::unordered_map<ChunkCoords::repr, Record> records_;
+    size_t storedCount_;
+    fs::path filename_;
+    fs::fstream file_;
+    uint64_t fileSize_;
+    bool stopping_, writeFailed_;
+    std::thread thread_;
+};
@@ -0,0 +1,349 @@
+#pragma once
+
+#include <ChunkCoords.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Hash map keyed by chunk coordinates, for the chunks loaded in a `Board` or
+ * `SubBoard`.
+ *
+ * The values live in a slab made of fixed-size blocks, and the hash table only
+ * stores the key and slab index for each entry (open addressing with linear
+ * probing). A lookup reads a bucket and then goes straight to the value, there
+ * is no node to chase like in `std::unordered_map`. Values never move once
+ * they are added, growing the table or the slab (or moving the whole map)
+ * leaves references to them valid until they are erased. This is required for
+ * chunks, since a `ChunkDrawable` keeps a raw pointer to its chunk.
+ *
+ * Iteration goes in slab order, erased slots in the slab get reused by the
+ * next insert.
+ */
+template<typename T>
+class ChunkTable {
+public:
+    using key_type = ChunkCoords::repr;
+    using mapped_type = T;
+    using value_type = std::pair<const key_type, T>;
+    using size_type = size_t;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+    template<bool IsConst>
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ChunkTable::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = typename std::conditional<IsConst, const value_type*, value_type*>::type;
+        using reference = typename std::conditional<IsConst, const value_type&, value_type&>::type;
+
+        Iterator() :
+            table_(nullptr),
+            index_(0) {
+        }
+        // Also allows an iterator to convert to a const_iterator.
+        Iterator(const Iterator<false>& rhs) :
+            table_(rhs.table_),
+            index_(rhs.index_) {
+        }
+
+        reference operator*() const {
+            return table_->valueAt(index_);
+        }
+        pointer operator->() const {
+            return &table_->valueAt(index_);
+        }
+        Iterator& operator++() {
+            index_ = table_->nextOccupied(index_ + 1);
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator last = *this;
+            ++*this;
+            return last;
+        }
+
+        friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+            return lhs.index_ == rhs.index_ && lhs.table_ == rhs.table_;
+        }
+        friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+            return !(lhs == rhs);
+        }
+
+    private:
+        using TableType = typename std::conditional<IsConst, const ChunkTable, ChunkTable>::type;
+
+        Iterator(TableType* table, uint32_t index) :
+            table_(table),
+            index_(index) {
+        }
+
+        TableType* table_;
+        uint32_t index_;
+
+        friend class ChunkTable;
+        friend class Iterator<!IsConst>;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    ChunkTable() :
+        blocks_(),
+        occupied_(),
+        freeIndices_(),
+        buckets_(),
+        size_(0) {
+    }
+    ~ChunkTable() {
+        clear();
+    }
+    ChunkTable(const ChunkTable& rhs) = delete;
+    ChunkTable& operator=(const ChunkTable& rhs) = delete;
+    // The blocks of the slab move over as they are, so references to the values stay valid.
+    ChunkTable(ChunkTable&& rhs) noexcept :
+        ChunkTable() {
+        swap(rhs);
+    }
+    ChunkTable& operator=(ChunkTable&& rhs) noexcept {
+        clear();
+        swap(rhs);
+        return *this;
+    }
+
+    T& at(key_type key) {
+        auto val = find(key);
+        if (val == end()) {
+            throw std::out_of_range("ChunkTable::at");
+        }
+        return val->second;
+    }
+    const T& at(key_type key) const {
+        auto val = find(key);
+        if (val == end()) {
+            throw std::out_of_range("ChunkTable::at");
+        }
+        return val->second;
+    }
+
+    iterator begin() noexcept {
+        return iterator(this, nextOccupied(0));
+    }
+    const_iterator begin() const noexcept {
+        return const_iterator(this, nextOccupied(0));
+    }
+    const_iterator cbegin() const noexcept {
+        return begin();
+    }
+    iterator end() noexcept {
+        return iterator(this, static_cast<uint32_t>(occupied_.size()));
+    }
+    const_iterator end() const noexcept {
+        return const_iterator(this, static_cast<uint32_t>(occupied_.size()));
+    }
+    const_iterator cend() const noexcept {
+        return end();
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+    size_type size() const noexcept {
+        return size_;
+    }
+
+    void clear() noexcept {
+        for (uint32_t i = 0; i < occupied_.size(); ++i) {
+            if (occupied_[i]) {
+                valueAt(i).~value_type();
+            }
+        }
+        blocks_.clear();
+        occupied_.clear();
+        freeIndices_.clear();
+        buckets_.clear();
+        size_ = 0;
+    }
+    // Constructs the value from `args` only if there is no value for the key yet.
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(key_type key, Args&&... args) {
+        size_t bucket = findBucket(key);
+        if (bucket != NOT_FOUND) {
+            return {iterator(this, buckets_[bucket].index), false};
+        }
+        if ((size_ + 1) * MAX_LOAD_DENOMINATOR > buckets_.size() * MAX_LOAD_NUMERATOR) {
+            rehash(std::max(buckets_.size() * 2, MIN_BUCKETS));
+        }
+        const uint32_t index = allocateIndex();
+        try {
+            new (&valueAt(index)) value_type(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+        } catch (...) {
+            freeIndices_.push_back(index);
+            throw;
+        }
+        occupied_[index] = 1;
+        insertBucket(key, index);
+        ++size_;
+        return {iterator(this, index), true};
+    }
+    iterator erase(const_iterator pos) {
+        const uint32_t index = pos.index_;
+        eraseBucket(findBucket(valueAt(index).first));
+        valueAt(index).~value_type();
+        occupied_[index] = 0;
+        freeIndices_.push_back(index);
+        --size_;
+        return iterator(this, nextOccupied(index + 1));
+    }
+    size_type erase(key_type key) {
+        auto val = find(key);
+        if (val == end()) {
+            return 0;
+        }
+        erase(val);
+        return 1;
+    }
+    void swap(ChunkTable& other) noexcept {
+        std::swap(blocks_, other.blocks_);
+        std::swap(occupied_, other.occupied_);
+        std::swap(freeIndices_, other.freeIndices_);
+        std::swap(buckets_, other.buckets_);
+        std::swap(size_, other.size_);
+    }
+
+    size_type count(key_type key) const {
+        return (findBucket(key) == NOT_FOUND ? 0 : 1);
+    }
+    iterator find(key_type key) {
+        const size_t bucket = findBucket(key);
+        return (bucket == NOT_FOUND ? end() : iterator(this, buckets_[bucket].index));
+    }
+    const_iterator find(key_type key) const {
+        const size_t bucket = findBucket(key);
+        return (bucket == NOT_FOUND ? end() : const_iterator(this, buckets_[bucket].index));
+    }
+    size_type bucket_count() const noexcept {
+        return buckets_.size();
+    }
+
+private:
+    static constexpr uint32_t BLOCK_SIZE = 16;
+    static constexpr uint32_t EMPTY_INDEX = UINT32_MAX;
+    static constexpr size_t NOT_FOUND = SIZE_MAX;
+    static constexpr size_t MIN_BUCKETS = 16;
+    // The table grows once it would be more than 3/4 full.
+    static constexpr size_t MAX_LOAD_NUMERATOR = 3;
+    static constexpr size_t MAX_LOAD_DENOMINATOR = 4;
+
+    struct Block {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type values[BLOCK_SIZE];
+    };
+    struct Bucket {
+        key_type key;
+        uint32_t index;
+    };
+
+    // Fibonacci hashing, the multiply spreads the x and y halves of the key over the upper bits.
+    static size_t hashKey(key_type key) {
+        return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> 32);
+    }
+
+    value_type& valueAt(uint32_t index) {
+        return *reinterpret_cast<value_type*>(&blocks_[index / BLOCK_SIZE]->values[index % BLOCK_SIZE]);
+    }
+    const value_type& valueAt(uint32_t index) const {
+        return *reinterpret_cast<const value_type*>(&blocks_[index / BLOCK_SIZE]->values[index % BLOCK_SIZE]);
+    }
+    uint32_t nextOccupied(uint32_t index) const {
+        while (index < occupied_.size() && !occupied_[index]) {
+            ++index;
+        }
+        return index;
+    }
+    uint32_t allocateIndex() {
+        if (!freeIndices_.empty()) {
+            const uint32_t index = freeIndices_.back();
+            freeIndices_.pop_back();
+            return index;
+        }
+        const uint32_t index = static_cast<uint32_t>(occupied_.size());
+        if (index % BLOCK_SIZE == 0) {
+            blocks_.emplace_back(new Block);
+        }
+        occupied_.push_back(0);
+        return index;
+    }
+    size_t findBucket(key_type key) const {
+        if (buckets_.empty()) {
+            return NOT_FOUND;
+        }
+        const size_t mask = buckets_.size() - 1;
+        for (size_t i = hashKey(key) & mask; buckets_[i].index != EMPTY_INDEX; i = (i + 1) & mask) {
+            if (buckets_[i].key == key) {
+                return i;
+            }
+        }
+        return NOT_FOUND;
+    }
+    void insertBucket(key_type key, uint32_t index) {
+        const size_t mask = buckets_.size() - 1;
+        size_t i = hashKey(key) & mask;
+        while (buckets_[i].index != EMPTY_INDEX) {
+            i = (i + 1) & mask;
+        }
+        buckets_[i] = {key, index};
+    }
+    // Removes the bucket by shifting back the entries after it (instead of leaving a tombstone), so that lookups
+    // don't slow down over time as chunks load and unload.
+    void eraseBucket(size_t bucket) {
+        const size_t mask = buckets_.size() - 1;
+        size_t hole = bucket;
+        for (size_t i = (hole + 1) & mask; buckets_[i].index != EMPTY_INDEX; i = (i + 1) & mask) {
+            // The entry can fill the hole if the hole is between its home bucket and where it is now.
+            const size_t home = hashKey(buckets_[i].key) & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                buckets_[hole] = buckets_[i];
+                hole = i;
+            }
+        }
+        buckets_[hole].index = EMPTY_INDEX;
+    }
+    void rehash(size_t bucketCount) {
+        std::vector<Bucket> oldBuckets(bucketCount, Bucket{0, EMPTY_INDEX});
+        oldBuckets.swap(buckets_);
+        for (const auto& bucket : oldBuckets) {
+            if (bucket.index != EMPTY_INDEX) {
+                insertBucket(bucket.key, bucket.index);
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Block>> blocks_;
+    std::vector<uint8_t> occupied_;
+    std::vector<uint32_t> freeIndices_;
+    std::vector<Bucket> buckets_;
+    size_type size_;
+};
+
+template<typename T>
+constexpr uint32_t ChunkTable<T>::BLOCK_SIZE;
+template<typename T>
+constexpr uint32_t ChunkTable<T>::EMPTY_INDEX;
+template<typename T>
+constexpr size_t ChunkTable<T>::NOT_FOUND;
+template<typename T>
+constexpr size_t ChunkTable<T>::MIN_BUCKETS;
+template<typename T>
+constexpr size_t ChunkTable<T>::MAX_LOAD_NUMERATOR;
+template<typename T>
+constexpr size_t ChunkTable<T>::MAX_LOAD_DENOMINATOR;
@@ -101,6 +101,12 @@ Editor::StaticInit::StaticInit() {
 Editor::Editor(Board& board, sf::RenderWindow& window, MessageLogSinkMt* messageLogSink) :
     interface_(*this, window, messageLogSink),
     board_(board),
+    simulator_(board),
+    simThread_(board, simulator_),
+    warpTickCount_(1000000),
+    warpRunning_(false),
+    warpClock_(),
+    chunkProfileClock_(),
     workingDirectory_(fs::current_path()),
     editView_(static_cast<float>(TileWidth::TEXELS * Chunk::WIDTH)),
     zoomLevel_(1.0f),
@@ -174,6 +180,27 @@ size_t Editor::getMaxEditHistory() const {
     return maxEditHistory_;
 }
 
+void Editor::setMaxResidentChunks(size_t maxResidentChunks) {
+    sim::SimThread::PauseGuard pauseGuard(simThread_);
+    simulator_.setMaxResidentChunks(maxResidentChunks);
+}
+
+size_t Editor::getMaxResidentChunks() const {
+    return simulator_.getMaxResidentChunks();
+}
+
+void Editor::setWarpTickCount(uint64_t warpTickCount) {
+    warpTickCount_ = warpTickCount;
+}
+
+uint64_t Editor::getWarpTickCount() const {
+    return warpTickCount_;
+}
+
+uint64_t Editor::getTickCount() const {
+    return simThread_.getTickCount();
+}
+
 bool Editor::isEditUnsaved() const {
     return lastEditSize_ != savedEditSize_;
 }
@@ -192,6 +219,7 @@ void Editor::windowCloseRequested(const std::function<void()>& action) {
 }
 
 bool Editor::processEvent(const sf::Event& event) {
+    sim::SimThread::PauseGuard pauseGuard(simThread_);
     if (interface_.processEvent(event)) {
         return true;
     }
@@ -290,6 +318,12 @@ bool Editor::processEvent(const sf::Event& event) {
 void Editor::update() {
     interface_.update();
     updateCursor();
+    updateChunkProfile();
+    simThread_.updateChunks();
+    if (warpRunning_ && simThread_.getWarpTicksLeft() == 0) {
+        warpRunning_ = false;
+        spdlog::info("Warped {} ticks in {}ms (now at tick {}).", warpTickCount_, warpClock_.getElapsedTime().asMilliseconds(), simThread_.getTickCount());
+    }
 
     if (cursorState_ == CursorState::pickTile) {
         tileSubBoard_.setRenderArea(editView_, zoomLevel_, cursorCoords_.first);
@@ -317,6 +351,11 @@ bool Editor::handleTextEntered(uint32_t unicode) {
     // consumed events are dealt with correctly. If an event generates a
     // printable character, handle it here and not in handleKeyPressed().
 
+    // Alt+Key presses inputs instead, some platforms still send the text for it.
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::LAlt) || sf::Keyboard::isKeyPressed(sf::Keyboard::RAlt)) {
+        return false;
+    }
+
     unsigned char key = '\0';
     bool keyShift = false;
     if (unicode <= std::numeric_limits<unsigned char>::max()) {
@@ -407,16 +446,38 @@ bool Editor::handleKeyPressed(const sf::Event::KeyEvent& key) {
             pasteArea();
         } else if (key.code == sf::Keyboard::M) {
             interface_.toggleMessageLog();
+        } else if (key.code == sf::Keyboard::Tab) {
+            warpTicks();
         } else {
             return false;
         }
         return true;
     }
 
+    if (key.alt) {
+        // Presses the inputs with the keycode of the key (inputs use lowercase keycodes unless shift is held).
+        char keycode;
+        if (key.code >= sf::Keyboard::A && key.code <= sf::Keyboard::Z) {
+            keycode = static_cast<char>((key.shift ? 'A' : 'a') + (key.code - sf::Keyboard::A));
+        } else if (key.code >= sf::Keyboard::Num0 && key.code <= sf::Keyboard::Num9) {
+            keycode = static_cast<char>('0' + (key.code - sf::Keyboard::Num0));
+        } else if (key.code >= sf::Keyboard::Numpad0 && key.code <= sf::Keyboard::Numpad9) {
+            keycode = static_cast<char>('0' + (key.code - sf::Keyboard::Numpad0));
+        } else {
+            return false;
+        }
+        simulator_.pressKey(keycode);
+        return true;
+    }
+
     if (key.code == sf::Keyboard::Enter) {
         //viewOption(0);
     } else if (key.code == sf::Keyboard::Tab) {
-        //runOption(!key.shift);
+        if (!key.shift) {
+            stepOneTick();
+        } else {
+            changeMaxTps();
+        }
     } else if (key.code == sf::Keyboard::Escape) {
         deselectAll();
     } else if (key.code == sf::Keyboard::Delete) {
@@ -738,6 +799,102 @@ void Editor::defaultZoom() {
     editView_.setCenterOffset(0, 0);
     zoomLevel_ = 1.0f;
 }
+void Editor::stepOneTick() {
+    simThread_.setMaxTps(0);
+    simulator_.tick();
+}
+void Editor::changeMaxTps() {
+    // Cycles through paused, slow, medium, fast, and unlimited (same as the legacy version).
+    const unsigned int maxTpsLevels[] = {0, 2, 30, 60, sim::SimThread::UNLIMITED_TPS};
+    constexpr size_t numLevels = sizeof(maxTpsLevels) / sizeof(maxTpsLevels[0]);
+    size_t level = 0;
+    while (level < numLevels && maxTpsLevels[level] != simThread_.getMaxTps()) {
+        ++level;
+    }
+    const unsigned int maxTps = maxTpsLevels[(level + 1) % numLevels];
+
+    // The thread gets started the first time it's needed.
+    if (!simThread_.isRunning()) {
+        simThread_.start();
+    }
+    simThread_.setMaxTps(maxTps);
+    if (maxTps == 0) {
+        spdlog::info("Max TPS set to paused.");
+    } else if (maxTps == sim::SimThread::UNLIMITED_TPS) {
+        spdlog::info("Max TPS set to unlimited.");
+    } else {
+        spdlog::info("Max TPS set to {}.", maxTps);
+    }
+}
+void Editor::warpTicks() {
+    // The warp runs on the simulation thread so the window keeps drawing (and shows the progress). Warping again
+    // before it finishes cancels it.
+    if (warpRunning_) {
+        simThread_.warp(0);
+        warpRunning_ = false;
+        spdlog::info("Warp cancelled at tick {}.", simThread_.getTickCount());
+        return;
+    }
+    if (!simThread_.isRunning()) {
+        simThread_.start();
+    }
+    simThread_.warp(warpTickCount_);
+    warpRunning_ = true;
+    warpClock_.restart();
+    spdlog::info("Warping {} ticks from tick {}.", warpTickCount_, simThread_.getTickCount());
+}
+void Editor::recordInputs() {
+    if (simulator_.getInputMode() != Simulator::InputMode::record) {
+        simulator_.setInputMode(Simulator::InputMode::record);
+        spdlog::info("Recording inputs from tick {}.", simulator_.getTickCount());
+        return;
+    }
+    simulator_.setInputMode(Simulator::InputMode::none);
+    spdlog::info("Stopped recording inputs, {} key presses.", simulator_.accessInputLog().size());
+
+    fs::path saveFilename = fs::path(board_.getFilename()).replace_extension(".inputs.txt");
+    if (pfd::settings::available()) {
+        saveFilename = pfd::save_file("Save Inputs", saveFilename.string(), {
+            "Plain Text (*.txt)", "*.txt",
+            "All Files (*.*)", "*"
+        }, pfd::opt::none).result();
+    } else {
+        spdlog::warn("Portable File Dialogs is not available on this platform (or a component is missing). Saving next to the board.");
+    }
+    if (saveFilename.empty()) {
+        spdlog::info("No file selected.");
+        return;
+    }
+    spdlog::info("Saving inputs to \"{}\"...", saveFilename);
+    fs::ofstream inputFile(saveFilename);
+    if (!simulator_.accessInputLog().save(inputFile)) {
+        spdlog::error("Failed to save inputs.");
+    }
+}
+void Editor::replayInputs() {
+    fs::path openFilename = fs::path(board_.getFilename()).replace_extension(".inputs.txt");
+    if (pfd::settings::available()) {
+        auto openResult = pfd::open_file("Replay Inputs", openFilename.string(), {
+            "Plain Text (*.txt)", "*.txt",
+            "All Files (*.*)", "*"
+        }, pfd::opt::none).result();
+        openFilename = (!openResult.empty() ? fs::path(openResult[0]) : fs::path());
+    } else {
+        spdlog::warn("Portable File Dialogs is not available on this platform (or a component is missing). Loading from next to the board.");
+    }
+    if (openFilename.empty()) {
+        spdlog::info("No file selected.");
+        return;
+    }
+    fs::ifstream inputFile(openFilename);
+    if (!inputFile.is_open() || !simulator_.accessInputLog().load(inputFile)) {
+        spdlog::error("Failed to load inputs from \"{}\".", openFilename);
+        return;
+    }
+    // The replay only matches the recording if it starts from the same board state (like right after opening it).
+    simulator_.setInputMode(Simulator::InputMode::replay);
+    spdlog::info("Replaying {} key presses from tick {}.", simulator_.accessInputLog().size(), simulator_.getTickCount());
+}
 void Editor::wireTool() {
     if (cursorState_ != CursorState::wireTool) {
         if (!cursorCoords_.second) {
@@ -846,6 +1003,67 @@ void Editor::updateCursor() {
     interface_.setCursorVisible(cursorVisible_);
 }
 
+void Editor::updateChunkProfile() {
+    // The simulation only counts chunk activity while the debug screen is up, the counts are collected about once a
+    // second and shown as a heatmap over the chunks.
+    const bool profiling = DebugScreen::instance()->isVisible();
+    if (profiling != simulator_.getChunkProfiling()) {
+        sim::SimThread::PauseGuard pauseGuard(simThread_);
+        simulator_.setChunkProfiling(profiling);
+        simulator_.clearChunkActivity();
+        chunkProfileClock_.restart();
+        board_.debugSetChunkHeat({});
+        DebugScreen::instance()->getField("chunkActivity").setString("");
+        return;
+    }
+    if (!profiling || chunkProfileClock_.getElapsedTime() < sf::seconds(1.0f)) {
+        return;
+    }
+    std::vector<std::pair<ChunkCoords::repr, Simulator::ChunkActivity>> activity;
+    uint64_t tickCount;
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread_);
+        activity = simulator_.getChunkActivity();
+        tickCount = simulator_.getProfiledTickCount();
+        simulator_.clearChunkActivity();
+    }
+    chunkProfileClock_.restart();
+
+    // The heat is relative to the chunk that took the most time.
+    uint64_t totalNanoseconds = 0;
+    auto hottest = activity.cend();
+    for (auto chunk = activity.cbegin(); chunk != activity.cend(); ++chunk) {
+        totalNanoseconds += chunk->second.nanoseconds;
+        if (hottest == activity.cend() || chunk->second.nanoseconds > hottest->second.nanoseconds) {
+            hottest = chunk;
+        }
+    }
+    std::vector<std::pair<ChunkCoords::repr, float>> chunkHeat;
+    chunkHeat.reserve(activity.size());
+    for (const auto& chunk : activity) {
+        const float heat = (hottest->second.nanoseconds == 0 ? 0.0f : static_cast<float>(chunk.second.nanoseconds) / static_cast<float>(hottest->second.nanoseconds));
+        chunkHeat.emplace_back(chunk.first, heat);
+    }
+    board_.debugSetChunkHeat(chunkHeat);
+
+    if (hottest == activity.cend() || tickCount == 0) {
+        DebugScreen::instance()->getField("chunkActivity").setString("Sim chunks: none active");
+        return;
+    }
+    const double ticks = static_cast<double>(tickCount);
+    DebugScreen::instance()->getField("chunkActivity").setString(fmt::format(
+        "Sim chunks: {} active over {} ticks, hottest ({}, {}) per tick: {:.1f} updates, {:.1f} nets, {:.1f}us ({:.0f}% of time)",
+        activity.size(),
+        tickCount,
+        ChunkCoords::x(hottest->first),
+        ChunkCoords::y(hottest->first),
+        static_cast<double>(hottest->second.updates) / ticks,
+        static_cast<double>(hottest->second.netEvaluations) / ticks,
+        static_cast<double>(hottest->second.nanoseconds) / ticks / 1000.0,
+        (totalNanoseconds == 0 ? 0.0 : 100.0 * static_cast<double>(hottest->second.nanoseconds) / static_cast<double>(totalNanoseconds))
+    ));
+}
+
 void Editor::updateSelection(const sf::Vector2i& newSelectionEnd) {
     if (selectionEnd_ == newSelectionEnd) {
         return;
@@ -949,6 +1167,8 @@ void Editor::updateWireTool(const sf::Vector2i& lastCursorCoords) {
     if (cursorState_ != CursorState::wireTool) {
         return;
     }
+    // Reading the board may load chunks, and `update()` gets here without pausing the simulation.
+    sim::SimThread::PauseGuard pauseGuard(simThread_);
     wireToolLabel_.setString(
         " " + std::to_string(cursorCoords_.first.x - wireToolStart_.x) +
         ", " + std::to_string(cursorCoords_.first.y - wireToolStart_.y) + " "
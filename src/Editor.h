@@ -3,10 +3,13 @@
 #include <EditorInterface.h>
 #include <Filesystem.h>
 #include <OffsetView.h>
+#include <sim/SimThread.h>
+#include <Simulator.h>
 #include <SubBoard.h>
 #include <Tile.h>
 #include <TilePool.h>
 
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <memory>
@@ -33,10 +36,20 @@ public:
     float getZoom() const;
     void setMaxEditHistory(size_t maxEditHistory);
     size_t getMaxEditHistory() const;
+    // Limits the number of chunks the simulation keeps loaded, zero means no limit (see
+    // `Simulator::setMaxResidentChunks()`).
+    void setMaxResidentChunks(size_t maxResidentChunks);
+    size_t getMaxResidentChunks() const;
+    // Sets the number of ticks to run for the warp action.
+    void setWarpTickCount(uint64_t warpTickCount);
+    uint64_t getWarpTickCount() const;
+    // Number of ticks the simulation has run, this is safe to call while the simulation thread is running.
+    uint64_t getTickCount() const;
     bool isEditUnsaved() const;
     void goToTile(int x, int y);
     void windowCloseRequested(const std::function<void()>& action);
-    // Returns true if event was consumed (and should not be processed further).
+    // Returns true if event was consumed (and should not be processed further). The simulation thread is paused
+    // during the event, so any edits can access the board directly.
     bool processEvent(const sf::Event& event);
     void update();
 
@@ -76,6 +89,11 @@ private:
     void toggleEditMode();
     void changeZoom(float zoomDelta);
     void defaultZoom();
+    void stepOneTick();
+    void changeMaxTps();
+    void warpTicks();
+    void recordInputs();
+    void replayInputs();
     void wireTool();
     void queryTool();
     void pickTile(TileId::t id);
@@ -88,6 +106,7 @@ private:
     void updateSelection(const sf::Vector2i& newSelectionEnd);
     void highlightArea(sf::Vector2i a, sf::Vector2i b, bool highlight);
     void updateWireTool(const sf::Vector2i& lastCursorCoords);
+    void updateChunkProfile();
     template<typename T, typename... Args>
     std::unique_ptr<T> makeCommand(Args&&... args);
     void executeCommand(std::unique_ptr<Command>&& command);
@@ -96,6 +115,13 @@ private:
 
     EditorInterface interface_;
     Board& board_;
+    Simulator simulator_;
+    sim::SimThread simThread_;
+    uint64_t warpTickCount_;
+    // Set while the simulation thread runs a warp, the clock times it.
+    bool warpRunning_;
+    sf::Clock warpClock_;
+    sf::Clock chunkProfileClock_;
     const fs::path workingDirectory_;
     OffsetView editView_;
     float zoomLevel_;
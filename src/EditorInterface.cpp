@@ -355,13 +355,23 @@ std::shared_ptr<gui::MenuBar> EditorInterface::createMenuBar(sf::RenderWindow& w
     gui::MenuList runMenu("Run");
     runMenu.items.emplace_back("Step One Tick", "Tab");
     runMenu.items.emplace_back("Change Max TPS", "Shift+Tab");
+    runMenu.items.emplace_back("Warp Ticks", "Ctrl+Tab");
+    runMenu.items.emplace_back("Record Inputs");
+    runMenu.items.emplace_back("Replay Inputs...");
+    runMenu.items.emplace_back("  (Alt+Key = Press Inputs)", "", false);
     menuBar->insertMenu(runMenu);
 
-    auto chooseRunMenu = [](const sf::String& item) {
+    auto chooseRunMenu = [this](const sf::String& item) {
         if (item == "Step One Tick") {
-
+            editor_.stepOneTick();
         } else if (item == "Change Max TPS") {
-
+            editor_.changeMaxTps();
+        } else if (item == "Warp Ticks") {
+            editor_.warpTicks();
+        } else if (item == "Record Inputs") {
+            editor_.recordInputs();
+        } else if (item == "Replay Inputs...") {
+            editor_.replayInputs();
         }
     };
 
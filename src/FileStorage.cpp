@@ -51,6 +51,10 @@ void FileStorage::loadAllChunks(Board& /*board*/) {
 
 }
 
+bool FileStorage::unloadChunk(Board& /*board*/, Chunk& /*chunk*/) {
+    return false;
+}
+
 void FileStorage::setFilename(const fs::path& filename) {
     filename_ = filename;
 }
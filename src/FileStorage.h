@@ -15,6 +15,7 @@
 #endif
 
 class Board;
+class Chunk;
 class ChunkCoordsRange;
 
 /**
@@ -71,6 +72,9 @@ public:
     virtual void updateVisibleChunks(Board& board, const ChunkCoordsRange& visibleChunks);
     virtual bool loadChunk(Board& board, ChunkCoords::repr chunkCoords);
     virtual void loadAllChunks(Board& board);
+    // Checks if the chunk can be dropped from the board and loaded again later, the storage may move the chunk out
+    // to keep a copy of it.
+    virtual bool unloadChunk(Board& board, Chunk& chunk);
 
 protected:
     void setFilename(const fs::path& filename);
@@ -17,6 +17,9 @@ constexpr int constLog2(int x) {
     return x == 1 ? 0 : 1 + constLog2(x / 2);
 }
 
+constexpr int CACHE_LOAD_WIDTH = 4;
+constexpr int CACHE_SIZE = CACHE_LOAD_WIDTH * CACHE_LOAD_WIDTH * 4;
+
 }
 
 constexpr int RegionFileFormat::REGION_WIDTH;
@@ -28,7 +31,8 @@ RegionFileFormat::RegionFileFormat(const fs::path& filename) :
     savedRegions_(),
     lastVisibleChunks_(0, 0, 0, 0),
     chunkCache_(),
-    chunkCacheTimes_() {
+    chunkCacheTimes_(),
+    swapFile_() {
 }
 
 fs::path RegionFileFormat::getDefaultFileExtension() const {
@@ -47,6 +51,7 @@ void RegionFileFormat::loadFromFile(Board& board, const fs::path& filename, fs::
     lastVisibleChunks_ = ChunkCoordsRange(0, 0, 0, 0);
     chunkCache_.clear();
     chunkCacheTimes_.clear();
+    swapFile_.clear();
 
     const fs::path boardFilename = getFilename() / "board.txt";
     if (!boardFile.is_open()) {
@@ -100,6 +105,10 @@ void RegionFileFormat::saveToFile(Board& board) {
             chunk.second.markAsSaved();
         }
     }
+    // Unloaded chunks with unsaved changes are in the swap file, these only come back while their region is saved.
+    for (auto chunkCoords : swapFile_.getStoredCoords()) {
+        unsavedRegions[toRegionCoords(chunkCoords)].insert(chunkCoords);
+    }
 
     spdlog::debug("save file: {}", getFilename());
     spdlog::debug("unsavedRegions:");
@@ -117,7 +126,34 @@ void RegionFileFormat::saveToFile(Board& board) {
     fs::create_directories(getFilename());
     fs::create_directory(getFilename() / "region");
     for (const auto& region : unsavedRegions) {
-        saveRegion(board, region.first, region.second);
+        // Only one region of swapped chunks is in memory at a time, and these don't go back into the board (the
+        // simulator may be keeping the number of loaded chunks under a limit).
+        std::unordered_map<ChunkCoords::repr, Chunk> swappedChunks;
+        for (auto chunkCoords : region.second) {
+            if (board.findLoadedChunk(chunkCoords) == nullptr) {
+                auto swappedChunk = swappedChunks.emplace(std::piecewise_construct, std::forward_as_tuple(chunkCoords), std::forward_as_tuple(nullptr, chunkCoords)).first;
+                swapFile_.take(chunkCoords, swappedChunk->second);
+                swappedChunk->second.markAsUnsaved();
+            }
+        }
+        try {
+            saveRegion(board, region.first, region.second, swappedChunks);
+        } catch (...) {
+            for (auto& swappedChunk : swappedChunks) {
+                swapFile_.store(std::move(swappedChunk.second));
+            }
+            throw;
+        }
+        // The saved ones load from the region file next time (the cache may still have a copy from before they were
+        // edited), any that failed to save go back into the swap file.
+        for (auto& swappedChunk : swappedChunks) {
+            if (swappedChunk.second.isUnsaved()) {
+                swapFile_.store(std::move(swappedChunk.second));
+            } else {
+                chunkCache_.erase(swappedChunk.first);
+                chunkCacheTimes_.erase(swappedChunk.first);
+            }
+        }
     }
 
     const fs::path boardFilename = getFilename() / "board.txt";
@@ -179,9 +215,21 @@ void RegionFileFormat::updateVisibleChunks(Board& board, const ChunkCoordsRange&
 
 bool RegionFileFormat::loadChunk(Board& board, ChunkCoords::repr chunkCoords) {
     spdlog::debug("Checking chunk {} for load.", ChunkCoords::toPair(chunkCoords));
+    if (board.isChunkLoaded(chunkCoords)) {
+        return false;
+    }
+    // The swap file has the latest changes, so it takes priority over the saved chunk.
+    if (swapFile_.contains(chunkCoords)) {
+        Chunk swappedChunk(nullptr, chunkCoords);
+        swapFile_.take(chunkCoords, swappedChunk);
+        spdlog::debug("Loading chunk {} from swap file.", ChunkCoords::toPair(chunkCoords));
+        swappedChunk.markAsUnsaved();
+        board.loadChunk(std::move(swappedChunk));
+        return true;
+    }
     const auto regionCoords = toRegionCoords(chunkCoords);
     auto region = savedRegions_.find(regionCoords);
-    if (region == savedRegions_.end() || region->second.count(chunkCoords) == 0 || board.isChunkLoaded(chunkCoords)) {
+    if (region == savedRegions_.end() || region->second.count(chunkCoords) == 0) {
         return false;
     }
 
@@ -208,9 +256,6 @@ bool RegionFileFormat::loadChunk(Board& board, ChunkCoords::repr chunkCoords) {
         return false;
     }
 
-    constexpr int CACHE_LOAD_WIDTH = 4;
-    constexpr int CACHE_SIZE = CACHE_LOAD_WIDTH * CACHE_LOAD_WIDTH * 4;
-
     const auto regionOffset = toRegionOffset(chunkCoords);
     int xStart = (regionOffset.first / CACHE_LOAD_WIDTH) * CACHE_LOAD_WIDTH;
     int yStart = (regionOffset.second / CACHE_LOAD_WIDTH) * CACHE_LOAD_WIDTH;
@@ -221,18 +266,7 @@ bool RegionFileFormat::loadChunk(Board& board, ChunkCoords::repr chunkCoords) {
             if (header[headerIndex].sectors > 0 && chunkCacheTimes_.count(cacheChunkCoords) == 0) {
                 // Remove chunk from the cache if full to make more space.
                 if (chunkCache_.size() >= CACHE_SIZE) {
-                    auto minCacheTime = chunkCacheTimes_.begin();
-                    for (auto chunkCacheTime = chunkCacheTimes_.begin(); chunkCacheTime != chunkCacheTimes_.end(); ++chunkCacheTime) {
-                        if (chunkCacheTime->second < minCacheTime->second) {
-                            minCacheTime = chunkCacheTime;
-                        }
-                    }
-                    spdlog::debug(
-                        "Removing cached chunk at {} (caching would exceed {} chunks).",
-                        ChunkCoords::toPair(minCacheTime->first), CACHE_SIZE
-                    );
-                    chunkCache_.erase(minCacheTime->first);
-                    chunkCacheTimes_.erase(minCacheTime);
+                    evictCachedChunk();
                 }
 
                 spdlog::debug(
@@ -271,6 +305,29 @@ void RegionFileFormat::loadAllChunks(Board& board) {
     }
 }
 
+bool RegionFileFormat::unloadChunk(Board& /*board*/, Chunk& chunk) {
+    const ChunkCoords::repr chunkCoords = chunk.getCoords();
+    auto region = savedRegions_.find(toRegionCoords(chunkCoords));
+    const bool saved = (region != savedRegions_.end() && region->second.count(chunkCoords) > 0);
+    if (!saved && chunk.isEmpty()) {
+        return true;
+    } else if (!saved || chunk.isUnsaved()) {
+        // The cache can drop a chunk at any time, so changes that aren't saved yet need to go in the swap file.
+        spdlog::debug("Moving chunk {} to swap file while unloading it.", ChunkCoords::toPair(chunkCoords));
+        swapFile_.store(std::move(chunk));
+        return true;
+    }
+
+    spdlog::debug("Caching chunk {} while unloading it.", ChunkCoords::toPair(chunkCoords));
+    if (chunkCache_.size() >= CACHE_SIZE) {
+        evictCachedChunk();
+    }
+    chunkCache_.erase(chunkCoords);
+    chunkCache_.emplace(chunkCoords, std::move(chunk));
+    chunkCacheTimes_[chunkCoords] = std::chrono::steady_clock::now();
+    return true;
+}
+
 RegionFileFormat::RegionCoords RegionFileFormat::toRegionCoords(ChunkCoords::repr chunkCoords) {
     constexpr int widthLog2 = constLog2(REGION_WIDTH);
     return {
@@ -391,7 +448,22 @@ void RegionFileFormat::loadRegion(Board& /*board*/, const RegionCoords& regionCo
     regionFile.close();
 }
 
-void RegionFileFormat::saveRegion(Board& board, const RegionCoords& regionCoords, const Region& region) {
+void RegionFileFormat::evictCachedChunk() {
+    auto minCacheTime = chunkCacheTimes_.begin();
+    for (auto chunkCacheTime = chunkCacheTimes_.begin(); chunkCacheTime != chunkCacheTimes_.end(); ++chunkCacheTime) {
+        if (chunkCacheTime->second < minCacheTime->second) {
+            minCacheTime = chunkCacheTime;
+        }
+    }
+    spdlog::debug(
+        "Removing cached chunk at {} (caching would exceed {} chunks).",
+        ChunkCoords::toPair(minCacheTime->first), CACHE_SIZE
+    );
+    chunkCache_.erase(minCacheTime->first);
+    chunkCacheTimes_.erase(minCacheTime);
+}
+
+void RegionFileFormat::saveRegion(Board& board, const RegionCoords& regionCoords, const Region& region, const std::unordered_map<ChunkCoords::repr, Chunk>& swappedChunks) {
     fs::path regionFilename = std::to_string(regionCoords.first) + "." + std::to_string(regionCoords.second) + ".dat";
     regionFilename = getFilename() / "region" / regionFilename;
 
@@ -469,7 +541,8 @@ void RegionFileFormat::saveRegion(Board& board, const RegionCoords& regionCoords
         const auto regionOffset = toRegionOffset(chunkCoords);
         const auto& headerEntry = header[regionOffset.first + regionOffset.second * REGION_WIDTH];
 
-        const auto& chunk = board.getLoadedChunks().at(chunkCoords);
+        const auto swappedChunk = swappedChunks.find(chunkCoords);
+        const Chunk& chunk = (swappedChunk != swappedChunks.end() ? swappedChunk->second : board.getLoadedChunks().at(chunkCoords));
         const uint32_t chunkPayloadSize = chunk.serializeLength();
         const uint32_t sectorCount = (chunkPayloadSize + SECTOR_SIZE - 1) / SECTOR_SIZE;
 
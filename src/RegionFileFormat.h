@@ -3,6 +3,7 @@
 #include <Chunk.h>
 #include <ChunkCoords.h>
 #include <ChunkCoordsRange.h>
+#include <ChunkSwapFile.h>
 #include <FileStorage.h>
 #include <Filesystem.h>
 #include <FlatMap.h>
@@ -44,6 +45,12 @@ class Board;
  * bytes, padded with zeros to an even number of sectors. The length includes
  * the length bytes itself, so it can be 4 at minimum.
  * 
+ * Chunks can also be unloaded again to keep memory use down. Chunks that match
+ * what's saved go back to the cache, while chunks with unsaved changes go to a
+ * `ChunkSwapFile` until they are loaded again or the board is saved. Saving
+ * writes the swapped chunks to their regions without loading them into the
+ * board.
+ * 
  * The region file format is based on the McRegion format used in Minecraft:
  * https://minecraft.wiki/w/Region_file_format
  */
@@ -71,6 +78,7 @@ public:
     virtual void updateVisibleChunks(Board& board, const ChunkCoordsRange& visibleChunks) override;
     virtual bool loadChunk(Board& board, ChunkCoords::repr chunkCoords) override;
     virtual void loadAllChunks(Board& board) override;
+    virtual bool unloadChunk(Board& board, Chunk& chunk) override;
 
 private:
     using Region = std::set<ChunkCoords::repr>;
@@ -89,12 +97,16 @@ private:
     static uint8_t writeChunk(ChunkHeaderEntry& headerEntry, SectorOffset offset, const Chunk& chunk, const fs::path& filename, std::ostream& regionFile);
 
     void loadRegion(Board& board, const RegionCoords& regionCoords);
-    void saveRegion(Board& board, const RegionCoords& regionCoords, const Region& region);
+    void evictCachedChunk();
+    // Writes the chunks in the region, the ones in `swappedChunks` were taken from the swap file and the rest are
+    // loaded in the board.
+    void saveRegion(Board& board, const RegionCoords& regionCoords, const Region& region, const std::unordered_map<ChunkCoords::repr, Chunk>& swappedChunks);
 
     std::map<RegionCoords, Region> savedRegions_;
     ChunkCoordsRange lastVisibleChunks_;
     std::unordered_map<ChunkCoords::repr, Chunk> chunkCache_;
     FlatMap<ChunkCoords::repr, std::chrono::time_point<std::chrono::steady_clock>> chunkCacheTimes_;
+    ChunkSwapFile swapFile_;
 };
 
 /**
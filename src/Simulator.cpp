@@ -0,0 +1,1748 @@
+#include <Board.h>
+#include <MakeUnique.h>
+#include <sim/TileLogic.h>
+#include <Simulator.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int constLog2(int x) {
+    return x == 1 ? 0 : 1 + constLog2(x / 2);
+}
+
+constexpr int WIDTH_LOG2 = constLog2(Chunk::WIDTH);
+constexpr int CHUNK_AREA = Chunk::WIDTH * Chunk::WIDTH;
+
+// Following a wire adds a fragment to the net every this many wires, an edit then only needs to follow the
+// wires of one fragment again.
+constexpr size_t MAX_FRAGMENT_WIRES = 256;
+
+// Amount of work given to a worker at a time, in chunks for gate evaluation and in nets for net resolution.
+constexpr size_t GATE_BLOCK_SIZE = 4;
+constexpr size_t NET_BLOCK_SIZE = 64;
+
+// Limits how many earlier ticks with a matching change hash get checked as the start of a cycle.
+constexpr int MAX_CYCLE_CANDIDATES = 16;
+
+// Chunks without activity for this many ticks go to sleep, this is checked once every interval.
+constexpr uint64_t DEFAULT_SLEEP_TICKS = 1024;
+constexpr uint64_t SLEEP_CHECK_INTERVAL = 64;
+// Chunks active within this many ticks are never put to sleep early.
+constexpr uint64_t MIN_EVICT_QUIET_TICKS = SLEEP_CHECK_INTERVAL;
+
+// Set while a thread runs tasks from the worker pool. The board may belong to the renderer during a tick, so the
+// workers must never load a chunk.
+thread_local bool inWorkerTask = false;
+
+using ProfileClock = std::chrono::steady_clock;
+
+uint64_t nanosecondsSince(ProfileClock::time_point start) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(ProfileClock::now() - start).count());
+}
+
+// Finalizer from splitmix64, spreads the bits so that a sum of the hashes is not easy to collide.
+uint64_t mixHash(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+}
+
+constexpr int32_t Simulator::NEIGHBOR_UNKNOWN;
+constexpr int32_t Simulator::NEIGHBOR_NONE;
+
+Simulator::ChunkState::ChunkState(Chunk* chunk, ChunkCoords::repr coords) :
+    chunk(chunk),
+    coords(coords),
+    neighbors(),
+    pendingUpdates(),
+    currentUpdates(),
+    queued(),
+    visited(),
+    probed(),
+    nets(),
+    activity(),
+    active(false),
+    touched(false),
+    drawDirty(false),
+    changed(false),
+    inCycle(false) {
+
+    neighbors.fill(NEIGHBOR_UNKNOWN);
+}
+
+Simulator::Simulator(Board& board) :
+    board_(board),
+    chunks_(),
+    chunkSlots_(),
+    activeChunks_(),
+    tickChunks_(),
+    touchedChunks_(),
+    drawDirtyChunks_(),
+    changedChunks_(),
+    cycleChunks_(),
+    workerPool_(),
+    taskOutputs_(),
+    changedGates_(),
+    ledUpdates_(),
+    timedUpdates_(),
+    residency_(),
+    sleepingChunks_(),
+    residentSleepers_(),
+    triedSleeperCount_(0),
+    maxResidentChunks_(0),
+    residentChunkCount_(0),
+    boardTaskRunner_(),
+    checkpoints_(),
+    checkpointSnapshot_(),
+    checkpointInterval_(0),
+    stateEdits_(),
+    editReplayIndex_(0),
+    probes_(),
+    probeTiles_(),
+    waveform_(),
+    keyInputs_(),
+    inputKeycodes_(),
+    unindexedChunks_(),
+    inputLog_(),
+    inputMode_(InputMode::none),
+    inputStartTick_(0),
+    replayIndex_(0),
+    netUpdates_(),
+    netUpdateSlots_(),
+    netlist_(),
+    wireNodes_(),
+    fragmentSeeds_(),
+    netWires_(),
+    editedWires_(),
+    netEndpoints_(),
+    mergeNets_(),
+    segmentNodes_(),
+    segmentSeeds_(),
+    ledNodes_(),
+    ledGroup_(),
+    tickCount_(0),
+    stitchedNets_(false),
+    deferDrawDirty_(false),
+    detachedDrawing_(false),
+    chunkProfiling_(false),
+    profiledTickCount_(0),
+    changeHash_(0),
+    findingCycleChunks_(false) {
+
+    residency_.setSleepTicks(DEFAULT_SLEEP_TICKS);
+    board_.addTileChangeListener(this);
+}
+
+Simulator::~Simulator() {
+    board_.removeTileChangeListener(this);
+}
+
+void Simulator::reset() {
+    chunks_.clear();
+    chunkSlots_.clear();
+    activeChunks_.clear();
+    tickChunks_.clear();
+    touchedChunks_.clear();
+    drawDirtyChunks_.clear();
+    changedChunks_.clear();
+    timedUpdates_.clear(tickCount_);
+    residency_.clear();
+    residentSleepers_.clear();
+    triedSleeperCount_ = 0;
+    residentChunkCount_ = 0;
+    profiledTickCount_ = 0;
+    keyInputs_.clear();
+    inputKeycodes_.clear();
+    unindexedChunks_.clear();
+    netlist_.clear();
+    editedWires_.clear();
+    stitchedNets_ = (board_.getMaxSize() == sf::Vector2u(0, 0));
+
+    // Collect the coords first, finding a chunk can load more chunks into the board.
+    std::vector<ChunkCoords::repr> loadedCoords;
+    loadedCoords.reserve(board_.getLoadedChunks().size());
+    for (const auto& chunk : board_.getLoadedChunks()) {
+        loadedCoords.push_back(chunk.first);
+    }
+    for (auto coords : loadedCoords) {
+        int32_t slot = findSlot(coords);
+        if (slot < 0) {
+            continue;
+        }
+        for (unsigned int i = 0; i < CHUNK_AREA; ++i) {
+            queueTile({static_cast<uint32_t>(slot), static_cast<uint16_t>(i)});
+        }
+    }
+    probeTiles_.clear();
+    for (uint32_t i = 0; i < probes_.size(); ++i) {
+        resolveProbe(i);
+    }
+    clearCheckpoints();
+    if (checkpointInterval_ != 0) {
+        saveCheckpoint();
+    }
+}
+
+void Simulator::addUpdate(int x, int y, bool adjacentUpdates) {
+    addChunkUpdate(ChunkCoords::pack(x >> WIDTH_LOG2, y >> WIDTH_LOG2), (x & (Chunk::WIDTH - 1)) + (y & (Chunk::WIDTH - 1)) * Chunk::WIDTH, adjacentUpdates);
+}
+
+void Simulator::addChunkUpdate(ChunkCoords::repr coords, unsigned int tileIndex, bool adjacentUpdates) {
+    assert(tileIndex < CHUNK_AREA);
+    if (checkpointInterval_ != 0) {
+        const int32_t slot = findSlot(coords);
+        if (slot >= 0) {
+            recordTileEdit({static_cast<uint32_t>(slot), static_cast<uint16_t>(tileIndex)}, 0, adjacentUpdates);
+        }
+    }
+    queueChunkUpdate(coords, tileIndex, adjacentUpdates);
+}
+
+void Simulator::queueChunkUpdate(ChunkCoords::repr coords, unsigned int tileIndex, bool adjacentUpdates) {
+    int32_t slot = findSlot(coords);
+    if (slot < 0) {
+        return;
+    }
+    TileRef tile = {static_cast<uint32_t>(slot), static_cast<uint16_t>(tileIndex)};
+    queueTile(tile);
+    // Inputs change state outside of the simulator, so this is where a probe on one sees the change.
+    if (chunks_[slot].probed[tileIndex]) {
+        sampleProbes(tile);
+    }
+
+    // If a wire changed state, the state we assumed it has is no longer valid.
+    for (int channel = 0; channel < 2; ++channel) {
+        uint32_t fragmentId = netlist_.getFragmentId(tile, channel);
+        if (fragmentId != sim::WireNetlist::NO_NET) {
+            netlist_.getNet(fragmentId).state = State::disconnected;
+        }
+    }
+    if (adjacentUpdates) {
+        for (int i = 0; i < 4; ++i) {
+            TileRef adjacent;
+            if (getAdjacent(tile, static_cast<Direction::t>(i), adjacent)) {
+                queueTile(adjacent);
+            }
+        }
+    }
+}
+
+void Simulator::scheduleUpdate(int x, int y, uint64_t numTicks, bool adjacentUpdates) {
+    if (numTicks <= 1) {
+        addUpdate(x, y, adjacentUpdates);
+        return;
+    }
+    int32_t slot = findSlot(ChunkCoords::pack(x >> WIDTH_LOG2, y >> WIDTH_LOG2));
+    if (slot < 0) {
+        return;
+    }
+    const TileRef tile = {static_cast<uint32_t>(slot), static_cast<uint16_t>((x & (Chunk::WIDTH - 1)) + (y & (Chunk::WIDTH - 1)) * Chunk::WIDTH)};
+    if (checkpointInterval_ != 0) {
+        recordTileEdit(tile, numTicks, adjacentUpdates);
+    }
+    scheduleTileUpdate(tile, numTicks, adjacentUpdates);
+}
+
+void Simulator::scheduleTileUpdate(TileRef tile, uint64_t numTicks, bool adjacentUpdates) {
+    // Timed updates expire at the end of a tick and queue the tile for the tick after that. The chunk stays awake
+    // until then.
+    timedUpdates_.schedule(tickCount_ + numTicks - 2, {tile, false, adjacentUpdates});
+    residency_.markActive(tile.slot, tickCount_ + numTicks - 1);
+}
+
+void Simulator::tileChanged(const sf::Vector2i& pos, TileChange::t change) {
+    const ChunkCoords::repr coords = ChunkCoords::pack(pos.x >> WIDTH_LOG2, pos.y >> WIDTH_LOG2);
+    const unsigned int tileIndex = (pos.x & (Chunk::WIDTH - 1)) + (pos.y & (Chunk::WIDTH - 1)) * Chunk::WIDTH;
+    if (change == TileChange::structure) {
+        int32_t slot = findSlot(coords);
+        if (slot < 0) {
+            return;
+        }
+        editTile({static_cast<uint32_t>(slot), static_cast<uint16_t>(tileIndex)});
+        indexInput({static_cast<uint32_t>(slot), static_cast<uint16_t>(tileIndex)});
+        clearCheckpoints();
+    }
+    addChunkUpdate(coords, tileIndex, true);
+}
+
+void Simulator::boardReloaded() {
+    reset();
+}
+
+void Simulator::chunkLoaded(ChunkCoords::repr coords) {
+    // Chunks with a slot were indexed already, a new slot can't be made here since this may be called from
+    // `findSlot()` itself.
+    if (chunkSlots_.count(coords) == 0) {
+        unindexedChunks_.push_back(coords);
+    }
+}
+
+bool Simulator::hasPendingUpdates() const {
+    return !activeChunks_.empty() || !timedUpdates_.empty() || isReplaying();
+}
+
+size_t Simulator::getPendingUpdateCount() const {
+    size_t count = timedUpdates_.size();
+    for (auto slot : activeChunks_) {
+        count += chunks_[slot].pendingUpdates.size();
+    }
+    return count;
+}
+
+uint64_t Simulator::getTickCount() const {
+    return tickCount_;
+}
+
+void Simulator::setStitchedNets(bool stitchedNets) {
+    // The fragments from one way of building nets don't line up with the segments the other one expects.
+    if (stitchedNets != stitchedNets_) {
+        netlist_.clear();
+        editedWires_.clear();
+    }
+    stitchedNets_ = stitchedNets;
+}
+
+bool Simulator::getStitchedNets() const {
+    return stitchedNets_;
+}
+
+void Simulator::setThreadCount(unsigned int numThreads) {
+    if (numThreads <= 1) {
+        workerPool_.reset();
+    } else if (numThreads != getThreadCount()) {
+        workerPool_ = details::make_unique<sim::WorkerPool>(numThreads);
+    }
+}
+
+unsigned int Simulator::getThreadCount() const {
+    return (workerPool_ ? workerPool_->getThreadCount() : 1);
+}
+
+void Simulator::setSleepTicks(uint64_t sleepTicks) {
+    residency_.setSleepTicks(sleepTicks);
+}
+
+uint64_t Simulator::getSleepTicks() const {
+    return residency_.getSleepTicks();
+}
+
+size_t Simulator::getSleepingChunkCount() const {
+    return residency_.getSleepingCount();
+}
+
+void Simulator::setMaxResidentChunks(size_t maxResidentChunks) {
+    maxResidentChunks_ = maxResidentChunks;
+}
+
+size_t Simulator::getMaxResidentChunks() const {
+    return maxResidentChunks_;
+}
+
+size_t Simulator::getResidentChunkCount() const {
+    return residentChunkCount_;
+}
+
+void Simulator::unloadSleepingChunks() {
+    // Chunks that went to sleep without unloading get another try, unless they woke up since then.
+    size_t numResident = 0;
+    for (auto slot : residentSleepers_) {
+        if (residency_.isAsleep(slot) && !unloadSlot(slot)) {
+            residentSleepers_[numResident++] = slot;
+        }
+    }
+    residentSleepers_.resize(numResident);
+    triedSleeperCount_ = numResident;
+}
+
+bool Simulator::hasChunksToUnload() const {
+    return residentSleepers_.size() > triedSleeperCount_;
+}
+
+void Simulator::setBoardTaskRunner(const std::function<void(const std::function<void()>& task)>& runner) {
+    boardTaskRunner_ = runner;
+}
+
+void Simulator::setCheckpointInterval(uint64_t interval) {
+    checkpointInterval_ = interval;
+    clearCheckpoints();
+    if (interval != 0) {
+        // The checkpoints cover every chunk, so any unloaded ones need to come back.
+        for (uint32_t slot = 0; slot < chunks_.size(); ++slot) {
+            accessSlotChunk(slot);
+        }
+        saveCheckpoint();
+    }
+}
+
+uint64_t Simulator::getCheckpointInterval() const {
+    return checkpointInterval_;
+}
+
+void Simulator::setMaxCheckpointBytes(size_t maxBytes) {
+    checkpoints_.setMaxBytes(maxBytes);
+}
+
+const sim::CheckpointLog& Simulator::getCheckpointLog() const {
+    return checkpoints_;
+}
+
+bool Simulator::rewind(uint64_t numTicks) {
+    if (numTicks > tickCount_) {
+        return false;
+    }
+    const uint64_t targetTick = tickCount_ - numTicks;
+    if (!checkpoints_.rewind(targetTick, checkpointSnapshot_)) {
+        return false;
+    }
+    restoreSnapshot(checkpointSnapshot_);
+    // The edits made after the checkpoint get applied again on the way to the target, the ones after it are dropped.
+    auto editsFrom = [this](uint64_t tick) {
+        return std::lower_bound(stateEdits_.begin(), stateEdits_.end(), tick, [](const StateEdit& edit, uint64_t tick) {
+            return edit.tick < tick;
+        });
+    };
+    stateEdits_.erase(editsFrom(targetTick), stateEdits_.end());
+    editReplayIndex_ = static_cast<size_t>(editsFrom(tickCount_) - stateEdits_.begin());
+    if (inputMode_ == InputMode::record) {
+        // The presses before the target stay in the log, they get applied again with the other edits on the way
+        // there. Going back to before the recording started restarts it from the target.
+        inputStartTick_ = std::min(inputStartTick_, targetTick);
+        inputLog_.truncate(targetTick - inputStartTick_);
+    } else if (inputMode_ == InputMode::replay) {
+        const auto& events = inputLog_.getEvents();
+        while (replayIndex_ > 0 && inputStartTick_ + events[replayIndex_ - 1].tick >= tickCount_) {
+            --replayIndex_;
+        }
+    }
+    warp(targetTick - tickCount_);
+    return true;
+}
+
+uint32_t Simulator::addProbe(const sf::Vector2i& pos, int channel, const std::string& name) {
+    assert(channel == 0 || channel == 1);
+    const uint32_t probeId = waveform_.addSignal(!name.empty() ? name :
+        "tile_" + std::to_string(pos.x) + "_" + std::to_string(pos.y) + (channel == 1 ? "_1" : ""));
+    assert(probeId == probes_.size());
+    probes_.push_back({pos, channel, NEIGHBOR_NONE, 0, State::disconnected});
+    resolveProbe(probeId);
+    return probeId;
+}
+
+void Simulator::clearProbes() {
+    for (const auto& probe : probes_) {
+        if (probe.slot >= 0) {
+            chunks_[probe.slot].probed[probe.index] = false;
+        }
+    }
+    probes_.clear();
+    probeTiles_.clear();
+    waveform_.clear();
+}
+
+size_t Simulator::getProbeCount() const {
+    return probes_.size();
+}
+
+sim::WaveformRecorder& Simulator::getWaveformRecorder() {
+    return waveform_;
+}
+
+void Simulator::pressKey(char keycode) {
+    if (inputMode_ == InputMode::record) {
+        inputLog_.add(tickCount_ - inputStartTick_, keycode);
+    }
+    if (checkpointInterval_ != 0) {
+        stateEdits_.push_back({tickCount_, true, keycode, {0, 0}, State::disconnected, State::disconnected, 0, false});
+        editReplayIndex_ = stateEdits_.size();
+    }
+    toggleInputs(keycode);
+}
+
+void Simulator::setInputMode(InputMode mode) {
+    inputMode_ = mode;
+    inputStartTick_ = tickCount_;
+    replayIndex_ = 0;
+    if (mode == InputMode::record) {
+        inputLog_.clear();
+    } else if (mode == InputMode::replay && inputLog_.empty()) {
+        inputMode_ = InputMode::none;
+    }
+}
+
+Simulator::InputMode Simulator::getInputMode() const {
+    // A finished replay stays in replay mode internally, so that a rewind can pick it up again.
+    return (inputMode_ == InputMode::replay && !isReplaying() ? InputMode::none : inputMode_);
+}
+
+sim::InputLog& Simulator::accessInputLog() {
+    return inputLog_;
+}
+
+void Simulator::setChunkProfiling(bool chunkProfiling) {
+    chunkProfiling_ = chunkProfiling;
+}
+
+bool Simulator::getChunkProfiling() const {
+    return chunkProfiling_;
+}
+
+std::vector<std::pair<ChunkCoords::repr, Simulator::ChunkActivity>> Simulator::getChunkActivity() const {
+    std::vector<std::pair<ChunkCoords::repr, ChunkActivity>> activity;
+    for (const auto& chunkState : chunks_) {
+        if (chunkState.activity.updates != 0 || chunkState.activity.netEvaluations != 0 || chunkState.activity.nanoseconds != 0) {
+            activity.emplace_back(chunkState.coords, chunkState.activity);
+        }
+    }
+    return activity;
+}
+
+uint64_t Simulator::getProfiledTickCount() const {
+    return profiledTickCount_;
+}
+
+void Simulator::clearChunkActivity() {
+    for (auto& chunkState : chunks_) {
+        chunkState.activity = ChunkActivity();
+    }
+    profiledTickCount_ = 0;
+}
+
+void Simulator::tick() {
+    const bool extraLogicStates = board_.getExtraLogicStates();
+    changeHash_ = 0;
+    if (isReplaying()) {
+        replayInputs();
+    }
+    while (editReplayIndex_ < stateEdits_.size() && stateEdits_[editReplayIndex_].tick <= tickCount_) {
+        applyStateEdit(stateEdits_[editReplayIndex_]);
+        ++editReplayIndex_;
+    }
+    followEditedWires();
+
+    // Move the pending updates into the current tick, any updates added from here on will apply to the next tick.
+    // The two lists trade places each tick so that neither gives up its capacity.
+    tickChunks_.swap(activeChunks_);
+    for (auto slot : tickChunks_) {
+        auto& chunkState = chunks_[slot];
+        chunkState.currentUpdates.swap(chunkState.pendingUpdates);
+        chunkState.pendingUpdates.clear();
+        chunkState.queued.reset();
+        chunkState.active = false;
+        residency_.markActive(slot, tickCount_);
+        if (chunkProfiling_) {
+            chunkState.activity.updates += chunkState.currentUpdates.size();
+        }
+    }
+
+    // Phase 1: find the next state of queued gates and apply the changes.
+    if (workerPool_ || boardTaskRunner_) {
+        resolveNeighbors(tickChunks_);
+    }
+    evaluateGates(extraLogicStates);
+
+    // Phase 2: propagate outputs from changed gates and the queued inputs, then handle any remaining wires and LEDs.
+    for (const auto& gate : changedGates_) {
+        propagateFrom(gate, accessTileData(gate).dir);
+    }
+    for (auto slot : tickChunks_) {
+        const auto startTime = (chunkProfiling_ ? ProfileClock::now() : ProfileClock::time_point());
+        for (size_t i = 0; i < chunks_[slot].currentUpdates.size(); ++i) {
+            TileRef tile = {slot, chunks_[slot].currentUpdates[i]};
+            const TileData tileData = accessTileData(tile);
+            if (sim::isInput(tileData.id)) {
+                if (tileData.id == TileId::inButton && tileData.state1 == State::high) {
+                    timedUpdates_.schedule(tickCount_, {tile, true, true});
+                }
+                for (int j = 0; j < 4; ++j) {
+                    propagateFrom(tile, static_cast<Direction::t>(j));
+                }
+            } else if (sim::isWire(tileData.id)) {
+                scheduleNet(tile, 0);
+                if (tileData.id == TileId::wireCrossover) {
+                    scheduleNet(tile, 1);
+                }
+            } else if (tileData.id == TileId::outLed) {
+                ledUpdates_.push_back(tile);
+            }
+        }
+        if (chunkProfiling_) {
+            chunks_[slot].activity.nanoseconds += nanosecondsSince(startTime);
+        }
+    }
+    updateNets(extraLogicStates);
+
+    // Phase 3: update LED groups that are endpoints of a changed wire (or had an update directly).
+    for (const auto& led : ledUpdates_) {
+        if (chunkProfiling_) {
+            const auto startTime = ProfileClock::now();
+            updateLedGroup(led);
+            chunks_[led.slot].activity.nanoseconds += nanosecondsSince(startTime);
+        } else {
+            updateLedGroup(led);
+        }
+    }
+
+    // Phase 4: run the timed updates for this tick, buttons that were pressed transition back to low in the next tick.
+    timedUpdates_.advance([this](const TimedUpdate& update) {
+        runTimedUpdate(update);
+    });
+
+    for (auto slot : tickChunks_) {
+        chunks_[slot].currentUpdates.clear();
+    }
+    tickChunks_.clear();
+    for (auto slot : touchedChunks_) {
+        chunks_[slot].visited.reset();
+        chunks_[slot].touched = false;
+        residency_.markActive(slot, tickCount_);
+    }
+    touchedChunks_.clear();
+    changedGates_.clear();
+    ledUpdates_.clear();
+    ++tickCount_;
+    if (chunkProfiling_) {
+        ++profiledTickCount_;
+    }
+    if (tickCount_ % SLEEP_CHECK_INTERVAL == 0) {
+        sleepChunks();
+    }
+    if (checkpointInterval_ != 0 && tickCount_ % checkpointInterval_ == 0) {
+        saveCheckpoint();
+    }
+}
+
+void Simulator::warp(uint64_t numTicks) {
+    deferDrawDirty_ = true;
+    for (uint64_t i = 0; i < numTicks;) {
+        const uint64_t skippedTicks = skipQuietTicks(numTicks - i);
+        if (skippedTicks != 0) {
+            i += skippedTicks;
+            continue;
+        }
+        tick();
+        ++i;
+    }
+    deferDrawDirty_ = detachedDrawing_;
+    if (!detachedDrawing_) {
+        flushDrawDirty();
+    }
+}
+
+Simulator::SettleResult Simulator::settle(uint64_t maxTicks) {
+    SettleResult result = {false, 0, 0, {}};
+    deferDrawDirty_ = true;
+
+    // The change hash of each tick that changed something, the tick count it ran on, and the last entry before it
+    // with the same hash. Ticks that change nothing (waiting on a timed update) don't get an entry, instead the
+    // number of them is mixed into the hash of the next entry so the spacing between changes still has to repeat.
+    std::vector<uint64_t> history;
+    std::vector<uint64_t> historyTicks;
+    std::vector<size_t> previousMatch;
+    std::unordered_map<uint64_t, size_t> lastMatch;
+    uint64_t quietTicks = 0;
+    while (hasPendingUpdates() && result.ticks < maxTicks) {
+        const uint64_t skippedTicks = skipQuietTicks(maxTicks - result.ticks);
+        if (skippedTicks != 0) {
+            result.ticks += skippedTicks;
+            continue;
+        }
+        const size_t replayIndex = replayIndex_;
+        const size_t editReplayIndex = editReplayIndex_;
+        tick();
+        ++result.ticks;
+
+        if (replayIndex_ != replayIndex || editReplayIndex_ != editReplayIndex) {
+            // The replayed presses change the board from outside, so the ticks before them can't be part of a cycle.
+            history.clear();
+            historyTicks.clear();
+            previousMatch.clear();
+            lastMatch.clear();
+            quietTicks = 0;
+        }
+        if (changeHash_ == 0) {
+            ++quietTicks;
+            continue;
+        }
+        const uint64_t hash = changeHash_ ^ mixHash(quietTicks);
+        quietTicks = 0;
+
+        const size_t t = history.size();
+        history.push_back(hash);
+        historyTicks.push_back(result.ticks);
+        auto match = lastMatch.find(hash);
+        previousMatch.push_back(match != lastMatch.end() ? match->second : t);
+        lastMatch[hash] = t;
+
+        // A hash can show up more than once in a cycle, so a few earlier matches are checked for the period.
+        size_t candidate = previousMatch[t];
+        for (int i = 0; i < MAX_CYCLE_CANDIDATES && candidate != t && (t - candidate) * 2 <= t + 1; ++i) {
+            const size_t period = t - candidate;
+            if (std::equal(history.end() - period, history.end(), history.end() - period * 2)) {
+                result.period = historyTicks[t] - historyTicks[candidate];
+                break;
+            }
+            if (previousMatch[candidate] == candidate) {
+                break;
+            }
+            candidate = previousMatch[candidate];
+        }
+        if (result.period != 0) {
+            break;
+        }
+    }
+
+    if (result.period != 0) {
+        // Run through the cycle once more to find which chunks change, this ends up in the same state.
+        findingCycleChunks_ = true;
+        for (uint64_t i = 0; i < result.period; ++i) {
+            tick();
+        }
+        result.ticks += result.period;
+        findingCycleChunks_ = false;
+        for (auto slot : cycleChunks_) {
+            chunks_[slot].inCycle = false;
+            result.cycleChunks.push_back(chunks_[slot].coords);
+        }
+        cycleChunks_.clear();
+        std::sort(result.cycleChunks.begin(), result.cycleChunks.end());
+    }
+    result.stable = !hasPendingUpdates();
+
+    deferDrawDirty_ = detachedDrawing_;
+    if (!detachedDrawing_) {
+        flushDrawDirty();
+    }
+    return result;
+}
+
+void Simulator::setDetachedDrawing(bool detachedDrawing) {
+    detachedDrawing_ = detachedDrawing;
+    deferDrawDirty_ = detachedDrawing;
+    if (!detachedDrawing) {
+        flushDrawDirty();
+    }
+}
+
+bool Simulator::getDetachedDrawing() const {
+    return detachedDrawing_;
+}
+
+void Simulator::flushDrawDirty() {
+    for (auto slot : drawDirtyChunks_) {
+        chunks_[slot].drawDirty = false;
+        accessSlotChunk(slot).markTileDirty(0);
+    }
+    drawDirtyChunks_.clear();
+
+    // The chunks are up to date for drawing now, so the changes don't need to be visited.
+    for (auto slot : changedChunks_) {
+        chunks_[slot].changed = false;
+    }
+    changedChunks_.clear();
+}
+
+void Simulator::visitChangedChunks(const std::function<void(ChunkCoords::repr coords, const TileData* tiles)>& func) {
+    for (auto slot : changedChunks_) {
+        chunks_[slot].changed = false;
+        func(chunks_[slot].coords, chunks_[slot].chunk->tiles_);
+    }
+    changedChunks_.clear();
+}
+
+void Simulator::markChunkChanged(ChunkCoords::repr coords) {
+    const int32_t slot = findSlot(coords);
+    if (detachedDrawing_ && slot >= 0 && !chunks_[slot].changed) {
+        chunks_[slot].changed = true;
+        changedChunks_.push_back(static_cast<uint32_t>(slot));
+    }
+}
+
+int32_t Simulator::findSlot(ChunkCoords::repr coords) {
+    auto slot = chunkSlots_.find(coords);
+    if (slot != chunkSlots_.end()) {
+        return static_cast<int32_t>(slot->second);
+    }
+    // Loading a chunk modifies the board, which is only safe on the thread that owns it.
+    Chunk* chunk = (detachedDrawing_ ? board_.findLoadedChunk(coords) : board_.findChunk(coords));
+    if (chunk == nullptr) {
+        return NEIGHBOR_NONE;
+    }
+
+    // The adjacent slots may have cached this chunk as missing, so drop those misses.
+    for (int i = 0; i < 4; ++i) {
+        auto neighbor = chunkSlots_.find(ChunkCoords::pack(ChunkCoords::x(coords) + sim::DIRECTION_X[i], ChunkCoords::y(coords) + sim::DIRECTION_Y[i]));
+        if (neighbor != chunkSlots_.end()) {
+            int32_t& backNeighbor = chunks_[neighbor->second].neighbors[sim::opposite(static_cast<Direction::t>(i))];
+            if (backNeighbor == NEIGHBOR_NONE) {
+                backNeighbor = NEIGHBOR_UNKNOWN;
+            }
+        }
+    }
+    chunks_.emplace_back(chunk, coords);
+    chunkSlots_.emplace(coords, static_cast<uint32_t>(chunks_.size() - 1));
+    residency_.markActive(static_cast<uint32_t>(chunks_.size() - 1), tickCount_);
+    ++residentChunkCount_;
+    indexInputs(static_cast<uint32_t>(chunks_.size() - 1));
+    return static_cast<int32_t>(chunks_.size() - 1);
+}
+
+Chunk& Simulator::accessSlotChunk(uint32_t slot) {
+    auto& chunkState = chunks_[slot];
+    if (chunkState.chunk == nullptr) {
+        // Only the simulation thread can hand a load over to the thread that owns the board, the chunks a worker
+        // needs are loaded in `resolveNeighbors()` and `updateNets()` before the tasks start.
+        assert(!inWorkerTask);
+        missingChunks_.push_back(slot);
+        loadMissingChunks();
+    }
+    return *chunkState.chunk;
+}
+
+void Simulator::queueChunkLoad(uint32_t slot) {
+    if (chunks_[slot].chunk == nullptr) {
+        missingChunks_.push_back(slot);
+    }
+}
+
+void Simulator::loadMissingChunks() {
+    if (missingChunks_.empty()) {
+        return;
+    }
+    std::sort(missingChunks_.begin(), missingChunks_.end());
+    missingChunks_.erase(std::unique(missingChunks_.begin(), missingChunks_.end()), missingChunks_.end());
+
+    // Each task handed to the board thread waits on that thread, so all of the chunks go over in one task.
+    const std::function<void()> loadChunks = [this]() {
+        for (auto slot : missingChunks_) {
+            chunks_[slot].chunk = &board_.accessChunk(chunks_[slot].coords);
+        }
+    };
+    if (boardTaskRunner_) {
+        boardTaskRunner_(loadChunks);
+    } else {
+        loadChunks();
+    }
+    for (auto slot : missingChunks_) {
+        residency_.markActive(slot, tickCount_);
+        ++residentChunkCount_;
+    }
+    missingChunks_.clear();
+}
+
+void Simulator::resolveProbe(uint32_t probeId) {
+    auto& probe = probes_[probeId];
+    probe.slot = findSlot(ChunkCoords::pack(probe.pos.x >> WIDTH_LOG2, probe.pos.y >> WIDTH_LOG2));
+    probe.index = static_cast<uint16_t>((probe.pos.x & (Chunk::WIDTH - 1)) + (probe.pos.y & (Chunk::WIDTH - 1)) * Chunk::WIDTH);
+    if (probe.slot < 0) {
+        return;
+    }
+    const TileRef tile = {static_cast<uint32_t>(probe.slot), probe.index};
+    chunks_[probe.slot].probed[probe.index] = true;
+    probeTiles_.emplace(tileKey(tile), probeId);
+    const TileData tileData = accessTileData(tile);
+    probe.lastState = static_cast<State::t>(probe.channel == 0 ? tileData.state1 : tileData.state2);
+    waveform_.record(tickCount_, probeId, probe.lastState);
+}
+
+void Simulator::sampleProbes(TileRef tile) {
+    const TileData tileData = accessTileData(tile);
+    auto range = probeTiles_.equal_range(tileKey(tile));
+    for (auto it = range.first; it != range.second; ++it) {
+        auto& probe = probes_[it->second];
+        const auto state = static_cast<State::t>(probe.channel == 0 ? tileData.state1 : tileData.state2);
+        if (state != probe.lastState) {
+            probe.lastState = state;
+            waveform_.record(tickCount_, it->second, state);
+        }
+    }
+}
+
+void Simulator::indexInputs(uint32_t slot) {
+    const TileData* tiles = chunks_[slot].chunk->tiles_;
+    for (unsigned int i = 0; i < CHUNK_AREA; ++i) {
+        if (tiles[i].id == TileId::inSwitch || tiles[i].id == TileId::inButton) {
+            indexInput({slot, static_cast<uint16_t>(i)});
+        }
+    }
+}
+
+void Simulator::indexInput(TileRef tile) {
+    const TileData tileData = accessTileData(tile);
+    const bool isInput = (tileData.id == TileId::inSwitch || tileData.id == TileId::inButton);
+    const char keycode = static_cast<char>(tileData.meta);
+    auto indexed = inputKeycodes_.find(tileKey(tile));
+    if (indexed != inputKeycodes_.end()) {
+        if (isInput && indexed->second == keycode) {
+            return;
+        }
+        auto& inputs = keyInputs_[indexed->second];
+        auto input = std::find(inputs.begin(), inputs.end(), tile);
+        assert(input != inputs.end());
+        *input = inputs.back();
+        inputs.pop_back();
+        inputKeycodes_.erase(indexed);
+    }
+    if (isInput) {
+        keyInputs_[keycode].push_back(tile);
+        inputKeycodes_.emplace(tileKey(tile), keycode);
+    }
+}
+
+void Simulator::toggleInputs(char keycode) {
+    // Chunks loaded since the last press only get a slot if they have an input in them.
+    for (auto coords : unindexedChunks_) {
+        const Chunk* chunk = board_.findLoadedChunk(coords);
+        if (chunk == nullptr || chunkSlots_.count(coords) != 0) {
+            continue;
+        }
+        for (unsigned int i = 0; i < CHUNK_AREA; ++i) {
+            if (chunk->tiles_[i].id == TileId::inSwitch || chunk->tiles_[i].id == TileId::inButton) {
+                findSlot(coords);
+                break;
+            }
+        }
+    }
+    unindexedChunks_.clear();
+
+    auto inputs = keyInputs_.find(keycode);
+    if (inputs == keyInputs_.end()) {
+        return;
+    }
+    for (const auto& tile : inputs->second) {
+        TileData& tileData = accessTileData(tile);
+        if (tileData.id == TileId::inSwitch) {
+            tileData.state1 = (tileData.state1 == State::high ? State::low : State::high);
+        } else {
+            tileData.state1 = State::high;
+        }
+        markTileDirty(tile);
+        // Gates right next to the input see the change in the same tick as the nets it drives.
+        queueChunkUpdate(chunks_[tile.slot].coords, tile.index, true);
+    }
+}
+
+void Simulator::replayInputs() {
+    const auto& events = inputLog_.getEvents();
+    while (replayIndex_ < events.size() && inputStartTick_ + events[replayIndex_].tick <= tickCount_) {
+        toggleInputs(events[replayIndex_].keycode);
+        ++replayIndex_;
+    }
+}
+
+bool Simulator::isReplaying() const {
+    return inputMode_ == InputMode::replay && replayIndex_ < inputLog_.getEvents().size();
+}
+
+uint64_t Simulator::getTicksUntilReplay() const {
+    uint64_t replayTick = std::numeric_limits<uint64_t>::max();
+    if (isReplaying()) {
+        replayTick = inputStartTick_ + inputLog_.getEvents()[replayIndex_].tick;
+    }
+    if (editReplayIndex_ < stateEdits_.size()) {
+        replayTick = std::min(replayTick, stateEdits_[editReplayIndex_].tick);
+    }
+    if (replayTick == std::numeric_limits<uint64_t>::max()) {
+        return replayTick;
+    }
+    return (replayTick > tickCount_ ? replayTick - tickCount_ : 0);
+}
+
+uint64_t Simulator::skipQuietTicks(uint64_t maxTicks) {
+    if (!activeChunks_.empty() || !timedUpdates_.empty()) {
+        return 0;
+    }
+    // Nothing changes until the next replayed key press (if there is one), so the ticks up to it would be empty.
+    const uint64_t emptyTicks = std::min(maxTicks, getTicksUntilReplay());
+    if (emptyTicks == 0) {
+        return 0;
+    }
+    // The states stay the same over these ticks, so one checkpoint at the first interval in them is enough for a
+    // rewind into the range to start close by.
+    const uint64_t endTick = tickCount_ + emptyTicks;
+    if (checkpointInterval_ != 0) {
+        const uint64_t checkpointTick = (tickCount_ / checkpointInterval_ + 1) * checkpointInterval_;
+        if (checkpointTick <= endTick) {
+            tickCount_ = checkpointTick;
+            saveCheckpoint();
+        }
+    }
+    tickCount_ = endTick;
+    if (chunkProfiling_) {
+        profiledTickCount_ += emptyTicks;
+    }
+    timedUpdates_.clear(tickCount_);
+    sleepChunks();
+    return emptyTicks;
+}
+
+void Simulator::recordTileEdit(TileRef tile, uint64_t updateDelay, bool adjacentUpdates) {
+    const TileData tileData = accessTileData(tile);
+    stateEdits_.push_back({tickCount_, false, '\0', tile, tileData.state1, tileData.state2, updateDelay, adjacentUpdates});
+    editReplayIndex_ = stateEdits_.size();
+}
+
+void Simulator::applyStateEdit(const StateEdit& edit) {
+    if (edit.keyPress) {
+        toggleInputs(edit.keycode);
+        return;
+    }
+    TileData& tileData = accessTileData(edit.tile);
+    tileData.state1 = edit.state1;
+    tileData.state2 = edit.state2;
+    markTileDirty(edit.tile);
+    if (edit.updateDelay <= 1) {
+        queueChunkUpdate(chunks_[edit.tile.slot].coords, edit.tile.index, edit.adjacentUpdates);
+    } else {
+        scheduleTileUpdate(edit.tile, edit.updateDelay, edit.adjacentUpdates);
+    }
+}
+
+void Simulator::saveCheckpoint() {
+    auto& snapshot = checkpointSnapshot_;
+    snapshot.tick = tickCount_;
+    snapshot.tiles.resize(chunks_.size() * CHUNK_AREA);
+    static_assert(sizeof(TileData) == sizeof(uint32_t), "TileData must pack into 32 bits.");
+    for (uint32_t slot = 0; slot < chunks_.size(); ++slot) {
+        // An unloaded chunk left its tiles here when it unloaded, and they haven't changed since.
+        if (chunks_[slot].chunk != nullptr) {
+            std::memcpy(&snapshot.tiles[slot * CHUNK_AREA], chunks_[slot].chunk->tiles_, CHUNK_AREA * sizeof(TileData));
+        }
+    }
+    snapshot.queuedTiles.clear();
+    for (auto slot : activeChunks_) {
+        for (auto index : chunks_[slot].pendingUpdates) {
+            snapshot.queuedTiles.push_back({slot, index});
+        }
+    }
+    snapshot.timedTiles.clear();
+    timedUpdates_.forEach([&snapshot](uint64_t tick, const TimedUpdate& update) {
+        snapshot.timedTiles.push_back({tick, update.tile, update.releaseButton, update.adjacentUpdates});
+    });
+    checkpoints_.add(snapshot);
+
+    // Edits from before the oldest checkpoint can't be replayed anymore.
+    size_t numDropped = 0;
+    while (numDropped < stateEdits_.size() && stateEdits_[numDropped].tick < checkpoints_.getOldestTick()) {
+        ++numDropped;
+    }
+    stateEdits_.erase(stateEdits_.begin(), stateEdits_.begin() + numDropped);
+    editReplayIndex_ -= std::min(editReplayIndex_, numDropped);
+}
+
+void Simulator::clearCheckpoints() {
+    checkpoints_.clear();
+    stateEdits_.clear();
+    editReplayIndex_ = 0;
+}
+
+void Simulator::restoreSnapshot(const sim::CheckpointLog::Snapshot& snapshot) {
+    // The waveform from this tick on gets replaced, starting with the restored states.
+    tickCount_ = snapshot.tick;
+    if (!probes_.empty()) {
+        waveform_.recordRewind(tickCount_);
+    }
+    // Slots only get added until a reset, so every slot in the snapshot still refers to the same chunk.
+    assert(snapshot.tiles.size() <= chunks_.size() * CHUNK_AREA);
+    for (uint32_t slot = 0; slot < snapshot.tiles.size() / CHUNK_AREA; ++slot) {
+        Chunk& chunk = accessSlotChunk(slot);
+        for (unsigned int i = 0; i < CHUNK_AREA; ++i) {
+            const uint32_t* tile = &snapshot.tiles[slot * CHUNK_AREA + i];
+            if (std::memcmp(&chunk.tiles_[i], tile, sizeof(TileData)) != 0) {
+                std::memcpy(&chunk.tiles_[i], tile, sizeof(TileData));
+                markTileDirty({slot, static_cast<uint16_t>(i)});
+            }
+        }
+    }
+    // The slots added since the checkpoint keep their tiles, but the copies kept for the unloaded ones are gone now.
+    for (uint32_t slot = static_cast<uint32_t>(snapshot.tiles.size() / CHUNK_AREA); slot < chunks_.size(); ++slot) {
+        accessSlotChunk(slot);
+    }
+
+    for (auto slot : activeChunks_) {
+        chunks_[slot].pendingUpdates.clear();
+        chunks_[slot].queued.reset();
+        chunks_[slot].active = false;
+    }
+    activeChunks_.clear();
+    for (const auto& tile : snapshot.queuedTiles) {
+        queueTile(tile);
+    }
+    timedUpdates_.clear(snapshot.tick);
+    for (const auto& timedTile : snapshot.timedTiles) {
+        timedUpdates_.schedule(timedTile.tick, {timedTile.tile, timedTile.releaseButton, timedTile.adjacentUpdates});
+    }
+    // The nets remember the state they last wrote and the tick they were last updated, neither holds after this.
+    netlist_.resetStates();
+
+    // Restoring a tile samples the probes on it, this catches any probe with a state that changed without an update.
+    for (const auto& probe : probes_) {
+        if (probe.slot >= 0) {
+            sampleProbes({static_cast<uint32_t>(probe.slot), probe.index});
+        }
+    }
+}
+
+void Simulator::sleepChunks() {
+    if (!detachedDrawing_) {
+        unloadSleepingChunks();
+    }
+    residency_.findSleepers(tickCount_, sleepingChunks_);
+    for (auto slot : sleepingChunks_) {
+        sleepSlot(slot);
+    }
+    sleepingChunks_.clear();
+
+    if (maxResidentChunks_ != 0 && residentChunkCount_ > maxResidentChunks_) {
+        // Go a bit under the limit, so the next few chunks that load don't push it right back over.
+        residency_.findEvictions(tickCount_, MIN_EVICT_QUIET_TICKS, residentChunkCount_ - maxResidentChunks_ * 3 / 4, sleepingChunks_);
+        for (auto slot : sleepingChunks_) {
+            sleepSlot(slot);
+        }
+        sleepingChunks_.clear();
+    }
+}
+
+void Simulator::sleepSlot(uint32_t slot) {
+    auto& chunkState = chunks_[slot];
+    if (chunkState.active) {
+        residency_.markActive(slot, tickCount_);
+        return;
+    }
+    // The queues get allocated again when the chunk wakes up. The wire summary stays, so the nets through the chunk
+    // can still be joined without loading it.
+    std::vector<uint16_t>().swap(chunkState.pendingUpdates);
+    std::vector<uint16_t>().swap(chunkState.currentUpdates);
+    // The board can't be changed from here with detached drawing, the chunk waits for `unloadSleepingChunks()`.
+    if (detachedDrawing_ || !unloadSlot(slot)) {
+        residentSleepers_.push_back(slot);
+    }
+}
+
+bool Simulator::unloadSlot(uint32_t slot) {
+    auto& chunkState = chunks_[slot];
+    if (chunkState.chunk == nullptr) {
+        return true;
+    }
+    if (chunkState.drawDirty || chunkState.changed) {
+        return false;
+    }
+    if (checkpointInterval_ != 0) {
+        // The next checkpoint takes the tiles from here instead of loading the chunk again.
+        checkpointSnapshot_.tiles.resize(std::max(checkpointSnapshot_.tiles.size(), chunks_.size() * CHUNK_AREA));
+        std::memcpy(&checkpointSnapshot_.tiles[slot * CHUNK_AREA], chunkState.chunk->tiles_, CHUNK_AREA * sizeof(TileData));
+    }
+    // The nets through the chunk are kept, the tiles in it only change after it loads again (the nets resolve from
+    // the tiles, so a change that reaches the chunk loads it).
+    if (!board_.unloadChunk(chunkState.coords)) {
+        return false;
+    }
+    chunkState.chunk = nullptr;
+    --residentChunkCount_;
+    return true;
+}
+
+int32_t Simulator::getNeighborSlot(uint32_t slot, Direction::t dir) {
+    int32_t neighbor = chunks_[slot].neighbors[dir];
+    if (neighbor == NEIGHBOR_UNKNOWN) {
+        const ChunkCoords::repr coords = chunks_[slot].coords;
+        neighbor = findSlot(ChunkCoords::pack(ChunkCoords::x(coords) + sim::DIRECTION_X[dir], ChunkCoords::y(coords) + sim::DIRECTION_Y[dir]));
+        chunks_[slot].neighbors[dir] = neighbor;
+    }
+    return neighbor;
+}
+
+bool Simulator::getAdjacent(TileRef tile, Direction::t dir, TileRef& adjacent) {
+    int x = tile.index % Chunk::WIDTH + sim::DIRECTION_X[dir];
+    int y = tile.index / Chunk::WIDTH + sim::DIRECTION_Y[dir];
+    if (x >= 0 && x < Chunk::WIDTH && y >= 0 && y < Chunk::WIDTH) {
+        adjacent = {tile.slot, static_cast<uint16_t>(y * Chunk::WIDTH + x)};
+        return true;
+    }
+    int32_t neighbor = getNeighborSlot(tile.slot, dir);
+    if (neighbor < 0) {
+        return false;
+    }
+    x &= Chunk::WIDTH - 1;
+    y &= Chunk::WIDTH - 1;
+    adjacent = {static_cast<uint32_t>(neighbor), static_cast<uint16_t>(y * Chunk::WIDTH + x)};
+    return true;
+}
+
+TileData& Simulator::accessTileData(TileRef tile) {
+    return accessSlotChunk(tile.slot).tiles_[tile.index];
+}
+
+void Simulator::markTileDirty(TileRef tile) {
+    auto& chunkState = chunks_[tile.slot];
+    if (findingCycleChunks_ && !chunkState.inCycle) {
+        chunkState.inCycle = true;
+        cycleChunks_.push_back(tile.slot);
+    }
+    if (!deferDrawDirty_) {
+        accessSlotChunk(tile.slot).markTileDirty(tile.index);
+    } else if (!chunkState.drawDirty) {
+        chunkState.drawDirty = true;
+        drawDirtyChunks_.push_back(tile.slot);
+    }
+    if (detachedDrawing_ && !chunkState.changed) {
+        chunkState.changed = true;
+        changedChunks_.push_back(tile.slot);
+    }
+    if (chunkState.probed[tile.index]) {
+        sampleProbes(tile);
+    }
+}
+
+void Simulator::recordChange(uint64_t key, State::t state) {
+    changeHash_ += mixHash(key << 2 | state);
+}
+
+uint64_t Simulator::tileKey(TileRef tile) {
+    // Nets use their id as the key, the tiles are kept in a separate range above them.
+    return (1ull << 48) | static_cast<uint64_t>(tile.slot) << 16 | tile.index;
+}
+
+void Simulator::queueTile(TileRef tile) {
+    auto& chunkState = chunks_[tile.slot];
+    if (chunkState.queued[tile.index] || accessSlotChunk(tile.slot).tiles_[tile.index].id == TileId::blank) {
+        return;
+    }
+    chunkState.queued[tile.index] = true;
+    chunkState.pendingUpdates.push_back(tile.index);
+    if (!chunkState.active) {
+        chunkState.active = true;
+        activeChunks_.push_back(tile.slot);
+    }
+}
+
+bool Simulator::checkVisited(TileRef tile, int channel) {
+    auto& chunkState = chunks_[tile.slot];
+    const size_t bit = tile.index * 2 + channel;
+    if (chunkState.visited[bit]) {
+        return true;
+    }
+    chunkState.visited[bit] = true;
+    if (!chunkState.touched) {
+        chunkState.touched = true;
+        touchedChunks_.push_back(tile.slot);
+    }
+    return false;
+}
+
+void Simulator::resolveNeighbors(const std::vector<uint32_t>& tickChunks) {
+    // Finding a new chunk clears the cached misses, so repeat until no more chunks get added.
+    size_t numChunks;
+    do {
+        numChunks = chunks_.size();
+        for (auto slot : tickChunks) {
+            for (int i = 0; i < 4; ++i) {
+                getNeighborSlot(slot, static_cast<Direction::t>(i));
+            }
+        }
+    } while (numChunks != chunks_.size());
+
+    // The workers can't load a chunk, so any sleeping neighbors that were unloaded get loaded now.
+    if (residentChunkCount_ < chunks_.size()) {
+        for (auto slot : tickChunks) {
+            for (auto neighbor : chunks_[slot].neighbors) {
+                if (neighbor >= 0) {
+                    queueChunkLoad(static_cast<uint32_t>(neighbor));
+                }
+            }
+        }
+        loadMissingChunks();
+    }
+}
+
+void Simulator::runTasks(size_t numTasks, size_t blockSize, const sim::WorkerPool::TaskFunction& func) {
+    const size_t numBlocks = (numTasks + blockSize - 1) / blockSize;
+    if (taskOutputs_.size() < numBlocks) {
+        taskOutputs_.resize(numBlocks);
+    }
+    if (workerPool_) {
+        workerPool_->run(numTasks, blockSize, [&func](size_t begin, size_t end, unsigned int worker) {
+            inWorkerTask = true;
+            func(begin, end, worker);
+            inWorkerTask = false;
+        });
+    } else if (numTasks > 0) {
+        func(0, numTasks, 0);
+    }
+}
+
+void Simulator::evaluateGates(bool extraLogicStates) {
+    // The gates only read from the board here, the neighbors of each chunk have been found already if this runs
+    // on multiple threads. The task captures no more than fits in the std::function without an allocation.
+    runTasks(tickChunks_.size(), GATE_BLOCK_SIZE, [this, extraLogicStates](size_t begin, size_t end, unsigned int /*worker*/) {
+        auto& output = taskOutputs_[begin / GATE_BLOCK_SIZE];
+        for (size_t i = begin; i < end; ++i) {
+            const uint32_t slot = tickChunks_[i];
+            const auto startTime = (chunkProfiling_ ? ProfileClock::now() : ProfileClock::time_point());
+            for (auto tileIndex : chunks_[slot].currentUpdates) {
+                TileRef gate = {slot, tileIndex};
+                const TileData tileData = accessTileData(gate);
+                if (!sim::isGate(tileData.id)) {
+                    continue;
+                }
+                // Only the three input sides are read (starting from the right of the output), then the table has
+                // the next state.
+                unsigned int inputs = 0;
+                for (unsigned int j = 1; j < 4; ++j) {
+                    const Direction::t side = static_cast<Direction::t>((tileData.dir + j) % 4);
+                    TileRef adjacent;
+                    if (getAdjacent(gate, side, adjacent)) {
+                        inputs |= sim::packGateInput(j, sim::outputToward(accessTileData(adjacent), side));
+                    }
+                }
+                State::t nextState = sim::lookupGate(tileData.id, inputs, extraLogicStates);
+                if (nextState != tileData.state1) {
+                    output.gateTransitions.emplace_back(gate, nextState);
+                }
+            }
+            if (chunkProfiling_) {
+                output.slotTimes.emplace_back(slot, nanosecondsSince(startTime));
+            }
+        }
+    });
+
+    // The transitions are applied after all gates are evaluated so that the evaluation order does not matter.
+    const size_t numBlocks = (tickChunks_.size() + GATE_BLOCK_SIZE - 1) / GATE_BLOCK_SIZE;
+    for (size_t i = 0; i < numBlocks; ++i) {
+        for (const auto& transition : taskOutputs_[i].gateTransitions) {
+            accessTileData(transition.first).state1 = transition.second;
+            recordChange(tileKey(transition.first), transition.second);
+            markTileDirty(transition.first);
+            changedGates_.push_back(transition.first);
+        }
+        for (const auto& slotTime : taskOutputs_[i].slotTimes) {
+            chunks_[slotTime.first].activity.nanoseconds += slotTime.second;
+        }
+        taskOutputs_[i].gateTransitions.clear();
+        taskOutputs_[i].slotTimes.clear();
+    }
+}
+
+void Simulator::propagateFrom(TileRef source, Direction::t dir) {
+    TileRef target;
+    if (!getAdjacent(source, dir, target)) {
+        return;
+    }
+    const TileData targetData = accessTileData(target);
+    const Direction::t backDir = sim::opposite(dir);
+    if (sim::isWire(targetData.id)) {
+        if (sim::wireSides(targetData) & (1 << backDir)) {
+            scheduleNet(target, sim::wireChannel(targetData, backDir));
+        }
+    } else if (sim::isGate(targetData.id)) {
+        if (targetData.dir != backDir) {
+            queueTile(target);
+        }
+    } else if (targetData.id == TileId::outLed) {
+        ledUpdates_.push_back(target);
+    }
+}
+
+void Simulator::editTile(TileRef tile) {
+    // Only the fragments with a wire on the tile are dropped, the rest of their nets get split up along the links
+    // between the fragments. With stitched nets every fragment in the chunk goes, since the segments there change.
+    // The dropped wires are followed again on the next tick to join back the pieces they connected.
+    if (stitchedNets_) {
+        netlist_.removeFragmentsIn(tile.slot, editedWires_);
+    } else {
+        netlist_.removeFragmentsAt(tile, editedWires_);
+    }
+    chunks_[tile.slot].nets.invalidate();
+
+    // A new wire gets merged into the adjacent nets once it's updated, but new endpoints are added right away.
+    const TileData tileData = accessTileData(tile);
+    if (sim::isWire(tileData.id) || tileData.id == TileId::blank || tileData.id == TileId::label) {
+        return;
+    }
+    for (int i = 0; i < 4; ++i) {
+        TileRef adjacent;
+        if (!getAdjacent(tile, static_cast<Direction::t>(i), adjacent)) {
+            continue;
+        }
+        const TileData adjacentData = accessTileData(adjacent);
+        const Direction::t backDir = sim::opposite(static_cast<Direction::t>(i));
+        if (!sim::isWire(adjacentData.id) || !(sim::wireSides(adjacentData) & (1 << backDir))) {
+            continue;
+        }
+        const uint32_t fragmentId = netlist_.getFragmentId(adjacent, sim::wireChannel(adjacentData, backDir));
+        if (fragmentId != sim::WireNetlist::NO_NET) {
+            netlist_.addEndpoint(fragmentId, {tile, static_cast<Direction::t>(i)});
+        }
+    }
+}
+
+void Simulator::followEditedWires() {
+    for (const auto& wire : editedWires_) {
+        const TileData wireData = accessTileData(wire.tile);
+        if (!sim::isWire(wireData.id) || (wire.channel == 1 && wireData.id != TileId::wireCrossover)) {
+            continue;
+        }
+        if (netlist_.getFragmentId(wire.tile, wire.channel) == sim::WireNetlist::NO_NET) {
+            if (stitchedNets_) {
+                buildStitchedNet(wire.tile, wire.channel);
+            } else {
+                buildNet(wire.tile, wire.channel);
+            }
+        }
+    }
+    editedWires_.clear();
+}
+
+uint32_t Simulator::buildNet(TileRef start, int channel) {
+    assert(wireNodes_.empty() && fragmentSeeds_.empty() && netWires_.empty() && netEndpoints_.empty() && mergeNets_.empty());
+
+    // Depth-first traversal along the wire to find the endpoints. Wires that already belong to a net are not
+    // followed, instead the fragment they are in gets linked (which merges the nets). A fragment stops growing at
+    // `MAX_FRAGMENT_WIRES`, the wires it couldn't take start the next ones.
+    uint32_t netId = sim::WireNetlist::NO_NET;
+    fragmentSeeds_.push_back({start, static_cast<uint8_t>(channel)});
+    while (!fragmentSeeds_.empty()) {
+        const auto seed = fragmentSeeds_.back();
+        fragmentSeeds_.pop_back();
+        if (checkVisited(seed.tile, seed.channel)) {
+            continue;
+        }
+        wireNodes_.push_back(seed);
+        while (!wireNodes_.empty()) {
+            const auto node = wireNodes_.back();
+            wireNodes_.pop_back();
+            netWires_.push_back(node);
+
+            const uint8_t sides = sim::channelSides(accessTileData(node.tile), node.channel);
+            for (int i = 0; i < 4; ++i) {
+                TileRef adjacent;
+                if (!(sides & (1 << i)) || !getAdjacent(node.tile, static_cast<Direction::t>(i), adjacent)) {
+                    continue;
+                }
+                const TileData adjacentData = accessTileData(adjacent);
+                const Direction::t backDir = sim::opposite(static_cast<Direction::t>(i));
+                if (sim::isWire(adjacentData.id)) {
+                    if (sim::wireSides(adjacentData) & (1 << backDir)) {
+                        const int adjacentChannel = sim::wireChannel(adjacentData, backDir);
+                        const uint32_t adjacentFragment = netlist_.getFragmentId(adjacent, adjacentChannel);
+                        if (adjacentFragment != sim::WireNetlist::NO_NET) {
+                            mergeNets_.push_back(adjacentFragment);
+                        } else if (netWires_.size() + wireNodes_.size() >= MAX_FRAGMENT_WIRES) {
+                            fragmentSeeds_.push_back({adjacent, static_cast<uint8_t>(adjacentChannel)});
+                        } else if (!checkVisited(adjacent, adjacentChannel)) {
+                            wireNodes_.push_back({adjacent, static_cast<uint8_t>(adjacentChannel)});
+                        }
+                    }
+                } else if (sim::isInput(adjacentData.id) || sim::isGate(adjacentData.id) || adjacentData.id == TileId::outLed) {
+                    netEndpoints_.push_back({adjacent, backDir});
+                }
+            }
+        }
+        netId = addNetFragment();
+    }
+
+    // The merged nets may have been updated already this tick, but they need another update now that they changed.
+    netlist_.getNet(netId).lastTick = 0;
+    return netId;
+}
+
+uint32_t Simulator::addNetFragment() {
+    // The wires that touch this fragment but are not in a net yet link back to it once they are added.
+    std::sort(mergeNets_.begin(), mergeNets_.end());
+    mergeNets_.erase(std::unique(mergeNets_.begin(), mergeNets_.end()), mergeNets_.end());
+    const uint32_t netId = netlist_.addNet(netWires_, netEndpoints_, mergeNets_);
+    netWires_.clear();
+    netEndpoints_.clear();
+    mergeNets_.clear();
+    return netId;
+}
+
+const sim::ChunkNets& Simulator::accessChunkNets(uint32_t slot) {
+    auto& chunkState = chunks_[slot];
+    if (!chunkState.nets.isBuilt()) {
+        chunkState.nets.build(accessSlotChunk(slot).tiles_);
+    }
+    return chunkState.nets;
+}
+
+uint32_t Simulator::buildStitchedNet(TileRef start, int channel) {
+    assert(segmentNodes_.empty() && segmentSeeds_.empty() && netWires_.empty() && netEndpoints_.empty() && mergeNets_.empty());
+
+    // Same as `buildNet()`, but the traversal is over the wire segments in each chunk. A segment is marked as
+    // visited by the first wire it has, and the ports on the edge lead to the segments in neighboring chunks. The
+    // fragments are made of whole segments, the edits drop all of the fragments in a chunk before the segments
+    // there change.
+    uint32_t netId = sim::WireNetlist::NO_NET;
+    segmentSeeds_.emplace_back(start.slot, accessChunkNets(start.slot).getSegmentId(start.index, channel));
+    while (!segmentSeeds_.empty()) {
+        const auto seed = segmentSeeds_.back();
+        segmentSeeds_.pop_back();
+        const auto& seedWire = accessChunkNets(seed.first).getWires(chunks_[seed.first].nets.getSegment(seed.second))[0];
+        if (checkVisited({seed.first, seedWire.index}, seedWire.channel)) {
+            continue;
+        }
+        segmentNodes_.push_back(seed);
+        while (!segmentNodes_.empty()) {
+            const auto node = segmentNodes_.back();
+            segmentNodes_.pop_back();
+
+            // Finding a neighbor can add more chunks, so the segment is copied and the summary looked up again after.
+            const sim::ChunkNets::Segment segment = accessChunkNets(node.first).getSegment(node.second);
+            const sim::ChunkNets::LocalWire* wires = chunks_[node.first].nets.getWires(segment);
+            for (uint32_t i = 0; i < segment.wireCount; ++i) {
+                assert(netlist_.getFragmentId({node.first, wires[i].index}, wires[i].channel) == sim::WireNetlist::NO_NET);
+                netWires_.push_back({{node.first, wires[i].index}, wires[i].channel});
+            }
+            const sim::ChunkNets::LocalEndpoint* endpoints = chunks_[node.first].nets.getEndpoints(segment);
+            for (uint32_t i = 0; i < segment.endpointCount; ++i) {
+                netEndpoints_.push_back({{node.first, endpoints[i].index}, endpoints[i].wireDir});
+            }
+
+            for (uint32_t i = 0; i < segment.portCount; ++i) {
+                const sim::ChunkNets::Port port = chunks_[node.first].nets.getPorts(segment)[i];
+                const int32_t neighbor = getNeighborSlot(node.first, port.side);
+                if (neighbor < 0) {
+                    continue;
+                }
+                const Direction::t backDir = sim::opposite(port.side);
+                const TileRef adjacent = {static_cast<uint32_t>(neighbor), static_cast<uint16_t>(sim::ChunkNets::portToTileIndex(backDir, port.offset))};
+                const TileData adjacentData = accessTileData(adjacent);
+                if (sim::isWire(adjacentData.id)) {
+                    if (sim::wireSides(adjacentData) & (1 << backDir)) {
+                        const int adjacentChannel = sim::wireChannel(adjacentData, backDir);
+                        const uint32_t adjacentFragment = netlist_.getFragmentId(adjacent, adjacentChannel);
+                        if (adjacentFragment != sim::WireNetlist::NO_NET) {
+                            mergeNets_.push_back(adjacentFragment);
+                            continue;
+                        }
+                        const auto& neighborNets = accessChunkNets(adjacent.slot);
+                        const uint16_t neighborSegment = neighborNets.getSegmentId(adjacent.index, adjacentChannel);
+                        const auto& neighborWire = neighborNets.getWires(neighborNets.getSegment(neighborSegment))[0];
+                        if (netWires_.size() >= MAX_FRAGMENT_WIRES) {
+                            segmentSeeds_.emplace_back(adjacent.slot, neighborSegment);
+                        } else if (!checkVisited({adjacent.slot, neighborWire.index}, neighborWire.channel)) {
+                            segmentNodes_.emplace_back(adjacent.slot, neighborSegment);
+                        }
+                    }
+                } else if (sim::isInput(adjacentData.id) || sim::isGate(adjacentData.id) || adjacentData.id == TileId::outLed) {
+                    netEndpoints_.push_back({adjacent, backDir});
+                }
+            }
+        }
+        netId = addNetFragment();
+    }
+    netlist_.getNet(netId).lastTick = 0;
+    return netId;
+}
+
+void Simulator::scheduleNet(TileRef start, int channel) {
+    uint32_t netId = netlist_.getNetId(start, channel);
+    if (netId == sim::WireNetlist::NO_NET) {
+        netId = (stitchedNets_ ? buildStitchedNet(start, channel) : buildNet(start, channel));
+    }
+    if (netlist_.getNet(netId).lastTick == tickCount_ + 1) {
+        return;
+    }
+    netlist_.getNet(netId).lastTick = tickCount_ + 1;
+    netUpdates_.push_back(netId);
+    if (chunkProfiling_) {
+        netUpdateSlots_.push_back(start.slot);
+    }
+}
+
+void Simulator::resolveNet(uint32_t netId, bool extraLogicStates, TaskOutput& output) {
+    // Find the drivers, the endpoints are checked against the current tiles since they can go stale after edits.
+    unsigned int numLow = 0, numHigh = 0, numMiddle = 0;
+    for (uint32_t fragmentId = netId; fragmentId != sim::WireNetlist::NO_NET; fragmentId = netlist_.getNet(fragmentId).next) {
+        const auto& fragment = netlist_.getNet(fragmentId);
+        const sim::Endpoint* endpoints = netlist_.getEndpoints(fragment);
+        for (uint32_t i = 0; i < fragment.endpointCount; ++i) {
+            const TileData tileData = accessTileData(endpoints[i].tile);
+            if (sim::isInput(tileData.id) || (sim::isGate(tileData.id) && tileData.dir == endpoints[i].wireDir)) {
+                if (tileData.state1 == State::low) {
+                    ++numLow;
+                } else if (tileData.state1 == State::high) {
+                    ++numHigh;
+                } else if (tileData.state1 == State::middle) {
+                    ++numMiddle;
+                }
+            }
+        }
+    }
+    bool conflict;
+    const State::t netState = sim::resolveNet(numLow, numHigh, numMiddle, extraLogicStates, conflict);
+
+    // Check if the wires need to change, the writes happen later in `updateNets()`.
+    bool fragmentChanged = false, netChanged = false;
+    for (uint32_t fragmentId = netId; fragmentId != sim::WireNetlist::NO_NET && !netChanged; fragmentId = netlist_.getNet(fragmentId).next) {
+        const auto& fragment = netlist_.getNet(fragmentId);
+        if (fragment.state == netState) {
+            continue;
+        }
+        fragmentChanged = true;
+        const sim::WireNode* wires = netlist_.getWires(fragment);
+        for (uint32_t i = 0; i < fragment.wireCount; ++i) {
+            const TileData tileData = accessTileData(wires[i].tile);
+            if ((wires[i].channel == 0 ? tileData.state1 : tileData.state2) != netState) {
+                netChanged = true;
+                break;
+            }
+        }
+    }
+    if (fragmentChanged) {
+        output.netStates.emplace_back(netId, netState);
+    }
+
+    // Endpoints only need an update if the state of the wire changed.
+    if (!netChanged) {
+        return;
+    }
+    for (uint32_t fragmentId = netId; fragmentId != sim::WireNetlist::NO_NET; fragmentId = netlist_.getNet(fragmentId).next) {
+        const auto& fragment = netlist_.getNet(fragmentId);
+        const sim::Endpoint* endpoints = netlist_.getEndpoints(fragment);
+        for (uint32_t i = 0; i < fragment.endpointCount; ++i) {
+            const TileData tileData = accessTileData(endpoints[i].tile);
+            if (tileData.id == TileId::outLed) {
+                output.ledUpdates.push_back(endpoints[i].tile);
+            } else if (sim::isGate(tileData.id) && tileData.dir != endpoints[i].wireDir) {
+                output.queuedGates.push_back(endpoints[i].tile);
+            }
+        }
+    }
+}
+
+void Simulator::updateNets(bool extraLogicStates) {
+    // The workers can't load chunks, so the ones a net reaches into get loaded first. The sim thread does the same so
+    // that the loads go to the board thread together.
+    if ((workerPool_ || boardTaskRunner_) && residentChunkCount_ < chunks_.size()) {
+        for (auto netId : netUpdates_) {
+            for (uint32_t fragmentId = netId; fragmentId != sim::WireNetlist::NO_NET; fragmentId = netlist_.getNet(fragmentId).next) {
+                const auto& fragment = netlist_.getNet(fragmentId);
+                const sim::WireNode* wires = netlist_.getWires(fragment);
+                for (uint32_t i = 0; i < fragment.wireCount; ++i) {
+                    queueChunkLoad(wires[i].tile.slot);
+                }
+                const sim::Endpoint* endpoints = netlist_.getEndpoints(fragment);
+                for (uint32_t i = 0; i < fragment.endpointCount; ++i) {
+                    queueChunkLoad(endpoints[i].tile.slot);
+                }
+            }
+        }
+        loadMissingChunks();
+    }
+    runTasks(netUpdates_.size(), NET_BLOCK_SIZE, [this, extraLogicStates](size_t begin, size_t end, unsigned int /*worker*/) {
+        auto& output = taskOutputs_[begin / NET_BLOCK_SIZE];
+        for (size_t i = begin; i < end; ++i) {
+            if (chunkProfiling_) {
+                const auto startTime = ProfileClock::now();
+                resolveNet(netUpdates_[i], extraLogicStates, output);
+                output.slotTimes.emplace_back(netUpdateSlots_[i], nanosecondsSince(startTime));
+            } else {
+                resolveNet(netUpdates_[i], extraLogicStates, output);
+            }
+        }
+    });
+
+    // Write the new states to the wires. A crossover can have a different net in each channel, so these writes
+    // are kept on one thread.
+    const size_t numBlocks = (netUpdates_.size() + NET_BLOCK_SIZE - 1) / NET_BLOCK_SIZE;
+    for (size_t i = 0; i < numBlocks; ++i) {
+        auto& output = taskOutputs_[i];
+        for (const auto& netState : output.netStates) {
+            recordChange(netState.first, netState.second);
+            for (uint32_t fragmentId = netState.first; fragmentId != sim::WireNetlist::NO_NET; fragmentId = netlist_.getNet(fragmentId).next) {
+                auto& fragment = netlist_.getNet(fragmentId);
+                if (fragment.state == netState.second) {
+                    continue;
+                }
+                fragment.state = netState.second;
+                const sim::WireNode* wires = netlist_.getWires(fragment);
+                for (uint32_t j = 0; j < fragment.wireCount; ++j) {
+                    TileData& tileData = accessTileData(wires[j].tile);
+                    if (wires[j].channel == 0 && tileData.state1 != netState.second) {
+                        tileData.state1 = netState.second;
+                    } else if (wires[j].channel == 1 && tileData.state2 != netState.second) {
+                        tileData.state2 = netState.second;
+                    } else {
+                        continue;
+                    }
+                    markTileDirty(wires[j].tile);
+                }
+            }
+        }
+        ledUpdates_.insert(ledUpdates_.end(), output.ledUpdates.begin(), output.ledUpdates.end());
+        for (const auto& gate : output.queuedGates) {
+            queueTile(gate);
+        }
+        for (const auto& slotTime : output.slotTimes) {
+            ++chunks_[slotTime.first].activity.netEvaluations;
+            chunks_[slotTime.first].activity.nanoseconds += slotTime.second;
+        }
+        output.netStates.clear();
+        output.ledUpdates.clear();
+        output.queuedGates.clear();
+        output.slotTimes.clear();
+    }
+    netUpdates_.clear();
+    netUpdateSlots_.clear();
+}
+
+void Simulator::runTimedUpdate(const TimedUpdate& update) {
+    if (update.releaseButton) {
+        TileData& tileData = accessTileData(update.tile);
+        if (tileData.id != TileId::inButton || tileData.state1 != State::high) {
+            return;
+        }
+        tileData.state1 = State::low;
+        recordChange(tileKey(update.tile), State::low);
+        markTileDirty(update.tile);
+    }
+    queueChunkUpdate(chunks_[update.tile.slot].coords, update.tile.index, update.adjacentUpdates);
+}
+
+void Simulator::updateLedGroup(TileRef start) {
+    if (checkVisited(start, 0)) {
+        return;
+    }
+    assert(ledNodes_.empty() && ledGroup_.empty());
+
+    // Depth-first traversal over the connected LEDs, the group turns on if anything adjacent outputs high.
+    bool groupHigh = false;
+    ledNodes_.push_back(start);
+    while (!ledNodes_.empty()) {
+        const TileRef led = ledNodes_.back();
+        ledNodes_.pop_back();
+        ledGroup_.push_back(led);
+        for (int i = 0; i < 4; ++i) {
+            TileRef adjacent;
+            if (!getAdjacent(led, static_cast<Direction::t>(i), adjacent)) {
+                continue;
+            }
+            const TileData adjacentData = accessTileData(adjacent);
+            if (adjacentData.id == TileId::outLed) {
+                if (!checkVisited(adjacent, 0)) {
+                    ledNodes_.push_back(adjacent);
+                }
+            } else if (sim::outputToward(adjacentData, static_cast<Direction::t>(i)) == State::high) {
+                groupHigh = true;
+            }
+        }
+    }
+
+    const State::t groupState = (groupHigh ? State::high : State::low);
+    for (const auto& led : ledGroup_) {
+        TileData& tileData = accessTileData(led);
+        if (tileData.state1 != groupState) {
+            tileData.state1 = groupState;
+            recordChange(tileKey(led), groupState);
+            markTileDirty(led);
+        }
+    }
+    ledGroup_.clear();
+}
@@ -0,0 +1,362 @@
+#pragma once
+
+#include <Chunk.h>
+#include <ChunkCoords.h>
+#include <sim/CheckpointLog.h>
+#include <sim/ChunkNets.h>
+#include <sim/ChunkResidency.h>
+#include <sim/InputLog.h>
+#include <sim/TileRef.h>
+#include <sim/TimingWheel.h>
+#include <sim/WaveformRecorder.h>
+#include <sim/WireNetlist.h>
+#include <sim/WorkerPool.h>
+#include <Tile.h>
+#include <TileChangeListener.h>
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Board;
+
+/**
+ * Runs the circuit simulation for a `Board`.
+ *
+ * The simulator works directly on the packed `TileData` stored in each chunk
+ * and keeps a queue of tile indices per chunk for the tiles that need an update
+ * in the next tick. A tick follows the same two-phase approach as the legacy
+ * simulator (see devnotes.txt): first all of the queued gates find their next
+ * state based on the current state of the board, then the changes are
+ * propagated through wires (and LEDs) and any gates affected by a change get
+ * queued for the next tick.
+ *
+ * Wires are followed once into a `sim::WireNetlist` (or joined together from
+ * the per-chunk `sim::ChunkNets`), after that a change in a wire only needs to
+ * check the endpoints of the net. The nets follow the tile edits on the board.
+ * Chunks that have been quiet for a while go to sleep and may unload from the
+ * board (see `sim::ChunkResidency`).
+ *
+ * Chunks are referenced by raw pointer, so the simulator resets any time the
+ * board replaces its chunks (after creating a new board or loading from a
+ * file).
+ */
+class Simulator : private TileChangeListener {
+public:
+    enum class InputMode {
+        none, record, replay
+    };
+
+    struct SettleResult {
+        // True if there are no more pending updates.
+        bool stable;
+        uint64_t ticks;
+        // Number of ticks in the cycle if the board is oscillating, zero otherwise.
+        uint64_t period;
+        // Chunks with tiles that change during the cycle, sorted by coords.
+        std::vector<ChunkCoords::repr> cycleChunks;
+    };
+
+    // Totals for a chunk over the ticks since the activity was last cleared.
+    struct ChunkActivity {
+        uint64_t updates;
+        uint64_t netEvaluations;
+        uint64_t nanoseconds;
+    };
+
+    Simulator(Board& board);
+    ~Simulator();
+    Simulator(const Simulator& rhs) = delete;
+    Simulator& operator=(const Simulator& rhs) = delete;
+
+    // Drops all pending updates and schedules an update for every tile in the loaded chunks.
+    void reset();
+    // Schedules an update for a tile that changed state (but not type or direction, use `tileChanged()` for that).
+    void addUpdate(int x, int y, bool adjacentUpdates = true);
+    void addChunkUpdate(ChunkCoords::repr coords, unsigned int tileIndex, bool adjacentUpdates = true);
+    // Schedules an update for a tile to run in the `numTicks`-th tick from now (zero or one is the next tick, same as
+    // `addUpdate()`). This is for inputs that change on their own later, like a pulse or clock source.
+    void scheduleUpdate(int x, int y, uint64_t numTicks, bool adjacentUpdates = true);
+    virtual void tileChanged(const sf::Vector2i& pos, TileChange::t change) override;
+    virtual void boardReloaded() override;
+    virtual void chunkLoaded(ChunkCoords::repr coords) override;
+    // Includes updates scheduled for a later tick.
+    bool hasPendingUpdates() const;
+    size_t getPendingUpdateCount() const;
+    uint64_t getTickCount() const;
+    // Builds nets by joining per-chunk segments instead of following each wire. This is set by default on
+    // `reset()` for boards without a size limit, and can be changed at any time (the nets are followed again).
+    void setStitchedNets(bool stitchedNets);
+    bool getStitchedNets() const;
+    // Sets the number of threads used for a tick (including the calling thread), one disables multithreading. The
+    // workers only read from the board and each block of work gets its own output, which is applied in block order on
+    // the calling thread. This gives the same result as a single thread.
+    void setThreadCount(unsigned int numThreads);
+    unsigned int getThreadCount() const;
+    // Number of ticks without activity before a chunk goes to sleep, zero disables sleeping. A sleeping chunk frees
+    // its update queues, and the board unloads it if it isn't visible and the file storage can load it again. The nets
+    // through the chunk stay around, and it loads again as soon as a tile in it is accessed. Chunks with pending
+    // updates never sleep.
+    void setSleepTicks(uint64_t sleepTicks);
+    uint64_t getSleepTicks() const;
+    size_t getSleepingChunkCount() const;
+    // Limits the number of chunks kept loaded, zero means no limit. Chunks past the limit are put to sleep early and
+    // unloaded (if the board allows it), except for the ones that were active recently. The limit is only checked
+    // every so often, so it can go over for a short time.
+    void setMaxResidentChunks(size_t maxResidentChunks);
+    size_t getMaxResidentChunks() const;
+    size_t getResidentChunkCount() const;
+    // Tries to unload the sleeping chunks that are still loaded. This happens on its own during ticks, except with
+    // detached drawing where it must be called between ticks from the thread that owns the board.
+    void unloadSleepingChunks();
+    // True if chunks went to sleep without unloading since the last `unloadSleepingChunks()`.
+    bool hasChunksToUnload() const;
+    // Sets how a chunk gets loaded again while ticking with detached drawing. The runner must run the task on the
+    // thread that owns the board and return once it's done. Without a runner, the task runs on the calling thread.
+    void setBoardTaskRunner(const std::function<void(const std::function<void()>& task)>& runner);
+    // Takes a checkpoint of the simulation every `interval` ticks (and right away), zero disables checkpoints. Any
+    // unloaded chunks get loaded for the first checkpoint. The checkpoints are dropped on a reset or an edit that
+    // changes the structure of a tile, since the simulation can't be replayed across those.
+    void setCheckpointInterval(uint64_t interval);
+    uint64_t getCheckpointInterval() const;
+    void setMaxCheckpointBytes(size_t maxBytes);
+    const sim::CheckpointLog& getCheckpointLog() const;
+    // Goes back `numTicks` by restoring the closest checkpoint before that and running ticks from there. Key presses
+    // and state changes (from `pressKey()`, `addUpdate()`, `scheduleUpdate()`, or a `TileChange::state` edit) made
+    // after the checkpoint apply again on the same tick, the ones made at or after the target tick are dropped.
+    // Returns false if there is no checkpoint that far back.
+    bool rewind(uint64_t numTicks);
+    // Records the state of a tile in the waveform whenever it changes, `channel` picks the vertical wire of a
+    // crossover. A probe on a wire follows the whole net. Returns the signal id in `getWaveformRecorder()`, the name
+    // defaults to the tile position. Probes on missing chunks start recording after a reset if the chunk exists then.
+    // A probe is only checked when its tile changes state, so a quiet probe costs nothing.
+    uint32_t addProbe(const sf::Vector2i& pos, int channel = 0, const std::string& name = "");
+    void clearProbes();
+    size_t getProbeCount() const;
+    sim::WaveformRecorder& getWaveformRecorder();
+    // Toggles the switches and presses the buttons with the keycode, the same as a key press in view mode. The press
+    // gets added to the input log while recording. The inputs are indexed by keycode as chunks get a slot, so a press
+    // only visits its own inputs (including the ones in unloaded chunks).
+    void pressKey(char keycode);
+    // Recording starts a new input log from the current tick. Replay runs the input log from the current tick, each
+    // press applies the same number of ticks after the start as when it was recorded, and the mode goes back to none
+    // after the last one. A rewind while recording drops the presses at or after the target tick, and a rewind while
+    // replaying (or after the replay finished) runs them again.
+    void setInputMode(InputMode mode);
+    InputMode getInputMode() const;
+    sim::InputLog& accessInputLog();
+    // Counts the activity in each chunk during a tick. This reads the clock for each chunk and net, so it's off by
+    // default. Should only be changed between ticks. A net counts towards the chunk with the update that scheduled it.
+    void setChunkProfiling(bool chunkProfiling);
+    bool getChunkProfiling() const;
+    // Chunks with any activity since the last clear, and the number of ticks that were profiled.
+    std::vector<std::pair<ChunkCoords::repr, ChunkActivity>> getChunkActivity() const;
+    uint64_t getProfiledTickCount() const;
+    void clearChunkActivity();
+    void tick();
+    // Runs a number of ticks in a row as fast as possible. Chunks are only marked dirty for drawing once at the
+    // end, so the renderer just picks up the final state instead of every tick in between.
+    void warp(uint64_t numTicks);
+    // Runs ticks until there are no more pending updates, the board starts to repeat a cycle of states, or
+    // `maxTicks` have passed. Like `warp()`, the chunks are marked dirty for drawing once at the end. Each tick sums a
+    // hash of its state changes, and the board is in a cycle of `p` ticks once the hashes of the last `p` ticks match
+    // the `p` before them. Ticks that change nothing are left out, so two quiet ticks in a row don't look like a cycle.
+    SettleResult settle(uint64_t maxTicks);
+    // Defers marking chunks dirty for drawing until `flushDrawDirty()` is called, and tracks the changed chunks
+    // for `visitChangedChunks()`. Any deferred chunks are flushed when this gets disabled. This is for ticking while
+    // another thread owns the board, so new chunks never get loaded from the file storage and the unloaded ones come
+    // back through the runner from `setBoardTaskRunner()`.
+    void setDetachedDrawing(bool detachedDrawing);
+    bool getDetachedDrawing() const;
+    // Marks the chunks changed since the last flush as dirty for drawing (and unsaved).
+    void flushDrawDirty();
+    // Calls `func` with the coords and tiles of each chunk changed since the last visit, only for detached drawing.
+    void visitChangedChunks(const std::function<void(ChunkCoords::repr coords, const TileData* tiles)>& func);
+    // Adds a chunk for the next `visitChangedChunks()` even if nothing in it changed.
+    void markChunkChanged(ChunkCoords::repr coords);
+
+private:
+    static constexpr int32_t NEIGHBOR_UNKNOWN = -1;
+    static constexpr int32_t NEIGHBOR_NONE = -2;
+
+    using TileRef = sim::TileRef;
+
+    struct ChunkState {
+        ChunkState(Chunk* chunk, ChunkCoords::repr coords);
+
+        // Null while the chunk is unloaded.
+        Chunk* chunk;
+        ChunkCoords::repr coords;
+        std::array<int32_t, 4> neighbors;
+        std::vector<uint16_t> pendingUpdates, currentUpdates;
+        std::bitset<Chunk::WIDTH * Chunk::WIDTH> queued;
+        // Tracks traversal of each wire channel (two per tile) within a tick.
+        std::bitset<Chunk::WIDTH * Chunk::WIDTH * 2> visited;
+        std::bitset<Chunk::WIDTH * Chunk::WIDTH> probed;
+        sim::ChunkNets nets;
+        ChunkActivity activity;
+        bool active, touched, drawDirty, changed, inCycle;
+    };
+
+    struct TimedUpdate {
+        TileRef tile;
+        // Releases a pressed button, otherwise the tile just gets an update.
+        bool releaseButton;
+        bool adjacentUpdates;
+    };
+
+    // A key press or a change to the state of a tile made from outside the simulator, kept for replaying after a rewind.
+    struct StateEdit {
+        uint64_t tick;
+        bool keyPress;
+        char keycode;
+        // For a tile, the states it was changed to and the update that followed.
+        TileRef tile;
+        State::t state1, state2;
+        uint64_t updateDelay;
+        bool adjacentUpdates;
+    };
+
+    struct Probe {
+        sf::Vector2i pos;
+        int channel;
+        // The slot is negative if the chunk didn't exist.
+        int32_t slot;
+        uint16_t index;
+        State::t lastState;
+    };
+
+    // Results from a block of work in a tick, these get applied in block order after all blocks are done.
+    struct TaskOutput {
+        std::vector<std::pair<TileRef, State::t>> gateTransitions;
+        std::vector<std::pair<uint32_t, State::t>> netStates;
+        std::vector<TileRef> ledUpdates, queuedGates;
+        // Time spent per slot, for chunk profiling.
+        std::vector<std::pair<uint32_t, uint64_t>> slotTimes;
+    };
+
+    // Same as `addChunkUpdate()`, for updates that come from the simulation itself (they don't need replaying).
+    void queueChunkUpdate(ChunkCoords::repr coords, unsigned int tileIndex, bool adjacentUpdates);
+    void scheduleTileUpdate(TileRef tile, uint64_t numTicks, bool adjacentUpdates);
+    int32_t findSlot(ChunkCoords::repr coords);
+    // Gets the chunk for a slot, and loads it again if it was unloaded while asleep.
+    Chunk& accessSlotChunk(uint32_t slot);
+    // Adds the slot to `missingChunks_` if its chunk is unloaded.
+    void queueChunkLoad(uint32_t slot);
+    // Loads all of the chunks in `missingChunks_` with a single board task.
+    void loadMissingChunks();
+    void resolveProbe(uint32_t probeId);
+    void sampleProbes(TileRef tile);
+    void indexInputs(uint32_t slot);
+    void indexInput(TileRef tile);
+    void toggleInputs(char keycode);
+    void replayInputs();
+    // True while there are presses left to replay.
+    bool isReplaying() const;
+    // Number of ticks until the next replayed key press or edit, or the max value if there is none.
+    uint64_t getTicksUntilReplay() const;
+    // Jumps ahead over the ticks where nothing changes, up to `maxTicks` or the next replayed key press or edit.
+    // Returns the number of ticks skipped, which is zero if there are pending updates.
+    uint64_t skipQuietTicks(uint64_t maxTicks);
+    void recordTileEdit(TileRef tile, uint64_t updateDelay, bool adjacentUpdates);
+    void applyStateEdit(const StateEdit& edit);
+    void saveCheckpoint();
+    void clearCheckpoints();
+    void restoreSnapshot(const sim::CheckpointLog::Snapshot& snapshot);
+    void sleepChunks();
+    void sleepSlot(uint32_t slot);
+    // Returns false if the chunk has to stay loaded for now.
+    bool unloadSlot(uint32_t slot);
+    int32_t getNeighborSlot(uint32_t slot, Direction::t dir);
+    bool getAdjacent(TileRef tile, Direction::t dir, TileRef& adjacent);
+    TileData& accessTileData(TileRef tile);
+    void markTileDirty(TileRef tile);
+    void recordChange(uint64_t key, State::t state);
+    static uint64_t tileKey(TileRef tile);
+    void queueTile(TileRef tile);
+    bool checkVisited(TileRef tile, int channel);
+    void resolveNeighbors(const std::vector<uint32_t>& tickChunks);
+    void runTasks(size_t numTasks, size_t blockSize, const sim::WorkerPool::TaskFunction& func);
+    void evaluateGates(bool extraLogicStates);
+    void propagateFrom(TileRef source, Direction::t dir);
+    void editTile(TileRef tile);
+    void followEditedWires();
+    uint32_t buildNet(TileRef start, int channel);
+    uint32_t addNetFragment();
+    const sim::ChunkNets& accessChunkNets(uint32_t slot);
+    uint32_t buildStitchedNet(TileRef start, int channel);
+    void scheduleNet(TileRef start, int channel);
+    void resolveNet(uint32_t netId, bool extraLogicStates, TaskOutput& output);
+    void updateNets(bool extraLogicStates);
+    void updateLedGroup(TileRef start);
+    void runTimedUpdate(const TimedUpdate& update);
+
+    Board& board_;
+    std::vector<ChunkState> chunks_;
+    std::unordered_map<ChunkCoords::repr, uint32_t> chunkSlots_;
+    std::vector<uint32_t> activeChunks_;
+    std::vector<uint32_t> tickChunks_;
+    std::vector<uint32_t> touchedChunks_;
+    std::vector<uint32_t> drawDirtyChunks_, changedChunks_, cycleChunks_;
+    std::unique_ptr<sim::WorkerPool> workerPool_;
+    std::vector<TaskOutput> taskOutputs_;
+    std::vector<TileRef> changedGates_, ledUpdates_;
+    sim::TimingWheel<TimedUpdate> timedUpdates_;
+    sim::ChunkResidency residency_;
+    std::vector<uint32_t> sleepingChunks_;
+    // Sleeping chunks that are still loaded, the unload is tried again on each sleep check. The first
+    // `triedSleeperCount_` of them stayed loaded on the last try.
+    std::vector<uint32_t> residentSleepers_;
+    size_t triedSleeperCount_;
+    size_t maxResidentChunks_, residentChunkCount_;
+    std::function<void(const std::function<void()>& task)> boardTaskRunner_;
+    std::vector<uint32_t> missingChunks_;
+    sim::CheckpointLog checkpoints_;
+    // Scratch space for saving and restoring checkpoints, this also keeps the tiles of the chunks that unloaded since
+    // the last checkpoint.
+    sim::CheckpointLog::Snapshot checkpointSnapshot_;
+    uint64_t checkpointInterval_;
+    // Edits since the oldest checkpoint in tick order, and the next one to apply while running forward after a rewind.
+    std::vector<StateEdit> stateEdits_;
+    size_t editReplayIndex_;
+    std::vector<Probe> probes_;
+    // Probe ids for each probed tile, by `tileKey()`.
+    std::unordered_multimap<uint64_t, uint32_t> probeTiles_;
+    sim::WaveformRecorder waveform_;
+    // Switches and buttons by keycode, and the keycode each indexed tile has (by `tileKey()`).
+    std::unordered_map<char, std::vector<TileRef>> keyInputs_;
+    std::unordered_map<uint64_t, char> inputKeycodes_;
+    // Chunks loaded by the board without a slot yet, these may have inputs to index.
+    std::vector<ChunkCoords::repr> unindexedChunks_;
+    sim::InputLog inputLog_;
+    InputMode inputMode_;
+    // Tick the input log started on, and the next press to replay.
+    uint64_t inputStartTick_;
+    size_t replayIndex_;
+    std::vector<uint32_t> netUpdates_;
+    // Slot that scheduled each net in `netUpdates_`, only while profiling.
+    std::vector<uint32_t> netUpdateSlots_;
+    sim::WireNetlist netlist_;
+    std::vector<sim::WireNode> wireNodes_, fragmentSeeds_, netWires_;
+    // Wires of the fragments dropped by edits, these are followed again at the start of the next tick.
+    std::vector<sim::WireNode> editedWires_;
+    std::vector<sim::Endpoint> netEndpoints_;
+    std::vector<uint32_t> mergeNets_;
+    std::vector<std::pair<uint32_t, uint16_t>> segmentNodes_, segmentSeeds_;
+    std::vector<TileRef> ledNodes_, ledGroup_;
+    uint64_t tickCount_;
+    bool stitchedNets_;
+    bool deferDrawDirty_;
+    bool detachedDrawing_;
+    bool chunkProfiling_;
+    uint64_t profiledTickCount_;
+    // Order-independent hash of the gate, net, and LED state changes in the last tick.
+    uint64_t changeHash_;
+    bool findingCycleChunks_;
+};
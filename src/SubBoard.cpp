@@ -169,7 +169,7 @@ Chunk& SubBoard::accessChunk(ChunkCoords::repr coords) {
     }
 
     spdlog::warn("SubBoard allocating new chunk at {}.", ChunkCoords::toPair(coords));
-    chunk = chunks_.emplace(std::piecewise_construct, std::forward_as_tuple(coords), std::forward_as_tuple(static_cast<LodRenderer*>(this), coords)).first;
+    chunk = chunks_.try_emplace(coords, static_cast<LodRenderer*>(this), coords).first;
     chunkDrawables_[coords].setChunk(&chunk->second);
     return chunk->second;
 }
@@ -204,7 +204,7 @@ void SubBoard::rotate(bool clockwise) {
         ChunkCoords::repr newChunkCoords = ChunkCoords::pack(pos.x >> widthLog2, pos.y >> widthLog2);
         auto newChunk = newChunks.find(newChunkCoords);
         if (newChunk == newChunks.end()) {
-            newChunk = newChunks.emplace(std::piecewise_construct, std::forward_as_tuple(newChunkCoords), std::forward_as_tuple(static_cast<LodRenderer*>(this), newChunkCoords)).first;
+            newChunk = newChunks.try_emplace(newChunkCoords, static_cast<LodRenderer*>(this), newChunkCoords).first;
             newDrawables[newChunkCoords].setChunk(&newChunk->second);
         }
         Tile tile = newChunk->second.accessTile((pos.x & (Chunk::WIDTH - 1)) + (pos.y & (Chunk::WIDTH - 1)) * Chunk::WIDTH);
@@ -4,13 +4,13 @@
 #include <ChunkCoords.h>
 #include <ChunkCoordsRange.h>
 #include <ChunkDrawable.h>
+#include <ChunkTable.h>
 #include <commands/PlaceTiles.h>
 #include <FlatMap.h>
 #include <LodRenderer.h>
 
 #include <memory>
 #include <SFML/Graphics.hpp>
-#include <unordered_map>
 
 class Board;
 class OffsetView;
@@ -58,7 +58,7 @@ private:
 
     sf::Vector2f position_;
     sf::Vector2u size_, lastSize_;
-    std::unordered_map<ChunkCoords::repr, Chunk> chunks_;
+    ChunkTable<Chunk> chunks_;
     std::unique_ptr<Chunk> emptyChunk_;
     FlatMap<ChunkCoords::repr, ChunkDrawable> chunkDrawables_;
     ChunkCoordsRange visibleArea_, lastVisibleArea_;
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <ChunkCoords.h>
+
+#include <SFML/Graphics.hpp>
+
+namespace TileChange {
+    enum t {
+        // Only the state of the tile changed (toggling a switch or wire).
+        state = 0,
+        // The tile type, direction, or other structure changed.
+        structure
+    };
+}
+
+/**
+ * Receives notifications from a `Board` when tiles are edited. Commands that
+ * modify tiles on a board report each position they touch, so that anything
+ * caching information about the tiles (such as the `Simulator`) can update
+ * only the affected area.
+ */
+class TileChangeListener {
+public:
+    TileChangeListener() = default;
+    virtual ~TileChangeListener() = default;
+    TileChangeListener(const TileChangeListener& rhs) = default;
+    TileChangeListener& operator=(const TileChangeListener& rhs) = default;
+
+    virtual void tileChanged(const sf::Vector2i& pos, TileChange::t change) = 0;
+    // Called after the board replaces all of its chunks (new board or loading from a file).
+    virtual void boardReloaded() = 0;
+    // Called when the file storage loads a chunk into the board (this doesn't include newly allocated chunks, since
+    // those are empty).
+    virtual void chunkLoaded(ChunkCoords::repr coords) = 0;
+};
@@ -18,6 +18,7 @@ void FillArea::execute() {
         auto tile = getBoard().accessTile(getTilePositions()[i]);
         accessTile(i).swapWith(tile);
         tile.setHighlight(true);
+        getBoard().notifyTileChanged(getTilePositions()[i], TileChange::structure);
     }
     setLastExecuteSize(getTilePositions().size());
 }
@@ -27,6 +28,7 @@ void FillArea::undo() {
         auto tile = getBoard().accessTile(getTilePositions()[i - 1]);
         accessTile(i - 1).swapWith(tile);
         tile.setHighlight(true);
+        getBoard().notifyTileChanged(getTilePositions()[i - 1], TileChange::structure);
     }
     setLastExecuteSize(0);
 }
@@ -30,6 +30,7 @@ void FlipTiles::execute() {
         if (highlightTiles_) {
             tile.setHighlight(true);
         }
+        board_.notifyTileChanged(tilePositions_[i], TileChange::structure);
     }
 }
 
@@ -40,6 +41,7 @@ void FlipTiles::undo() {
         if (highlightTiles_) {
             tile.setHighlight(true);
         }
+        board_.notifyTileChanged(tilePositions_[i], TileChange::structure);
     }
 }
 
@@ -56,6 +56,7 @@ void PlaceTiles::execute() {
     Command::execute();
     for (size_t i = lastExecuteSize_; i < tilePositions_.size(); ++i) {
         accessTile(i).swapWith(board_.accessTile(tilePositions_[i]));
+        board_.notifyTileChanged(tilePositions_[i], TileChange::structure);
     }
     lastExecuteSize_ = tilePositions_.size();
 }
@@ -63,6 +64,7 @@ void PlaceTiles::execute() {
 void PlaceTiles::undo() {
     for (size_t i = lastExecuteSize_; i > 0; --i) {
         accessTile(i - 1).swapWith(board_.accessTile(tilePositions_[i - 1]));
+        board_.notifyTileChanged(tilePositions_[i - 1], TileChange::structure);
     }
     lastExecuteSize_ = 0;
 }
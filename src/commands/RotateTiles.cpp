@@ -32,6 +32,7 @@ void RotateTiles::execute() {
         if (highlightTiles_) {
             tile.setHighlight(true);
         }
+        board_.notifyTileChanged(tilePositions_[i], TileChange::structure);
     }
 }
 
@@ -43,6 +44,7 @@ void RotateTiles::undo() {
         if (highlightTiles_) {
             tile.setHighlight(true);
         }
+        board_.notifyTileChanged(tilePositions_[i], TileChange::structure);
     }
 }
 
@@ -38,6 +38,7 @@ void ToggleTiles::execute() {
         if (highlightTiles_) {
             tile.setHighlight(true);
         }
+        board_.notifyTileChanged(toggleData_[i].pos, TileChange::state);
     }
 }
 
@@ -51,6 +52,7 @@ void ToggleTiles::undo() {
         if (highlightTiles_) {
             tile.setHighlight(true);
         }
+        board_.notifyTileChanged(toggleData_[i].pos, TileChange::state);
     }
 }
 
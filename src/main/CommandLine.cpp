@@ -0,0 +1,58 @@
+#include <Config.h>
+#include <DebugScreen.h>
+#include <Locator.h>
+#include <main/CommandLine.h>
+#include <MakeUnique.h>
+#include <ResourceNull.h>
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+namespace cli {
+
+void printCommonOptions(std::ostream& out) {
+    out <<
+        "  --threads <n>     Number of threads to use for a tick (default 1).\n"
+        "  --verbose         Print log messages to stderr.\n";
+}
+
+bool parseCount(const std::vector<std::string>& args, size_t& i, uint64_t& count) {
+    if (i + 1 >= args.size()) {
+        std::cerr << "Missing value for " << args[i] << ".\n";
+        return false;
+    }
+    try {
+        count = std::stoull(args[++i]);
+    } catch (std::exception& ex) {
+        std::cerr << "Invalid value \"" << args[i] << "\" for " << args[i - 1] << ".\n";
+        return false;
+    }
+    return true;
+}
+
+bool parseValue(const std::vector<std::string>& args, size_t& i, std::string& value) {
+    if (i + 1 >= args.size()) {
+        std::cerr << "Missing value for " << args[i] << ".\n";
+        return false;
+    }
+    value = args[++i];
+    return true;
+}
+
+void init(const std::vector<std::string>& args, const std::string& toolName) {
+    spdlog::set_default_logger(spdlog::stderr_color_mt("stderr"));
+    spdlog::set_level(std::find(args.begin(), args.end(), "--verbose") != args.end() ? spdlog::level::debug : spdlog::level::warn);
+    spdlog::info("CircuitSim2 v{} ({})", CIRCUITSIM2_VERSION, toolName);
+
+    Locator::provide(details::make_unique<ResourceNull>());
+    DebugScreen::init(Locator::getResource()->getFont("resources/consolas.ttf"), 16, {800, 600});
+}
+
+void shutdown() {
+    Locator::provide(std::unique_ptr<ResourceNull>(nullptr));
+}
+
+}
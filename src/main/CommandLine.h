@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Argument parsing and setup shared by the command line tools (`cs2_headless`
+ * and `cs2_bench`). These print their errors to stderr, standard output is
+ * reserved for the results of the tool.
+ */
+namespace cli {
+
+// Prints the usage lines for the options every tool takes.
+void printCommonOptions(std::ostream& out);
+
+// Parses the number after `args[i]` and moves `i` to it. Returns false (after printing an error) if it's missing or
+// not a number.
+bool parseCount(const std::vector<std::string>& args, size_t& i, uint64_t& count);
+
+// Same as `parseCount()` for a string value.
+bool parseValue(const std::vector<std::string>& args, size_t& i, std::string& value);
+
+// Sets up logging to stderr (at debug level with --verbose), and the null resources so that boards load without a
+// display. Call `shutdown()` before returning from main.
+void init(const std::vector<std::string>& args, const std::string& toolName);
+void shutdown();
+
+}
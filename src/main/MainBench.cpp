@@ -0,0 +1,479 @@
+#include <Board.h>
+#include <Config.h>
+#include <main/CommandLine.h>
+#include <Simulator.h>
+#include <Tile.h>
+#include <tiles/Gate.h>
+#include <tiles/Input.h>
+#include <tiles/Led.h>
+#include <tiles/Wire.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Measures the throughput of the simulator on the shipped boards and on some
+// generated ones, and writes the results as JSON to track regressions between
+// releases. Run it from the root of the repository so the boards can be found:
+//
+//   cs2_bench --ticks 20000 --output bench.json
+//
+// Each benchmark presses the keys of the inputs on the board in a fixed
+// pseudo-random order, so runs of the same version do the same work.
+//
+// The memory of a benchmark is reported as peakRssBytes, the peak resident
+// size of the process during the benchmark. Linux resets the peak before each
+// one. Windows can't, so there the peak also covers the benchmarks that ran
+// before (use --filter to run one at a time). Where there is no peak, it's
+// null. The growth of the resident set from before the board was made to the
+// end of the run is always reported as rssGrowthBytes.
+
+namespace {
+
+constexpr uint64_t DEFAULT_TICKS = 20000;
+constexpr uint64_t DEFAULT_WARMUP_TICKS = 1000;
+constexpr uint64_t PRESS_INTERVAL = 16;
+constexpr uint32_t RANDOM_SEED = 1234;
+
+// Sizes of the generated boards.
+constexpr int WIRE_TREE_COUNT = 4;
+constexpr int WIRE_TREE_BRANCHES = 128;
+constexpr int WIRE_TREE_BRANCH_LENGTH = 128;
+constexpr int GATE_MESH_WIDTH = 128;
+constexpr int GATE_MESH_HEIGHT = 128;
+constexpr int MEMORY_ROWS = 32;
+constexpr int MEMORY_COLUMNS = 32;
+
+struct Options {
+    uint64_t ticks;
+    uint64_t warmupTicks;
+    unsigned int threads;
+    std::string filter;
+    std::string outputFilename;
+};
+
+struct BenchmarkSpec {
+    std::string name;
+    // Empty for a generated board.
+    std::string filename;
+    std::function<void(Board& board)> generate;
+};
+
+struct BenchmarkResult {
+    std::string name;
+    std::string source;
+    size_t chunks;
+    size_t tiles;
+    size_t keys;
+    uint64_t ticks;
+    uint64_t updates;
+    double seconds;
+    // Zero if there is no peak for the benchmark.
+    uint64_t peakRssBytes;
+    uint64_t rssGrowthBytes;
+};
+
+void printUsage() {
+    std::cerr <<
+        "Usage: cs2_bench [options]\n"
+        "Options:\n"
+        "  --ticks <n>       Number of ticks to measure for each board (default " << DEFAULT_TICKS << ").\n"
+        "  --warmup <n>      Number of ticks to run before measuring (default " << DEFAULT_WARMUP_TICKS << ").\n"
+        "  --filter <text>   Only run the benchmarks with text in the name.\n"
+        "  --output <file>   Write the JSON results to a file instead of stdout.\n";
+    cli::printCommonOptions(std::cerr);
+}
+
+// Long nets with many branches. Each tree has a switch at the top of a trunk,
+// with branches going off to the right that end in LEDs.
+void generateWireTrees(Board& board) {
+    for (int tree = 0; tree < WIRE_TREE_COUNT; ++tree) {
+        const int left = tree * (WIRE_TREE_BRANCH_LENGTH + 2);
+        board.accessTile(left, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, static_cast<char>('a' + tree));
+        for (int y = 1; y <= WIRE_TREE_BRANCHES; ++y) {
+            if (y < WIRE_TREE_BRANCHES) {
+                board.accessTile(left, y).setType(tiles::Wire::instance(), TileId::wireTee, Direction::north);
+            } else {
+                board.accessTile(left, y).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+            }
+            for (int x = 1; x < WIRE_TREE_BRANCH_LENGTH; ++x) {
+                board.accessTile(left + x, y).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+            }
+            board.accessTile(left + WIRE_TREE_BRANCH_LENGTH, y).setType(tiles::Led::instance());
+        }
+    }
+}
+
+// A grid of XOR gates where each one takes the gate to the left and the one
+// above and to the left as inputs, through tee wires. A change in one of the
+// switches down the left side spreads out to the bottom right one tick at a
+// time.
+void generateGateMesh(Board& board) {
+    for (int y = 0; y < GATE_MESH_HEIGHT; ++y) {
+        board.accessTile(0, y).setType(tiles::Input::instance(), TileId::inSwitch, State::low, static_cast<char>('a' + y % 26));
+        for (int x = 1; x <= GATE_MESH_WIDTH; ++x) {
+            if ((x + y) % 2 == 1) {
+                board.accessTile(x, y).setType(tiles::Gate::instance(), TileId::gateXor, Direction::east);
+            } else {
+                board.accessTile(x, y).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+            }
+        }
+    }
+}
+
+// A grid of memory cells with select lines for the rows and data lines for
+// the columns. Each cell is a latch that gets set when both of its lines are
+// high, and reset while the clear line of its row is low. A cell looks like:
+//
+//   +T---    + crossover   T tee wire   L corner wire   - | straight wires
+//   T&oT*    & AND gate    o OR gate    * LED
+//   | &L
+//   +-T--
+void generateMatrixMemory(Board& board) {
+    const int cellWidth = 5, cellHeight = 4;
+    for (int row = 0; row < MEMORY_ROWS; ++row) {
+        const int y = 1 + row * cellHeight;
+        board.accessTile(0, y).setType(tiles::Input::instance(), TileId::inSwitch, State::low, static_cast<char>('a' + row % 26));
+        board.accessTile(0, y + 3).setType(tiles::Input::instance(), TileId::inSwitch, State::high, static_cast<char>('A' + row % 26));
+    }
+    for (int column = 0; column < MEMORY_COLUMNS; ++column) {
+        const int x = 1 + column * cellWidth;
+        board.accessTile(x, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, static_cast<char>('0' + column % 10));
+    }
+    for (int row = 0; row < MEMORY_ROWS; ++row) {
+        for (int column = 0; column < MEMORY_COLUMNS; ++column) {
+            const int x = 1 + column * cellWidth, y = 1 + row * cellHeight;
+            board.accessTile(x, y).setType(tiles::Wire::instance(), TileId::wireCrossover);
+            board.accessTile(x + 1, y).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+            for (int i = 2; i < cellWidth; ++i) {
+                board.accessTile(x + i, y).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+            }
+            board.accessTile(x, y + 1).setType(tiles::Wire::instance(), TileId::wireTee, Direction::north);
+            board.accessTile(x + 1, y + 1).setType(tiles::Gate::instance(), TileId::gateAnd, Direction::east);
+            board.accessTile(x + 2, y + 1).setType(tiles::Gate::instance(), TileId::gateOr, Direction::east);
+            board.accessTile(x + 3, y + 1).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+            board.accessTile(x + 4, y + 1).setType(tiles::Led::instance());
+            board.accessTile(x, y + 2).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+            board.accessTile(x + 2, y + 2).setType(tiles::Gate::instance(), TileId::gateAnd, Direction::north);
+            board.accessTile(x + 3, y + 2).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+            board.accessTile(x, y + 3).setType(tiles::Wire::instance(), TileId::wireCrossover);
+            board.accessTile(x + 1, y + 3).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+            board.accessTile(x + 2, y + 3).setType(tiles::Wire::instance(), TileId::wireTee, Direction::west);
+            for (int i = 3; i < cellWidth; ++i) {
+                board.accessTile(x + i, y + 3).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+            }
+        }
+    }
+}
+
+// Resets the peak resident set size to the current one, returns false if that's not supported.
+bool resetPeakRss() {
+#if defined(__linux__)
+    // Writing 5 resets the VmHWM of the process (since Linux 4.0).
+    std::ofstream clearRefsFile("/proc/self/clear_refs");
+    clearRefsFile << "5";
+    clearRefsFile.flush();
+    return static_cast<bool>(clearRefsFile);
+#else
+    return false;
+#endif
+}
+
+// Gets the peak resident set size of the process, in bytes (or zero if it's not available).
+uint64_t getPeakRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#elif defined(__linux__)
+    std::ifstream statusFile("/proc/self/status");
+    std::string field;
+    while (statusFile >> field) {
+        if (field == "VmHWM:") {
+            uint64_t kibibytes = 0;
+            statusFile >> kibibytes;
+            return kibibytes * 1024;
+        }
+        statusFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+    }
+    return 0;
+#else
+    return 0;
+#endif
+}
+
+// Gets the current resident set size of the process, in bytes (or zero if it's not available).
+uint64_t getRssBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return static_cast<uint64_t>(info.resident_size);
+#else
+    // The second field is the resident size in pages.
+    std::ifstream statmFile("/proc/self/statm");
+    uint64_t totalPages = 0, residentPages = 0;
+    if (!(statmFile >> totalPages >> residentPages)) {
+        return 0;
+    }
+    return residentPages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// Finds the keycodes of the inputs on the board (in sorted order), and counts the tiles that are not blank.
+std::vector<char> scanBoard(Board& board, size_t& tileCount) {
+    std::vector<char> keycodes;
+    tileCount = 0;
+    std::vector<ChunkCoords::repr> loadedCoords;
+    for (const auto& chunk : board.getLoadedChunks()) {
+        loadedCoords.push_back(chunk.first);
+    }
+    for (auto coords : loadedCoords) {
+        Chunk* chunk = board.findChunk(coords);
+        for (unsigned int i = 0; chunk != nullptr && i < Chunk::WIDTH * Chunk::WIDTH; ++i) {
+            const TileData tileData = chunk->accessTile(i).getRawData();
+            if (tileData.id == TileId::inSwitch || tileData.id == TileId::inButton) {
+                keycodes.push_back(static_cast<char>(tileData.meta));
+            }
+            tileCount += (tileData.id != TileId::blank);
+        }
+    }
+    std::sort(keycodes.begin(), keycodes.end());
+    keycodes.erase(std::unique(keycodes.begin(), keycodes.end()), keycodes.end());
+    return keycodes;
+}
+
+BenchmarkResult runBenchmark(const BenchmarkSpec& spec, const Options& options) {
+    BenchmarkResult result = {spec.name, (spec.filename.empty() ? "generated" : spec.filename), 0, 0, 0, options.ticks, 0, 0.0, 0, 0};
+#ifdef __GLIBC__
+    // Hand the memory freed by the last benchmark back to the OS, so that the new board can't just reuse it.
+    malloc_trim(0);
+#endif
+#ifdef _WIN32
+    const bool hasPeak = true;
+#else
+    const bool hasPeak = resetPeakRss();
+#endif
+    const uint64_t startRssBytes = getRssBytes();
+    Board board;
+    if (spec.filename.empty()) {
+        spec.generate(board);
+    } else {
+        if (!board.loadFromFile(spec.filename)) {
+            throw std::runtime_error("Failed to load board \"" + spec.filename + "\".");
+        }
+        board.forceLoadAllChunks();
+    }
+    result.chunks = board.getLoadedChunks().size();
+    const std::vector<char> keycodes = scanBoard(board, result.tiles);
+    result.keys = keycodes.size();
+
+    Simulator simulator(board);
+    simulator.setThreadCount(options.threads);
+    simulator.reset();
+    std::mt19937 rng(RANDOM_SEED);
+    auto pressRandomKey = [&]() {
+        if (!keycodes.empty()) {
+            simulator.pressKey(keycodes[rng() % keycodes.size()]);
+        }
+    };
+    for (uint64_t i = 0; i < options.warmupTicks; ++i) {
+        if (i % PRESS_INTERVAL == 0) {
+            pressRandomKey();
+        }
+        simulator.tick();
+    }
+    // Sampled here too in case the run frees some of the memory used by the warmup.
+    const uint64_t warmupRssBytes = getRssBytes();
+
+    // The ticks are run one at a time (instead of a warp) to count the updates in each one.
+    const auto startTime = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < options.ticks; ++i) {
+        if (i % PRESS_INTERVAL == 0) {
+            pressRandomKey();
+        }
+        result.updates += simulator.getPendingUpdateCount();
+        simulator.tick();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    if (hasPeak) {
+        result.peakRssBytes = getPeakRssBytes();
+    }
+    const uint64_t endRssBytes = std::max(warmupRssBytes, getRssBytes());
+    result.rssGrowthBytes = (endRssBytes > startRssBytes ? endRssBytes - startRssBytes : 0);
+    return result;
+}
+
+std::string escapeJson(const std::string& str) {
+    std::string escaped;
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped.push_back('\\');
+            escaped.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char buffer[8];
+            std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned int>(c));
+            escaped += buffer;
+        } else {
+            escaped.push_back(c);
+        }
+    }
+    return escaped;
+}
+
+void writeJson(std::ostream& out, const Options& options, const std::vector<BenchmarkResult>& results) {
+    out << "{\n";
+    out << "  \"version\": \"" << escapeJson(CIRCUITSIM2_VERSION) << "\",\n";
+    out << "  \"ticks\": " << options.ticks << ",\n";
+    out << "  \"warmupTicks\": " << options.warmupTicks << ",\n";
+    out << "  \"threads\": " << options.threads << ",\n";
+    out << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& result = results[i];
+        const double ticksPerSecond = (result.seconds > 0.0 ? result.ticks / result.seconds : 0.0);
+        const double nsPerUpdate = (result.updates > 0 ? result.seconds * 1.0e9 / result.updates : 0.0);
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\n";
+        out << "      \"name\": \"" << escapeJson(result.name) << "\",\n";
+        out << "      \"source\": \"" << escapeJson(result.source) << "\",\n";
+        out << "      \"chunks\": " << result.chunks << ",\n";
+        out << "      \"tiles\": " << result.tiles << ",\n";
+        out << "      \"keys\": " << result.keys << ",\n";
+        out << "      \"ticks\": " << result.ticks << ",\n";
+        out << "      \"updates\": " << result.updates << ",\n";
+        out << "      \"seconds\": " << result.seconds << ",\n";
+        out << "      \"ticksPerSecond\": " << ticksPerSecond << ",\n";
+        out << "      \"nsPerUpdate\": " << nsPerUpdate << ",\n";
+        if (result.peakRssBytes > 0) {
+            out << "      \"peakRssBytes\": " << result.peakRssBytes << ",\n";
+        } else {
+            out << "      \"peakRssBytes\": null,\n";
+        }
+        out << "      \"rssGrowthBytes\": " << result.rssGrowthBytes << "\n";
+        out << "    }";
+    }
+    out << (results.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+}
+
+bool parseOptions(const std::vector<std::string>& args, Options& options) {
+    for (size_t i = 0; i < args.size(); ++i) {
+        uint64_t count;
+        if (args[i] == "--ticks") {
+            if (!cli::parseCount(args, i, options.ticks)) {
+                return false;
+            }
+        } else if (args[i] == "--warmup") {
+            if (!cli::parseCount(args, i, options.warmupTicks)) {
+                return false;
+            }
+        } else if (args[i] == "--threads") {
+            if (!cli::parseCount(args, i, count)) {
+                return false;
+            }
+            options.threads = static_cast<unsigned int>(std::max<uint64_t>(count, 1));
+        } else if (args[i] == "--filter") {
+            if (!cli::parseValue(args, i, options.filter)) {
+                return false;
+            }
+        } else if (args[i] == "--output") {
+            if (!cli::parseValue(args, i, options.outputFilename)) {
+                return false;
+            }
+        } else if (args[i] != "--verbose") {
+            std::cerr << "Unknown argument \"" << args[i] << "\".\n";
+            printUsage();
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (!args.empty() && args[0] == "--help") {
+        printUsage();
+        return EXIT_SUCCESS;
+    }
+    Options options = {DEFAULT_TICKS, DEFAULT_WARMUP_TICKS, 1, "", ""};
+    if (!parseOptions(args, options)) {
+        return EXIT_FAILURE;
+    }
+
+    cli::init(args, "bench");
+
+    const std::vector<BenchmarkSpec> specs = {
+        {"Computer", "boards/Computer.txt", nullptr},
+        {"ComputerGame", "boards/ComputerGame.txt", nullptr},
+        {"ComputerGuessNum", "boards/ComputerGuessNum.txt", nullptr},
+        {"Calculator", "boards/Calculator.txt", nullptr},
+        {"WireTrees", "", generateWireTrees},
+        {"GateMesh", "", generateGateMesh},
+        {"MatrixMemory", "", generateMatrixMemory}
+    };
+
+    int result = EXIT_SUCCESS;
+    try {
+        std::vector<BenchmarkResult> results;
+        for (const auto& spec : specs) {
+            if (spec.name.find(options.filter) != std::string::npos) {
+                spdlog::info("Running benchmark {}.", spec.name);
+                results.push_back(runBenchmark(spec, options));
+            }
+        }
+        if (options.outputFilename.empty()) {
+            writeJson(std::cout, options, results);
+        } else {
+            std::ofstream outputFile(options.outputFilename);
+            writeJson(outputFile, options, results);
+            if (!outputFile) {
+                std::cerr << "Failed to write \"" << options.outputFilename << "\".\n";
+                result = EXIT_FAILURE;
+            }
+        }
+    } catch (std::exception& ex) {
+        spdlog::error(ex.what());
+        result = EXIT_FAILURE;
+    }
+
+    cli::shutdown();
+    return result;
+}
@@ -0,0 +1,357 @@
+#include <Board.h>
+#include <Config.h>
+#include <main/CommandLine.h>
+#include <sim/CompiledNetlist.h>
+#include <Simulator.h>
+#include <Tile.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Runs a board without a window, for regression runs and benchmarking on
+// machines without a display. The arguments after the board file are run as a
+// script in the order given, for example:
+//
+//   cs2_headless boards/Computer.txt --stable 10000 --toggle a --ticks 100 --hash
+//
+// Key presses made with --toggle can be recorded and replayed later, which
+// gives the same run each time:
+//
+//   cs2_headless boards/ComputerGuessNum.txt --record guess.txt --toggle r --ticks 5000 --toggle 0e --ticks 5000
+//   cs2_headless boards/ComputerGuessNum.txt --replay guess.txt --ticks 10000 --hash
+//
+// The chunks that take up the most time in a run can be found with:
+//
+//   cs2_headless boards/Computer.txt --profile --ticks 10000 --hot-chunks 10
+//
+// The effect of removing dead logic from the compiled netlist shows up in the
+// time of the --compiled run, only the LEDs and the probes are kept:
+//
+//   cs2_headless boards/Computer.txt --compiled 1000
+//   cs2_headless boards/Computer.txt --remove-dead --probe 12,40 --compiled 1000
+
+namespace {
+
+void printUsage() {
+    std::cerr <<
+        "Usage: cs2_headless <board file> [actions...]\n"
+        "Actions run in the order given:\n"
+        "  --ticks <n>       Run n ticks.\n"
+        "  --stable <max>    Run until there are no more updates, or fail if it oscillates or reaches max ticks.\n"
+        "  --compiled <max>  Settle with the compiled netlist instead of ticking, feedback loops run up to max ticks.\n"
+        "  --rewind <n>      Go back n ticks, this needs --checkpoints first.\n"
+        "  --toggle <keys>   Toggle the switches and press the buttons with each keycode.\n"
+        "  --replay <file>   Replay the key presses in an input log, starting from the current tick.\n"
+        "  --states          Print the state of each LED and gate.\n"
+        "  --hash            Print a hash of the state of the board.\n"
+        "  --vcd <file>      Write the waveform of the probes so far to a VCD file.\n"
+        "  --hot-chunks <n>  Print the n chunks that took the most time since the last --hot-chunks (needs --profile).\n"
+        "Options:\n"
+        "  --checkpoints <n> Take a checkpoint every n ticks.\n"
+        "  --max-chunks <n>  Keep at most n chunks loaded, the least active ones get unloaded (default no limit).\n"
+        "  --profile         Count the updates, net evaluations, and time spent in each chunk.\n"
+        "  --probe <x>,<y>   Record the state of a tile (or the net of a wire) each time it changes.\n"
+        "  --probe-buffer <n> Size of the buffer for the probe events, in events (default 65536).\n"
+        "  --remove-dead     Let --compiled remove the logic that no LED or probe depends on. That logic keeps its state.\n"
+        "  --record <file>   Record the key presses from here on, the input log is written at the end.\n";
+    cli::printCommonOptions(std::cerr);
+}
+
+// Visits each tile in the loaded chunks, sorted by position so that the output does not depend on hash ordering.
+template<typename Func>
+void forEachTile(Board& board, Func func) {
+    // The simulator may have unloaded some of the chunks to stay under --max-chunks.
+    board.forceLoadAllChunks();
+    std::vector<ChunkCoords::repr> loadedCoords;
+    for (const auto& chunk : board.getLoadedChunks()) {
+        loadedCoords.push_back(chunk.first);
+    }
+    std::sort(loadedCoords.begin(), loadedCoords.end(), [](ChunkCoords::repr lhs, ChunkCoords::repr rhs) {
+        return std::make_pair(ChunkCoords::y(lhs), ChunkCoords::x(lhs)) < std::make_pair(ChunkCoords::y(rhs), ChunkCoords::x(rhs));
+    });
+    for (auto coords : loadedCoords) {
+        Chunk* chunk = board.findChunk(coords);
+        for (unsigned int i = 0; chunk != nullptr && i < Chunk::WIDTH * Chunk::WIDTH; ++i) {
+            Tile tile = chunk->accessTile(i);
+            if (tile.getId() != TileId::blank) {
+                func(sf::Vector2i(ChunkCoords::x(coords) * Chunk::WIDTH + static_cast<int>(i % Chunk::WIDTH), ChunkCoords::y(coords) * Chunk::WIDTH + static_cast<int>(i / Chunk::WIDTH)), tile);
+            }
+        }
+    }
+}
+
+void printStates(Board& board) {
+    forEachTile(board, [](const sf::Vector2i& pos, Tile tile) {
+        const TileId::t id = tile.getId();
+        if (id == TileId::outLed || (id >= TileId::gateDiode && id <= TileId::gateXnor)) {
+            std::cout << (id == TileId::outLed ? "led " : "gate ") << pos.x << " " << pos.y << " " << static_cast<int>(tile.getState()) << "\n";
+        }
+    });
+}
+
+uint64_t hashBoard(Board& board) {
+    // FNV-1a over the position and states of each tile.
+    uint64_t hash = 14695981039346656037ull;
+    auto hashValue = [&hash](uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            hash = (hash ^ ((value >> (i * 8)) & 0xff)) * 1099511628211ull;
+        }
+    };
+    forEachTile(board, [&](const sf::Vector2i& pos, Tile tile) {
+        const TileData tileData = tile.getRawData();
+        hashValue(static_cast<uint32_t>(pos.x));
+        hashValue(static_cast<uint32_t>(pos.y));
+        hashValue(tileData.id | tileData.state1 << 8 | tileData.state2 << 16);
+    });
+    return hash;
+}
+
+void printHotChunks(Simulator& simulator, uint64_t count) {
+    auto activity = simulator.getChunkActivity();
+    std::sort(activity.begin(), activity.end(), [](const std::pair<ChunkCoords::repr, Simulator::ChunkActivity>& lhs, const std::pair<ChunkCoords::repr, Simulator::ChunkActivity>& rhs) {
+        return lhs.second.nanoseconds > rhs.second.nanoseconds;
+    });
+    uint64_t totalNanoseconds = 0;
+    for (const auto& chunk : activity) {
+        totalNanoseconds += chunk.second.nanoseconds;
+    }
+    std::cout << "profiled " << simulator.getProfiledTickCount() << " ticks " << activity.size() << " chunks " << totalNanoseconds << " ns\n";
+    for (size_t i = 0; i < activity.size() && i < count; ++i) {
+        const auto& chunk = activity[i];
+        std::cout << "chunk " << ChunkCoords::x(chunk.first) << "," << ChunkCoords::y(chunk.first) << " updates " << chunk.second.updates << " nets " << chunk.second.netEvaluations << " ns " << chunk.second.nanoseconds << "\n";
+    }
+    simulator.clearChunkActivity();
+}
+
+bool parsePosition(const std::vector<std::string>& args, size_t& i, sf::Vector2i& pos) {
+    std::string value;
+    if (!cli::parseValue(args, i, value)) {
+        return false;
+    }
+    const size_t comma = value.find(',');
+    try {
+        if (comma == std::string::npos) {
+            throw std::invalid_argument("missing comma");
+        }
+        pos.x = std::stoi(value.substr(0, comma));
+        pos.y = std::stoi(value.substr(comma + 1));
+    } catch (std::exception& ex) {
+        std::cerr << "Invalid position \"" << value << "\" for " << args[i - 1] << ".\n";
+        return false;
+    }
+    return true;
+}
+
+int runActions(Board& board, Simulator& simulator, const std::vector<std::string>& args, std::string& recordFilename) {
+    bool removeDeadLogic = false;
+    std::vector<sf::Vector2i> probePositions;
+    for (size_t i = 0; i < args.size(); ++i) {
+        uint64_t count;
+        if (args[i] == "--ticks") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            if (simulator.getProbeCount() == 0) {
+                simulator.warp(count);
+            } else {
+                // Nothing else takes the events out of the waveform buffer. A probe changes at most once a tick, so
+                // run as many ticks as the free space in the buffer can hold before collecting again.
+                auto& waveform = simulator.getWaveformRecorder();
+                for (uint64_t j = 0; j < count;) {
+                    waveform.collect();
+                    const uint64_t batch = std::min<uint64_t>(count - j, std::max<size_t>(waveform.getFreeSpace() / simulator.getProbeCount(), 1));
+                    simulator.warp(batch);
+                    j += batch;
+                }
+                waveform.collect();
+            }
+            std::cout << "tick " << simulator.getTickCount() << "\n";
+        } else if (args[i] == "--stable") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            const auto result = simulator.settle(count);
+            if (result.period != 0) {
+                std::cout << "oscillating " << simulator.getTickCount() << " period " << result.period << " chunks";
+                for (auto coords : result.cycleChunks) {
+                    std::cout << " " << ChunkCoords::x(coords) << "," << ChunkCoords::y(coords);
+                }
+                std::cout << "\n";
+                return 2;
+            } else if (!result.stable) {
+                std::cout << "unstable " << simulator.getTickCount() << "\n";
+                return 2;
+            }
+            std::cout << "stable " << simulator.getTickCount() << "\n";
+        } else if (args[i] == "--compiled") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            // The inputs only change between actions, so they can be folded in too.
+            sim::CompiledNetlist netlist(board);
+            netlist.setConstantInputs(true);
+            netlist.setRemoveDeadLogic(removeDeadLogic);
+            for (const auto& pos : probePositions) {
+                netlist.addObservedTile(pos);
+            }
+            netlist.build();
+            const auto startTime = std::chrono::steady_clock::now();
+            const bool stable = netlist.run(static_cast<unsigned int>(std::min<uint64_t>(count, std::numeric_limits<unsigned int>::max())));
+            const auto runTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime);
+            netlist.writeStates();
+            simulator.reset();
+            std::cout << (stable ? "compiled stable" : "compiled unstable") << " levels " << netlist.getLevelCount() << " feedback gates " << netlist.getFeedbackGateCount() << " constants " << netlist.getConstantCount() << " aliases " << netlist.getAliasCount() << " dead " << netlist.getDeadCount() << " instructions " << netlist.getInstructionCount() << " ns " << runTime.count() << "\n";
+            if (!stable) {
+                return 2;
+            }
+        } else if (args[i] == "--rewind") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            if (!simulator.rewind(count)) {
+                std::cerr << "No checkpoint to rewind " << count << " ticks from tick " << simulator.getTickCount() << ".\n";
+                return EXIT_FAILURE;
+            }
+            std::cout << "tick " << simulator.getTickCount() << "\n";
+        } else if (args[i] == "--toggle") {
+            std::string keycodes;
+            if (!cli::parseValue(args, i, keycodes)) {
+                return EXIT_FAILURE;
+            }
+            for (char keycode : keycodes) {
+                simulator.pressKey(keycode);
+            }
+        } else if (args[i] == "--states") {
+            printStates(board);
+        } else if (args[i] == "--hash") {
+            std::cout << "hash " << std::hex << hashBoard(board) << std::dec << "\n";
+        } else if (args[i] == "--hot-chunks") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            printHotChunks(simulator, count);
+        } else if (args[i] == "--vcd") {
+            std::string vcdFilename;
+            if (!cli::parseValue(args, i, vcdFilename)) {
+                return EXIT_FAILURE;
+            }
+            std::ofstream vcdFile(vcdFilename);
+            auto& waveform = simulator.getWaveformRecorder();
+            waveform.writeVcd(vcdFile);
+            if (!vcdFile) {
+                std::cerr << "Failed to write \"" << vcdFilename << "\".\n";
+                return EXIT_FAILURE;
+            }
+            if (waveform.getDroppedCount() != 0) {
+                spdlog::warn("Waveform is missing {} events, the buffer filled up.", waveform.getDroppedCount());
+            }
+        } else if (args[i] == "--replay") {
+            std::string inputFilename;
+            if (!cli::parseValue(args, i, inputFilename)) {
+                return EXIT_FAILURE;
+            }
+            std::ifstream inputFile(inputFilename);
+            if (!inputFile.is_open() || !simulator.accessInputLog().load(inputFile)) {
+                std::cerr << "Failed to load input log \"" << inputFilename << "\".\n";
+                return EXIT_FAILURE;
+            }
+            simulator.setInputMode(Simulator::InputMode::replay);
+        } else if (args[i] == "--record") {
+            if (!cli::parseValue(args, i, recordFilename)) {
+                return EXIT_FAILURE;
+            }
+            simulator.setInputMode(Simulator::InputMode::record);
+        } else if (args[i] == "--profile") {
+            simulator.setChunkProfiling(true);
+        } else if (args[i] == "--probe") {
+            sf::Vector2i pos;
+            if (!parsePosition(args, i, pos)) {
+                return EXIT_FAILURE;
+            }
+            simulator.addProbe(pos);
+            probePositions.push_back(pos);
+        } else if (args[i] == "--remove-dead") {
+            removeDeadLogic = true;
+        } else if (args[i] == "--probe-buffer") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            if (count == 0) {
+                std::cerr << "Invalid value \"0\" for --probe-buffer.\n";
+                return EXIT_FAILURE;
+            }
+            simulator.getWaveformRecorder().setCapacity(static_cast<size_t>(count));
+        } else if (args[i] == "--threads") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            simulator.setThreadCount(static_cast<unsigned int>(count));
+        } else if (args[i] == "--checkpoints") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            simulator.setCheckpointInterval(count);
+        } else if (args[i] == "--max-chunks") {
+            if (!cli::parseCount(args, i, count)) {
+                return EXIT_FAILURE;
+            }
+            simulator.setMaxResidentChunks(static_cast<size_t>(count));
+        } else if (args[i] != "--verbose") {
+            std::cerr << "Unknown argument \"" << args[i] << "\".\n";
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.empty() || args[0] == "--help") {
+        printUsage();
+        return (args.empty() ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    cli::init(args, "headless");
+
+    int result = EXIT_FAILURE;
+    try {
+        Board board;
+        if (board.loadFromFile(args[0])) {
+            board.forceLoadAllChunks();
+            Simulator simulator(board);
+            simulator.reset();
+            args.erase(args.begin());
+            std::string recordFilename;
+            result = runActions(board, simulator, args, recordFilename);
+            if (!recordFilename.empty()) {
+                std::ofstream inputFile(recordFilename);
+                if (!simulator.accessInputLog().save(inputFile)) {
+                    std::cerr << "Failed to write input log \"" << recordFilename << "\".\n";
+                    result = EXIT_FAILURE;
+                }
+            }
+        } else {
+            std::cerr << "Failed to load board \"" << args[0] << "\".\n";
+        }
+    } catch (std::exception& ex) {
+        spdlog::error(ex.what());
+        result = EXIT_FAILURE;
+    }
+
+    cli::shutdown();
+    return result;
+}
@@ -15,6 +15,7 @@
 #include <tiles/Wire.h>
 
 #include <cmath>
+#include <cstdint>
 #include <memory>
 #include <portable-file-dialogs.h>
 #include <SFML/Graphics.hpp>
@@ -52,6 +53,7 @@ int main() {
 
     Editor editor(board, window, messageLogSink.get());
     editor.setMaxEditHistory(5);    // FIXME: will need to be set from the config.
+    editor.setMaxResidentChunks(16384);    // FIXME: will need to be set from the config.
 
     try {
         //board.loadFromFile(fs::absolute("boards/NewBoard/board.txt"));    // FIXME: path must be absolute for save-as to work.
@@ -110,6 +112,10 @@ int main() {
     //float zoomLevel = 1.0f;
     //sf::Vector2i lastMousePos;
     sf::Clock frameTimer;
+    // The perSecondClock counts FPS and TPS, the ticks run on the simulation thread.
+    sf::Clock perSecondClock;
+    unsigned int fpsCounter = 0, fps = 0;
+    uint64_t lastTickCount = editor.getTickCount(), tps = 0;
 
 
     // FIXME
@@ -162,8 +168,17 @@ int main() {
         }
         DebugScreen::instance()->profilerEvent("main process_events_done");
 
+        ++fpsCounter;
+        if (perSecondClock.getElapsedTime().asSeconds() >= 1.0f) {
+            fps = fpsCounter;
+            fpsCounter = 0;
+            const uint64_t tickCount = editor.getTickCount();
+            tps = tickCount - lastTickCount;
+            lastTickCount = tickCount;
+            perSecondClock.restart();
+        }
         std::string changesMadeIndicator = editor.isEditUnsaved() ? "*" : "";
-        window.setTitle("[CircuitSim2] [" + changesMadeIndicator + board.getFilename().string() + "] [Size: " + std::to_string(0) + " x " + std::to_string(0) + "] [FPS: " + std::to_string(0) + ", TPS: " + std::to_string(0) + "]");
+        window.setTitle("[CircuitSim2] [" + changesMadeIndicator + board.getFilename().string() + "] [Size: " + std::to_string(0) + " x " + std::to_string(0) + "] [FPS: " + std::to_string(fps) + ", TPS: " + std::to_string(tps) + "]");
         editor.update();
 
         /*static auto state = State::low;
@@ -0,0 +1,368 @@
+#include <Board.h>
+#include <sim/BatchSimulator.h>
+#include <sim/TileLogic.h>
+
+#include <cassert>
+
+namespace sim {
+
+constexpr unsigned int BatchSimulator::MAX_WORDS;
+
+BatchSimulator::BatchSimulator(Board& board, unsigned int numWords) :
+    board_(board),
+    numWords_(numWords),
+    extraLogicStates_(false),
+    numPlanes_(1),
+    graph_(),
+    signals_(),
+    nextGateStates_(),
+    gates_(),
+    nets_(),
+    ledGroups_(),
+    connections_(),
+    tickCount_(0) {
+
+    assert(numWords == 1 || numWords == 2 || numWords == MAX_WORDS);
+}
+
+void BatchSimulator::build() {
+    signals_.clear();
+    gates_.clear();
+    nets_.clear();
+    ledGroups_.clear();
+    connections_.clear();
+    tickCount_ = 0;
+    extraLogicStates_ = board_.getExtraLogicStates();
+    numPlanes_ = (extraLogicStates_ ? 2 : 1);
+
+    graph_.build(board_);
+    for (auto state : graph_.getInitialStates()) {
+        addSignal(state);
+    }
+    for (const auto& gate : graph_.getGates()) {
+        buildGate(gate);
+    }
+    for (const auto& graphGroup : graph_.getNets()) {
+        nets_.push_back({graphGroup.output, static_cast<uint32_t>(connections_.size()), static_cast<uint32_t>(graphGroup.drivers.size())});
+        connections_.insert(connections_.end(), graphGroup.drivers.begin(), graphGroup.drivers.end());
+    }
+    for (const auto& graphGroup : graph_.getLedGroups()) {
+        ledGroups_.push_back({graphGroup.output, static_cast<uint32_t>(connections_.size()), static_cast<uint32_t>(graphGroup.drivers.size())});
+        connections_.insert(connections_.end(), graphGroup.drivers.begin(), graphGroup.drivers.end());
+    }
+    nextGateStates_.assign(gates_.size() * numWords_ * numPlanes_, 0);
+}
+
+unsigned int BatchSimulator::getWordCount() const {
+    return numWords_;
+}
+
+unsigned int BatchSimulator::getLaneCount() const {
+    return numWords_ * 64;
+}
+
+bool BatchSimulator::getExtraLogicStates() const {
+    return extraLogicStates_;
+}
+
+size_t BatchSimulator::getSignalCount() const {
+    return signals_.size() / (numWords_ * numPlanes_);
+}
+
+size_t BatchSimulator::getGateCount() const {
+    return gates_.size();
+}
+
+uint64_t* BatchSimulator::accessSignal(const sf::Vector2i& pos, int channel) {
+    const uint32_t signal = graph_.findSignal(pos, channel);
+    if (signal == CircuitGraph::NO_SIGNAL) {
+        return nullptr;
+    }
+    return &signals_[signal * numWords_ * numPlanes_];
+}
+
+State::t BatchSimulator::getLaneState(const sf::Vector2i& pos, unsigned int lane, int channel) {
+    const uint64_t* words = accessSignal(pos, channel);
+    if (words == nullptr) {
+        return State::disconnected;
+    }
+    const bool high = (words[lane / 64] >> lane % 64 & 1);
+    if (!extraLogicStates_) {
+        return (high ? State::high : State::low);
+    }
+    const bool low = (words[numWords_ + lane / 64] >> lane % 64 & 1);
+    return static_cast<State::t>((high ? State::high : 0) | (low ? State::low : 0));
+}
+
+void BatchSimulator::setCounter(const sf::Vector2i& pos, unsigned int bit, uint64_t first) {
+    uint64_t* words = accessSignal(pos);
+    assert(words != nullptr);
+    for (unsigned int i = 0; i < numWords_; ++i) {
+        uint64_t word = 0;
+        for (unsigned int lane = 0; lane < 64; ++lane) {
+            word |= ((first + i * 64 + lane) >> bit & 1) << lane;
+        }
+        words[i] = word;
+        if (extraLogicStates_) {
+            words[numWords_ + i] = ~word;
+        }
+    }
+}
+
+uint64_t BatchSimulator::getTickCount() const {
+    return tickCount_;
+}
+
+void BatchSimulator::tick() {
+    // A fixed number of words lets the compiler unroll (and vectorize) the loops over each lane.
+    if (extraLogicStates_) {
+        if (numWords_ == 1) {
+            tickPlanes<1>();
+        } else if (numWords_ == 2) {
+            tickPlanes<2>();
+        } else {
+            tickPlanes<MAX_WORDS>();
+        }
+    } else {
+        if (numWords_ == 1) {
+            tickWords<1>();
+        } else if (numWords_ == 2) {
+            tickWords<2>();
+        } else {
+            tickWords<MAX_WORDS>();
+        }
+    }
+    ++tickCount_;
+}
+
+uint32_t BatchSimulator::addSignal(State::t state) {
+    const uint32_t signal = static_cast<uint32_t>(getSignalCount());
+    if (!extraLogicStates_) {
+        signals_.resize(signals_.size() + numWords_, (state == State::high ? ~uint64_t(0) : 0));
+    } else {
+        signals_.resize(signals_.size() + numWords_, (state & State::high ? ~uint64_t(0) : 0));
+        signals_.resize(signals_.size() + numWords_, (state & State::low ? ~uint64_t(0) : 0));
+    }
+    return signal;
+}
+
+void BatchSimulator::buildGate(const CircuitGraph::Gate& graphGate) {
+    const TileId::t id = graphGate.id;
+    Gate gate;
+    gate.output = graphGate.output;
+    gate.inputOffset = static_cast<uint32_t>(connections_.size());
+    for (auto source : graphGate.inputs) {
+        if (source != CircuitGraph::NO_SIGNAL) {
+            connections_.push_back(source);
+        }
+    }
+    gate.inputCount = static_cast<uint32_t>(connections_.size()) - gate.inputOffset;
+
+    // Reduce each gate type to an and/or/xor over the inputs (followed by an optional invert). Gates without the
+    // right number of inputs output a constant low (or high for the inverted types), which is an or-gate without
+    // inputs. See `evaluateGate()` for the rules.
+    const bool singleInput = (id == TileId::gateDiode || id == TileId::gateBuffer || id == TileId::gateNot);
+    bool validInputs = (singleInput ? gate.inputCount == 1 : gate.inputCount >= 2);
+    gate.invert = (id == TileId::gateNot || id == TileId::gateNand || id == TileId::gateNor || id == TileId::gateXnor);
+    const bool tristate = (extraLogicStates_ && gate.inputCount == 2 && (id == TileId::gateBuffer || id == TileId::gateNot));
+    if (tristate) {
+        // The tri-state buffer takes the input from the back and the control from one of the sides.
+        const uint32_t input = graphGate.inputs[1];
+        const uint32_t control = (graphGate.inputs[0] != CircuitGraph::NO_SIGNAL ? graphGate.inputs[0] : graphGate.inputs[2]);
+        if (input != CircuitGraph::NO_SIGNAL) {
+            connections_[gate.inputOffset] = input;
+            connections_[gate.inputOffset + 1] = control;
+            gate.op = TileId::gateBuffer;
+            gates_.push_back(gate);
+            return;
+        }
+        validInputs = false;
+    }
+    if (!validInputs) {
+        connections_.resize(gate.inputOffset);
+        gate.inputCount = 0;
+        gate.op = TileId::gateOr;
+    } else if (id == TileId::gateAnd || id == TileId::gateNand) {
+        gate.op = TileId::gateAnd;
+    } else if (id == TileId::gateXor || id == TileId::gateXnor) {
+        gate.op = TileId::gateXor;
+    } else {
+        gate.op = TileId::gateOr;
+    }
+    gates_.push_back(gate);
+}
+
+template<unsigned int Words>
+void BatchSimulator::tickWords() {
+    // Gates read the signals from the last tick, so the new states are kept separate until all gates are done.
+    uint64_t* nextState = nextGateStates_.data();
+    for (const auto& gate : gates_) {
+        uint64_t result[Words];
+        const uint64_t initial = (gate.op == TileId::gateAnd ? ~uint64_t(0) : 0);
+        for (unsigned int i = 0; i < Words; ++i) {
+            result[i] = initial;
+        }
+        for (uint32_t j = gate.inputOffset; j < gate.inputOffset + gate.inputCount; ++j) {
+            const uint64_t* input = &signals_[connections_[j] * Words];
+            if (gate.op == TileId::gateAnd) {
+                for (unsigned int i = 0; i < Words; ++i) {
+                    result[i] &= input[i];
+                }
+            } else if (gate.op == TileId::gateOr) {
+                for (unsigned int i = 0; i < Words; ++i) {
+                    result[i] |= input[i];
+                }
+            } else {
+                for (unsigned int i = 0; i < Words; ++i) {
+                    result[i] ^= input[i];
+                }
+            }
+        }
+        const uint64_t invertMask = (gate.invert ? ~uint64_t(0) : 0);
+        for (unsigned int i = 0; i < Words; ++i) {
+            nextState[i] = result[i] ^ invertMask;
+        }
+        nextState += Words;
+    }
+    nextState = nextGateStates_.data();
+    for (const auto& gate : gates_) {
+        uint64_t* output = &signals_[gate.output * Words];
+        for (unsigned int i = 0; i < Words; ++i) {
+            output[i] = nextState[i];
+        }
+        nextState += Words;
+    }
+
+    // Nets take the new gate states right away, then the LEDs update from the nets.
+    for (auto groups : {&nets_, &ledGroups_}) {
+        for (const auto& group : *groups) {
+            uint64_t result[Words] = {};
+            for (uint32_t j = group.driverOffset; j < group.driverOffset + group.driverCount; ++j) {
+                const uint64_t* driver = &signals_[connections_[j] * Words];
+                for (unsigned int i = 0; i < Words; ++i) {
+                    result[i] |= driver[i];
+                }
+            }
+            uint64_t* output = &signals_[group.output * Words];
+            for (unsigned int i = 0; i < Words; ++i) {
+                output[i] = result[i];
+            }
+        }
+    }
+}
+
+template<unsigned int Words>
+void BatchSimulator::tickPlanes() {
+    // Each signal is the high plane followed by the low plane. A lane is high if only the high bit is set, middle
+    // if both are set, and low if only the low bit is set.
+    constexpr unsigned int STRIDE = Words * 2;
+    uint64_t* nextState = nextGateStates_.data();
+    for (const auto& gate : gates_) {
+        uint64_t high[Words], low[Words];
+        if (gate.op == TileId::gateAnd) {
+            // High if all inputs are high, middle if all are high or middle, low otherwise.
+            uint64_t allHigh[Words], allSet[Words];
+            for (unsigned int i = 0; i < Words; ++i) {
+                allHigh[i] = ~uint64_t(0);
+                allSet[i] = ~uint64_t(0);
+            }
+            for (uint32_t j = gate.inputOffset; j < gate.inputOffset + gate.inputCount; ++j) {
+                const uint64_t* input = &signals_[connections_[j] * STRIDE];
+                for (unsigned int i = 0; i < Words; ++i) {
+                    allHigh[i] &= input[i] & ~input[Words + i];
+                    allSet[i] &= input[i];
+                }
+            }
+            for (unsigned int i = 0; i < Words; ++i) {
+                high[i] = allSet[i];
+                low[i] = ~allHigh[i];
+            }
+        } else if (gate.op == TileId::gateOr) {
+            // High if any input is high, middle if any is middle, low otherwise.
+            uint64_t anyHigh[Words] = {}, anySet[Words] = {};
+            for (uint32_t j = gate.inputOffset; j < gate.inputOffset + gate.inputCount; ++j) {
+                const uint64_t* input = &signals_[connections_[j] * STRIDE];
+                for (unsigned int i = 0; i < Words; ++i) {
+                    anyHigh[i] |= input[i] & ~input[Words + i];
+                    anySet[i] |= input[i];
+                }
+            }
+            for (unsigned int i = 0; i < Words; ++i) {
+                high[i] = anySet[i];
+                low[i] = ~anyHigh[i];
+            }
+        } else if (gate.op == TileId::gateXor) {
+            // Middle if any input is middle, otherwise the parity of the high inputs.
+            uint64_t anyMiddle[Words] = {}, parity[Words] = {};
+            for (uint32_t j = gate.inputOffset; j < gate.inputOffset + gate.inputCount; ++j) {
+                const uint64_t* input = &signals_[connections_[j] * STRIDE];
+                for (unsigned int i = 0; i < Words; ++i) {
+                    anyMiddle[i] |= input[i] & input[Words + i];
+                    parity[i] ^= input[i] & ~input[Words + i];
+                }
+            }
+            for (unsigned int i = 0; i < Words; ++i) {
+                high[i] = anyMiddle[i] | parity[i];
+                low[i] = anyMiddle[i] | ~parity[i];
+            }
+        } else {
+            // Tri-state buffer, passes the input through when the control is high and outputs middle otherwise.
+            const uint64_t* input = &signals_[connections_[gate.inputOffset] * STRIDE];
+            const uint64_t* control = &signals_[connections_[gate.inputOffset + 1] * STRIDE];
+            for (unsigned int i = 0; i < Words; ++i) {
+                const uint64_t controlHigh = control[i] & ~control[Words + i];
+                high[i] = (input[i] & controlHigh) | ~controlHigh;
+                low[i] = (input[Words + i] & controlHigh) | ~controlHigh;
+            }
+        }
+        for (unsigned int i = 0; i < Words; ++i) {
+            nextState[i] = (gate.invert ? low[i] : high[i]);
+            nextState[Words + i] = (gate.invert ? high[i] : low[i]);
+        }
+        nextState += STRIDE;
+    }
+    nextState = nextGateStates_.data();
+    for (const auto& gate : gates_) {
+        uint64_t* output = &signals_[gate.output * STRIDE];
+        for (unsigned int i = 0; i < STRIDE; ++i) {
+            output[i] = nextState[i];
+        }
+        nextState += STRIDE;
+    }
+
+    // A conflict between high and low drivers is middle, a middle driver only counts when there are no others.
+    for (const auto& net : nets_) {
+        uint64_t anyHigh[Words] = {}, anyLow[Words] = {}, anyMiddle[Words] = {};
+        for (uint32_t j = net.driverOffset; j < net.driverOffset + net.driverCount; ++j) {
+            const uint64_t* driver = &signals_[connections_[j] * STRIDE];
+            for (unsigned int i = 0; i < Words; ++i) {
+                anyHigh[i] |= driver[i] & ~driver[Words + i];
+                anyLow[i] |= ~driver[i] & driver[Words + i];
+                anyMiddle[i] |= driver[i] & driver[Words + i];
+            }
+        }
+        uint64_t* output = &signals_[net.output * STRIDE];
+        for (unsigned int i = 0; i < Words; ++i) {
+            output[i] = anyHigh[i] | (anyMiddle[i] & ~anyLow[i]);
+            output[Words + i] = anyLow[i] | ~anyHigh[i];
+        }
+    }
+
+    // LEDs only turn on for a high driver.
+    for (const auto& group : ledGroups_) {
+        uint64_t anyHigh[Words] = {};
+        for (uint32_t j = group.driverOffset; j < group.driverOffset + group.driverCount; ++j) {
+            const uint64_t* driver = &signals_[connections_[j] * STRIDE];
+            for (unsigned int i = 0; i < Words; ++i) {
+                anyHigh[i] |= driver[i] & ~driver[Words + i];
+            }
+        }
+        uint64_t* output = &signals_[group.output * STRIDE];
+        for (unsigned int i = 0; i < Words; ++i) {
+            output[i] = anyHigh[i];
+            output[Words + i] = ~anyHigh[i];
+        }
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <sim/CircuitGraph.h>
+#include <Tile.h>
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <vector>
+
+class Board;
+
+namespace sim {
+
+/**
+ * Simulates many copies of a circuit at once, for running a batch of test
+ * vectors through a design. Each signal (wire net, gate, input, or LED group)
+ * holds one bit per lane in a few 64-bit words, so one tick evaluates every
+ * lane together with bitwise operations.
+ *
+ * The circuit is extracted from the board once with `build()`, and inputs keep
+ * whatever value they are given instead of following the switch or button
+ * behavior. A tick matches a tick of the `Simulator`: gates find their next
+ * state from the current signals, then the nets and LEDs take the state of
+ * their drivers.
+ *
+ * With extra logic states, each signal uses two bit planes (one word array
+ * for each) that match the bits of `State::t`. The high plane is set for high
+ * and middle, and the low plane is set for low and middle. Gates, driver
+ * conflicts, and the tri-state buffer are then bitwise operations across the
+ * planes, with no branching on the state of a lane. Inverting a state just
+ * swaps the two planes.
+ */
+class BatchSimulator {
+public:
+    // Supported number of words per signal, from 64 up to 256 lanes.
+    static constexpr unsigned int MAX_WORDS = 4;
+
+    BatchSimulator(Board& board, unsigned int numWords = 1);
+    BatchSimulator(const BatchSimulator& rhs) = delete;
+    BatchSimulator& operator=(const BatchSimulator& rhs) = delete;
+
+    // Extracts the circuit from the loaded chunks, each lane starts with the current state of the tiles.
+    void build();
+    unsigned int getWordCount() const;
+    unsigned int getLaneCount() const;
+    bool getExtraLogicStates() const;
+    size_t getSignalCount() const;
+    size_t getGateCount() const;
+    // Finds the words for the signal at a tile (the channel selects the path through a crossover), or nullptr if
+    // none. With extra logic states, the words for the high plane are followed by the words for the low plane.
+    uint64_t* accessSignal(const sf::Vector2i& pos, int channel = 0);
+    State::t getLaneState(const sf::Vector2i& pos, unsigned int lane, int channel = 0);
+    // Sets each lane of the signal to bit `bit` of (`first` + lane index), so a group of inputs counts through each combination.
+    void setCounter(const sf::Vector2i& pos, unsigned int bit, uint64_t first);
+    uint64_t getTickCount() const;
+    void tick();
+
+private:
+    struct Gate {
+        uint32_t output;
+        uint32_t inputOffset, inputCount;
+        TileId::t op;
+        bool invert;
+    };
+
+    // A wire net or LED group, the state is high when any driver is high.
+    struct Group {
+        uint32_t output;
+        uint32_t driverOffset, driverCount;
+    };
+
+    uint32_t addSignal(State::t state);
+    void buildGate(const CircuitGraph::Gate& graphGate);
+    template<unsigned int Words>
+    void tickWords();
+    template<unsigned int Words>
+    void tickPlanes();
+
+    Board& board_;
+    unsigned int numWords_;
+    bool extraLogicStates_;
+    unsigned int numPlanes_;
+    CircuitGraph graph_;
+    std::vector<uint64_t> signals_, nextGateStates_;
+    std::vector<Gate> gates_;
+    std::vector<Group> nets_, ledGroups_;
+    std::vector<uint32_t> connections_;
+    uint64_t tickCount_;
+};
+
+} // namespace sim
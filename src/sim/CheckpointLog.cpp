@@ -0,0 +1,154 @@
+#include <sim/CheckpointLog.h>
+
+#include <cassert>
+
+namespace sim {
+
+constexpr size_t CheckpointLog::KEYFRAME_INTERVAL;
+
+CheckpointLog::CheckpointLog() :
+    checkpoints_(),
+    lastTiles_(),
+    sinceKeyframe_(0),
+    byteCount_(0),
+    maxBytes_(0) {
+}
+
+void CheckpointLog::setMaxBytes(size_t maxBytes) {
+    maxBytes_ = maxBytes;
+    while (maxBytes_ != 0 && byteCount_ > maxBytes_ && dropOldest()) {}
+}
+
+size_t CheckpointLog::getMaxBytes() const {
+    return maxBytes_;
+}
+
+size_t CheckpointLog::getByteCount() const {
+    return byteCount_;
+}
+
+size_t CheckpointLog::size() const {
+    return checkpoints_.size();
+}
+
+bool CheckpointLog::empty() const {
+    return checkpoints_.empty();
+}
+
+uint64_t CheckpointLog::getOldestTick() const {
+    assert(!checkpoints_.empty());
+    return checkpoints_.front().tick;
+}
+
+void CheckpointLog::clear() {
+    checkpoints_.clear();
+    std::vector<uint32_t>().swap(lastTiles_);
+    sinceKeyframe_ = 0;
+    byteCount_ = 0;
+}
+
+void CheckpointLog::add(const Snapshot& snapshot) {
+    assert(checkpoints_.empty() || checkpoints_.back().tick <= snapshot.tick);
+    const bool keyframe = (checkpoints_.empty() || sinceKeyframe_ + 1 >= KEYFRAME_INTERVAL);
+    checkpoints_.push_back({snapshot.tick, keyframe, {}, snapshot.queuedTiles, snapshot.timedTiles});
+    auto& checkpoint = checkpoints_.back();
+    static const std::vector<uint32_t> noTiles;
+    encodeDelta(snapshot.tiles, (keyframe ? noTiles : lastTiles_), checkpoint.tileDelta);
+    checkpoint.tileDelta.shrink_to_fit();
+    lastTiles_ = snapshot.tiles;
+    sinceKeyframe_ = (keyframe ? 0 : sinceKeyframe_ + 1);
+    byteCount_ += countBytes(checkpoint);
+    while (maxBytes_ != 0 && byteCount_ > maxBytes_ && dropOldest()) {}
+}
+
+bool CheckpointLog::rewind(uint64_t tick, Snapshot& snapshot) {
+    size_t index = checkpoints_.size();
+    while (index > 0 && checkpoints_[index - 1].tick > tick) {
+        --index;
+    }
+    if (index == 0) {
+        return false;
+    }
+    --index;
+    size_t keyframeIndex = index;
+    while (!checkpoints_[keyframeIndex].keyframe) {
+        --keyframeIndex;
+    }
+
+    snapshot.tiles.clear();
+    for (size_t i = keyframeIndex; i <= index; ++i) {
+        applyDelta(checkpoints_[i].tileDelta, snapshot.tiles);
+    }
+    const auto& checkpoint = checkpoints_[index];
+    snapshot.tick = checkpoint.tick;
+    snapshot.queuedTiles = checkpoint.queuedTiles;
+    snapshot.timedTiles = checkpoint.timedTiles;
+
+    while (checkpoints_.size() > index + 1) {
+        byteCount_ -= countBytes(checkpoints_.back());
+        checkpoints_.pop_back();
+    }
+    lastTiles_ = snapshot.tiles;
+    sinceKeyframe_ = index - keyframeIndex;
+    return true;
+}
+
+void CheckpointLog::encodeDelta(const std::vector<uint32_t>& tiles, const std::vector<uint32_t>& lastTiles, std::vector<uint32_t>& delta) {
+    auto tileDiff = [&tiles, &lastTiles](size_t i) {
+        return tiles[i] ^ (i < lastTiles.size() ? lastTiles[i] : 0);
+    };
+    delta.clear();
+    delta.push_back(static_cast<uint32_t>(tiles.size()));
+    size_t i = 0;
+    while (i < tiles.size()) {
+        const size_t runStart = i;
+        while (i < tiles.size() && tileDiff(i) == 0) {
+            ++i;
+        }
+        delta.push_back(static_cast<uint32_t>(i - runStart));
+        const size_t countIndex = delta.size();
+        delta.push_back(0);
+        while (i < tiles.size() && tileDiff(i) != 0) {
+            delta.push_back(tileDiff(i));
+            ++i;
+        }
+        delta[countIndex] = static_cast<uint32_t>(delta.size() - countIndex - 1);
+    }
+}
+
+void CheckpointLog::applyDelta(const std::vector<uint32_t>& delta, std::vector<uint32_t>& tiles) {
+    // Tiles that weren't in the previous checkpoint count as zero.
+    tiles.resize(delta[0], 0);
+    size_t tileIndex = 0;
+    for (size_t i = 1; i < delta.size();) {
+        tileIndex += delta[i];
+        const uint32_t literalCount = delta[i + 1];
+        i += 2;
+        for (uint32_t j = 0; j < literalCount; ++j) {
+            tiles[tileIndex++] ^= delta[i++];
+        }
+    }
+}
+
+size_t CheckpointLog::countBytes(const Checkpoint& checkpoint) {
+    return sizeof(Checkpoint) + checkpoint.tileDelta.capacity() * sizeof(uint32_t) +
+        checkpoint.queuedTiles.capacity() * sizeof(TileRef) + checkpoint.timedTiles.capacity() * sizeof(TimedTile);
+}
+
+bool CheckpointLog::dropOldest() {
+    // A keyframe can only go along with the deltas that build on it, and the newest one always stays.
+    size_t nextKeyframe = 1;
+    while (nextKeyframe < checkpoints_.size() && !checkpoints_[nextKeyframe].keyframe) {
+        ++nextKeyframe;
+    }
+    if (nextKeyframe >= checkpoints_.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < nextKeyframe; ++i) {
+        byteCount_ -= countBytes(checkpoints_.front());
+        checkpoints_.pop_front();
+    }
+    return true;
+}
+
+} // namespace sim
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <sim/TileRef.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Stores snapshots of the simulation taken every so often, so that the
+ * `Simulator` can jump back to an earlier tick without running again from the
+ * start.
+ *
+ * A snapshot has the tile data of every chunk along with the updates waiting
+ * in the queues. Most tiles don't change between two checkpoints, so each
+ * checkpoint only keeps the XOR of the tile data with the previous one, and
+ * the runs of zeros in that get compressed away. Every `KEYFRAME_INTERVAL`
+ * checkpoints the full tile data is stored instead (the XOR against zero),
+ * which bounds the number of deltas needed to rebuild a snapshot. The queues
+ * are small and get stored as they are.
+ *
+ * With a memory limit, the oldest checkpoints get dropped first (a keyframe
+ * and the deltas that build on it go together).
+ */
+class CheckpointLog {
+public:
+    static constexpr size_t KEYFRAME_INTERVAL = 16;
+
+    struct TimedTile {
+        uint64_t tick;
+        TileRef tile;
+        bool releaseButton;
+        bool adjacentUpdates;
+    };
+
+    struct Snapshot {
+        uint64_t tick;
+        // The packed `TileData` of each chunk, `Chunk::WIDTH * Chunk::WIDTH` values for each simulator slot.
+        std::vector<uint32_t> tiles;
+        // Tiles queued for the next tick, and the updates scheduled for a later tick.
+        std::vector<TileRef> queuedTiles;
+        std::vector<TimedTile> timedTiles;
+    };
+
+    CheckpointLog();
+    CheckpointLog(const CheckpointLog& rhs) = delete;
+    CheckpointLog& operator=(const CheckpointLog& rhs) = delete;
+
+    // Limits the memory used by the checkpoints (in bytes), zero means no limit.
+    void setMaxBytes(size_t maxBytes);
+    size_t getMaxBytes() const;
+    size_t getByteCount() const;
+    size_t size() const;
+    bool empty() const;
+    uint64_t getOldestTick() const;
+    void clear();
+    // Adds a checkpoint, snapshots need to be added in tick order.
+    void add(const Snapshot& snapshot);
+    // Rebuilds the snapshot from the latest checkpoint at or before `tick`. The checkpoints after it are dropped,
+    // since the simulation continues from there. Returns false if there is no checkpoint that early.
+    bool rewind(uint64_t tick, Snapshot& snapshot);
+
+private:
+    struct Checkpoint {
+        uint64_t tick;
+        bool keyframe;
+        // Number of tile values, followed by pairs of a zero run length and literal count (with the literals after).
+        std::vector<uint32_t> tileDelta;
+        std::vector<TileRef> queuedTiles;
+        std::vector<TimedTile> timedTiles;
+    };
+
+    static void encodeDelta(const std::vector<uint32_t>& tiles, const std::vector<uint32_t>& lastTiles, std::vector<uint32_t>& delta);
+    static void applyDelta(const std::vector<uint32_t>& delta, std::vector<uint32_t>& tiles);
+    static size_t countBytes(const Checkpoint& checkpoint);
+    // Drops the oldest keyframe and its deltas, returns false if that would leave no checkpoints.
+    bool dropOldest();
+
+    std::deque<Checkpoint> checkpoints_;
+    // Full tile data for the newest checkpoint, the next delta is against this.
+    std::vector<uint32_t> lastTiles_;
+    size_t sinceKeyframe_;
+    size_t byteCount_, maxBytes_;
+};
+
+} // namespace sim
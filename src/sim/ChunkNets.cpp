@@ -0,0 +1,155 @@
+#include <MakeUnique.h>
+#include <sim/ChunkNets.h>
+#include <sim/TileLogic.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace sim {
+
+namespace {
+
+constexpr int CHANNELS_PER_CHUNK = Chunk::WIDTH * Chunk::WIDTH * 2;
+
+}
+
+constexpr uint16_t ChunkNets::NO_SEGMENT;
+
+unsigned int ChunkNets::portToTileIndex(Direction::t side, unsigned int offset) {
+    switch (side) {
+    case Direction::north:
+        return offset;
+    case Direction::east:
+        return offset * Chunk::WIDTH + Chunk::WIDTH - 1;
+    case Direction::south:
+        return (Chunk::WIDTH - 1) * Chunk::WIDTH + offset;
+    default:
+        return offset * Chunk::WIDTH;
+    }
+}
+
+ChunkNets::ChunkNets() :
+    built_(false),
+    segmentIds_(),
+    portSegmentIds_(),
+    segments_(),
+    wires_(),
+    endpoints_(),
+    ports_() {
+}
+
+bool ChunkNets::isBuilt() const {
+    return built_;
+}
+
+void ChunkNets::invalidate() {
+    built_ = false;
+}
+
+void ChunkNets::build(const TileData* tiles) {
+    if (!segmentIds_) {
+        segmentIds_ = details::make_unique<uint16_t[]>(CHANNELS_PER_CHUNK);
+    }
+    std::fill(segmentIds_.get(), segmentIds_.get() + CHANNELS_PER_CHUNK, NO_SEGMENT);
+    portSegmentIds_.fill(NO_SEGMENT);
+    segments_.clear();
+    wires_.clear();
+    endpoints_.clear();
+    ports_.clear();
+
+    std::vector<LocalWire> wireNodes;
+    for (unsigned int i = 0; i < Chunk::WIDTH * Chunk::WIDTH; ++i) {
+        if (!isWire(tiles[i].id)) {
+            continue;
+        }
+        const int numChannels = (tiles[i].id == TileId::wireCrossover ? 2 : 1);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            if (segmentIds_[i * 2 + channel] != NO_SEGMENT) {
+                continue;
+            }
+
+            // Depth-first traversal of the wire, stopping at the chunk edges.
+            const uint16_t segmentId = static_cast<uint16_t>(segments_.size());
+            assert(segmentId != NO_SEGMENT);
+            Segment segment = {
+                static_cast<uint32_t>(wires_.size()), 0,
+                static_cast<uint32_t>(endpoints_.size()), 0,
+                static_cast<uint32_t>(ports_.size()), 0
+            };
+            segmentIds_[i * 2 + channel] = segmentId;
+            wireNodes.push_back({static_cast<uint16_t>(i), static_cast<uint8_t>(channel)});
+            while (!wireNodes.empty()) {
+                const LocalWire node = wireNodes.back();
+                wireNodes.pop_back();
+                wires_.push_back(node);
+
+                const uint8_t sides = channelSides(tiles[node.index], node.channel);
+                const int x = node.index % Chunk::WIDTH, y = node.index / Chunk::WIDTH;
+                for (int j = 0; j < 4; ++j) {
+                    if (!(sides & (1 << j))) {
+                        continue;
+                    }
+                    const int adjacentX = x + DIRECTION_X[j], adjacentY = y + DIRECTION_Y[j];
+                    if (adjacentX < 0 || adjacentX >= Chunk::WIDTH || adjacentY < 0 || adjacentY >= Chunk::WIDTH) {
+                        const uint8_t offset = static_cast<uint8_t>(j % 2 == 0 ? x : y);
+                        portSegmentIds_[j * Chunk::WIDTH + offset] = segmentId;
+                        ports_.push_back({static_cast<Direction::t>(j), offset});
+                        continue;
+                    }
+
+                    const uint16_t adjacentIndex = static_cast<uint16_t>(adjacentY * Chunk::WIDTH + adjacentX);
+                    const TileData adjacentData = tiles[adjacentIndex];
+                    const Direction::t backDir = opposite(static_cast<Direction::t>(j));
+                    if (isWire(adjacentData.id)) {
+                        if (wireSides(adjacentData) & (1 << backDir)) {
+                            const int adjacentChannel = wireChannel(adjacentData, backDir);
+                            if (segmentIds_[adjacentIndex * 2 + adjacentChannel] == NO_SEGMENT) {
+                                segmentIds_[adjacentIndex * 2 + adjacentChannel] = segmentId;
+                                wireNodes.push_back({adjacentIndex, static_cast<uint8_t>(adjacentChannel)});
+                            }
+                        }
+                    } else if (isInput(adjacentData.id) || isGate(adjacentData.id) || adjacentData.id == TileId::outLed) {
+                        endpoints_.push_back({adjacentIndex, backDir});
+                    }
+                }
+            }
+            segment.wireCount = static_cast<uint32_t>(wires_.size()) - segment.wireOffset;
+            segment.endpointCount = static_cast<uint32_t>(endpoints_.size()) - segment.endpointOffset;
+            segment.portCount = static_cast<uint32_t>(ports_.size()) - segment.portOffset;
+            segments_.push_back(segment);
+        }
+    }
+    built_ = true;
+}
+
+uint16_t ChunkNets::getSegmentId(unsigned int tileIndex, int channel) const {
+    assert(built_);
+    return segmentIds_[tileIndex * 2 + channel];
+}
+
+uint16_t ChunkNets::getPortSegmentId(Direction::t side, unsigned int offset) const {
+    assert(built_);
+    return portSegmentIds_[side * Chunk::WIDTH + offset];
+}
+
+size_t ChunkNets::getSegmentCount() const {
+    return segments_.size();
+}
+
+const ChunkNets::Segment& ChunkNets::getSegment(uint16_t segmentId) const {
+    return segments_[segmentId];
+}
+
+const ChunkNets::LocalWire* ChunkNets::getWires(const Segment& segment) const {
+    return wires_.data() + segment.wireOffset;
+}
+
+const ChunkNets::LocalEndpoint* ChunkNets::getEndpoints(const Segment& segment) const {
+    return endpoints_.data() + segment.endpointOffset;
+}
+
+const ChunkNets::Port* ChunkNets::getPorts(const Segment& segment) const {
+    return ports_.data() + segment.portOffset;
+}
+
+} // namespace sim
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <Chunk.h>
+#include <Tile.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Summary of how the wires within a single chunk connect together. Wires that
+ * connect inside the chunk form a local segment, and the segments that reach
+ * the edge of the chunk are listed in a port table (one entry for each of the
+ * 4 * `Chunk::WIDTH` edge tiles). A full net is then found by joining segments
+ * through the ports of neighboring chunks, without following each wire tile.
+ *
+ * Endpoints (inputs, gates, and LEDs) next to a segment are recorded if they
+ * are in the same chunk. An endpoint across the chunk edge is found from the
+ * port when joining with the neighbor.
+ */
+class ChunkNets {
+public:
+    static constexpr uint16_t NO_SEGMENT = 0xffff;
+
+    struct LocalWire {
+        uint16_t index;
+        uint8_t channel;
+    };
+
+    struct LocalEndpoint {
+        uint16_t index;
+        Direction::t wireDir;
+    };
+
+    struct Port {
+        Direction::t side;
+        uint8_t offset;
+    };
+
+    struct Segment {
+        uint32_t wireOffset, wireCount;
+        uint32_t endpointOffset, endpointCount;
+        uint32_t portOffset, portCount;
+    };
+
+    // Converts a position on the edge of a chunk to the tile index.
+    static unsigned int portToTileIndex(Direction::t side, unsigned int offset);
+
+    ChunkNets();
+    ChunkNets(const ChunkNets& rhs) = delete;
+    ChunkNets& operator=(const ChunkNets& rhs) = delete;
+    ChunkNets(ChunkNets&& rhs) noexcept = default;
+    ChunkNets& operator=(ChunkNets&& rhs) noexcept = default;
+
+    bool isBuilt() const;
+    void invalidate();
+    void build(const TileData* tiles);
+    uint16_t getSegmentId(unsigned int tileIndex, int channel) const;
+    uint16_t getPortSegmentId(Direction::t side, unsigned int offset) const;
+    size_t getSegmentCount() const;
+    const Segment& getSegment(uint16_t segmentId) const;
+    const LocalWire* getWires(const Segment& segment) const;
+    const LocalEndpoint* getEndpoints(const Segment& segment) const;
+    const Port* getPorts(const Segment& segment) const;
+
+private:
+    using SegmentIdArray = std::unique_ptr<uint16_t[]>;
+
+    bool built_;
+    SegmentIdArray segmentIds_;
+    std::array<uint16_t, 4 * Chunk::WIDTH> portSegmentIds_;
+    std::vector<Segment> segments_;
+    std::vector<LocalWire> wires_;
+    std::vector<LocalEndpoint> endpoints_;
+    std::vector<Port> ports_;
+};
+
+} // namespace sim
@@ -0,0 +1,84 @@
+#include <sim/ChunkResidency.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace sim {
+
+constexpr unsigned int ChunkResidency::MAX_WAKE_SHIFT;
+
+ChunkResidency::ChunkResidency() :
+    chunks_(),
+    sleepTicks_(0),
+    sleepingCount_(0) {
+}
+
+void ChunkResidency::setSleepTicks(uint64_t sleepTicks) {
+    sleepTicks_ = sleepTicks;
+}
+
+uint64_t ChunkResidency::getSleepTicks() const {
+    return sleepTicks_;
+}
+
+void ChunkResidency::clear() {
+    chunks_.clear();
+    sleepingCount_ = 0;
+}
+
+bool ChunkResidency::markActive(uint32_t slot, uint64_t tick) {
+    if (slot >= chunks_.size()) {
+        chunks_.resize(slot + 1, {tick, 0, false});
+    }
+    auto& chunk = chunks_[slot];
+    chunk.lastActiveTick = std::max(chunk.lastActiveTick, tick);
+    if (!chunk.asleep) {
+        return false;
+    }
+    chunk.asleep = false;
+    chunk.wakeCount = std::min(chunk.wakeCount + 1, MAX_WAKE_SHIFT);
+    --sleepingCount_;
+    return true;
+}
+
+bool ChunkResidency::isAsleep(uint32_t slot) const {
+    return slot < chunks_.size() && chunks_[slot].asleep;
+}
+
+size_t ChunkResidency::getSleepingCount() const {
+    return sleepingCount_;
+}
+
+void ChunkResidency::findSleepers(uint64_t tick, std::vector<uint32_t>& sleepers) {
+    if (sleepTicks_ == 0) {
+        return;
+    }
+    for (uint32_t slot = 0; slot < chunks_.size(); ++slot) {
+        auto& chunk = chunks_[slot];
+        if (!chunk.asleep && tick >= chunk.lastActiveTick && tick - chunk.lastActiveTick >= (sleepTicks_ << chunk.wakeCount)) {
+            chunk.asleep = true;
+            ++sleepingCount_;
+            sleepers.push_back(slot);
+        }
+    }
+}
+
+void ChunkResidency::findEvictions(uint64_t tick, uint64_t minQuietTicks, size_t count, std::vector<uint32_t>& sleepers) {
+    // Pairs of the tick the chunk would go to sleep at and the slot.
+    std::vector<std::pair<uint64_t, uint32_t>> candidates;
+    for (uint32_t slot = 0; slot < chunks_.size(); ++slot) {
+        const auto& chunk = chunks_[slot];
+        if (!chunk.asleep && tick >= chunk.lastActiveTick && tick - chunk.lastActiveTick >= minQuietTicks) {
+            candidates.emplace_back(chunk.lastActiveTick + (std::max<uint64_t>(sleepTicks_, 1) << chunk.wakeCount), slot);
+        }
+    }
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+    for (size_t i = 0; i < count; ++i) {
+        chunks_[candidates[i].second].asleep = true;
+        sleepers.push_back(candidates[i].second);
+    }
+    sleepingCount_ += count;
+}
+
+} // namespace sim
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Tracks which of the simulator's chunks are active, so that chunks that have
+ * gone quiet can go to sleep (and give up their memory) until an update
+ * reaches them again. This is separate from the chunks the board keeps loaded
+ * for drawing, a chunk is only unloaded when neither needs it.
+ *
+ * A chunk goes to sleep after `sleepTicks` without any activity, checked by a
+ * periodic cleanup instead of every tick. Chunks that keep waking up stay
+ * around longer: the time doubles on each wake, up to a limit. This follows
+ * the chunk cleanup idea in devnotes.txt.
+ *
+ * When there is a limit on the chunks kept in memory, chunks can also be put
+ * to sleep before their time is up. The ones that would go to sleep next are
+ * picked first.
+ */
+class ChunkResidency {
+public:
+    // The most times the sleep time gets doubled for a chunk that keeps waking up.
+    static constexpr unsigned int MAX_WAKE_SHIFT = 4;
+
+    ChunkResidency();
+
+    // Number of quiet ticks before a chunk goes to sleep, zero disables sleeping.
+    void setSleepTicks(uint64_t sleepTicks);
+    uint64_t getSleepTicks() const;
+    void clear();
+    // Keeps the chunk in the slot awake until at least `tick`, new slots start out awake. Returns true if the chunk
+    // was asleep.
+    bool markActive(uint32_t slot, uint64_t tick);
+    bool isAsleep(uint32_t slot) const;
+    size_t getSleepingCount() const;
+    // Puts the chunks that have been quiet for long enough to sleep and adds their slots to `sleepers`.
+    void findSleepers(uint64_t tick, std::vector<uint32_t>& sleepers);
+    // Puts up to `count` chunks to sleep early to free up memory, starting with the ones closest to going to sleep on
+    // their own. Chunks active in the last `minQuietTicks` are left alone so that hot chunks don't thrash.
+    void findEvictions(uint64_t tick, uint64_t minQuietTicks, size_t count, std::vector<uint32_t>& sleepers);
+
+private:
+    struct ChunkActivity {
+        uint64_t lastActiveTick;
+        unsigned int wakeCount;
+        bool asleep;
+    };
+
+    std::vector<ChunkActivity> chunks_;
+    uint64_t sleepTicks_;
+    size_t sleepingCount_;
+};
+
+} // namespace sim
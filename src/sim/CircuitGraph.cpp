@@ -0,0 +1,230 @@
+#include <Board.h>
+#include <sim/CircuitGraph.h>
+#include <sim/TileLogic.h>
+
+#include <tuple>
+
+namespace sim {
+
+namespace {
+
+constexpr int constLog2(int x) {
+    return x == 1 ? 0 : 1 + constLog2(x / 2);
+}
+
+constexpr int WIDTH_LOG2 = constLog2(Chunk::WIDTH);
+
+}
+
+constexpr uint32_t CircuitGraph::NO_SIGNAL;
+
+CircuitGraph::CircuitGraph() :
+    board_(nullptr),
+    tileSignals_(),
+    initialStates_(),
+    gates_(),
+    nets_(),
+    ledGroups_() {
+}
+
+void CircuitGraph::build(Board& board) {
+    board_ = &board;
+    tileSignals_.clear();
+    initialStates_.clear();
+    gates_.clear();
+    nets_.clear();
+    ledGroups_.clear();
+
+    // Collect the coords first, finding a chunk can load more chunks into the board.
+    std::vector<ChunkCoords::repr> loadedCoords;
+    loadedCoords.reserve(board.getLoadedChunks().size());
+    for (const auto& chunk : board.getLoadedChunks()) {
+        loadedCoords.push_back(chunk.first);
+    }
+    std::vector<sf::Vector2i> tilePositions;
+    for (auto coords : loadedCoords) {
+        Chunk* chunk = board.findChunk(coords);
+        for (unsigned int i = 0; chunk != nullptr && i < Chunk::WIDTH * Chunk::WIDTH; ++i) {
+            const TileId::t id = chunk->accessTile(i).getRawData().id;
+            if (id != TileId::blank && id != TileId::label) {
+                tilePositions.emplace_back(ChunkCoords::x(coords) * Chunk::WIDTH + static_cast<int>(i % Chunk::WIDTH), ChunkCoords::y(coords) * Chunk::WIDTH + static_cast<int>(i / Chunk::WIDTH));
+            }
+        }
+    }
+
+    // First pass gives every net, gate, input, and LED group a signal.
+    for (const auto& pos : tilePositions) {
+        const TileData tileData = getTileData(pos.x, pos.y);
+        if (isWire(tileData.id)) {
+            for (int channel = 0; channel < (tileData.id == TileId::wireCrossover ? 2 : 1); ++channel) {
+                if (findSignal(pos, channel) == NO_SIGNAL) {
+                    buildWireNet(pos.x, pos.y, channel);
+                }
+            }
+        } else if (tileData.id == TileId::outLed) {
+            if (tileSignals_.count(packPosition(pos.x, pos.y)) == 0) {
+                buildLedGroup(pos.x, pos.y);
+            }
+        } else {
+            tileSignals_[packPosition(pos.x, pos.y)] = {addSignal(tileData.state1), NO_SIGNAL};
+        }
+    }
+
+    // Second pass connects the signals together. Nets and LED groups collect the drivers from each tile first.
+    std::vector<std::vector<uint32_t>> drivers(getSignalCount());
+    for (const auto& pos : tilePositions) {
+        const TileData tileData = getTileData(pos.x, pos.y);
+        if (isGate(tileData.id)) {
+            buildGate(pos.x, pos.y, tileData);
+            continue;
+        } else if (!isWire(tileData.id) && tileData.id != TileId::outLed) {
+            continue;
+        }
+        const auto& tileSignal = tileSignals_[packPosition(pos.x, pos.y)];
+        for (int i = 0; i < 4; ++i) {
+            const TileData adjacentData = getTileData(pos.x + DIRECTION_X[i], pos.y + DIRECTION_Y[i]);
+            if (isWire(tileData.id) && (wireSides(tileData) & (1 << i)) && !isWire(adjacentData.id)) {
+                const uint32_t source = findSource(pos.x, pos.y, static_cast<Direction::t>(i));
+                if (source != NO_SIGNAL) {
+                    drivers[tileSignal[wireChannel(tileData, static_cast<Direction::t>(i))]].push_back(source);
+                }
+            } else if (tileData.id == TileId::outLed && adjacentData.id != TileId::outLed) {
+                const uint32_t source = findSource(pos.x, pos.y, static_cast<Direction::t>(i));
+                if (source != NO_SIGNAL) {
+                    drivers[tileSignal[0]].push_back(source);
+                }
+            }
+        }
+    }
+    for (auto groups : {&nets_, &ledGroups_}) {
+        for (auto& group : *groups) {
+            group.drivers.swap(drivers[group.output]);
+        }
+    }
+}
+
+size_t CircuitGraph::getSignalCount() const {
+    return initialStates_.size();
+}
+
+uint32_t CircuitGraph::findSignal(const sf::Vector2i& pos, int channel) const {
+    auto tileSignal = tileSignals_.find(packPosition(pos.x, pos.y));
+    return (tileSignal == tileSignals_.end() ? NO_SIGNAL : tileSignal->second[channel]);
+}
+
+const std::vector<State::t>& CircuitGraph::getInitialStates() const {
+    return initialStates_;
+}
+
+const std::vector<CircuitGraph::Gate>& CircuitGraph::getGates() const {
+    return gates_;
+}
+
+const std::vector<CircuitGraph::Group>& CircuitGraph::getNets() const {
+    return nets_;
+}
+
+const std::vector<CircuitGraph::Group>& CircuitGraph::getLedGroups() const {
+    return ledGroups_;
+}
+
+uint64_t CircuitGraph::packPosition(int x, int y) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+}
+
+sf::Vector2i CircuitGraph::unpackPosition(uint64_t pos) {
+    return {static_cast<int>(static_cast<uint32_t>(pos >> 32)), static_cast<int>(static_cast<uint32_t>(pos))};
+}
+
+TileData CircuitGraph::getTileData(int x, int y) const {
+    Chunk* chunk = board_->findChunk(ChunkCoords::pack(x >> WIDTH_LOG2, y >> WIDTH_LOG2));
+    if (chunk == nullptr) {
+        return {};
+    }
+    return chunk->accessTile((x & (Chunk::WIDTH - 1)) + (y & (Chunk::WIDTH - 1)) * Chunk::WIDTH).getRawData();
+}
+
+uint32_t CircuitGraph::addSignal(State::t state) {
+    initialStates_.push_back(state);
+    return static_cast<uint32_t>(initialStates_.size() - 1);
+}
+
+uint32_t CircuitGraph::findSource(int x, int y, Direction::t dir) const {
+    // Same rules as `outputToward()`, but the connection only depends on the structure of the adjacent tile.
+    const int adjacentX = x + DIRECTION_X[dir], adjacentY = y + DIRECTION_Y[dir];
+    const TileData adjacentData = getTileData(adjacentX, adjacentY);
+    const Direction::t side = opposite(dir);
+    int channel;
+    if (isWire(adjacentData.id) && (wireSides(adjacentData) & (1 << side))) {
+        channel = wireChannel(adjacentData, side);
+    } else if (isInput(adjacentData.id) || (isGate(adjacentData.id) && adjacentData.dir == side)) {
+        channel = 0;
+    } else {
+        return NO_SIGNAL;
+    }
+    return findSignal({adjacentX, adjacentY}, channel);
+}
+
+void CircuitGraph::buildWireNet(int x, int y, int channel) {
+    const TileData startData = getTileData(x, y);
+    const uint32_t signal = addSignal(channelState(startData, channel));
+    nets_.push_back({signal, {}});
+
+    std::vector<std::tuple<int, int, int>> wireNodes;
+    auto visit = [this, signal, &wireNodes](int x, int y, int channel) {
+        auto& tileSignal = tileSignals_.emplace(packPosition(x, y), std::array<uint32_t, 2>{{NO_SIGNAL, NO_SIGNAL}}).first->second;
+        if (tileSignal[channel] == NO_SIGNAL) {
+            tileSignal[channel] = signal;
+            wireNodes.emplace_back(x, y, channel);
+        }
+    };
+    visit(x, y, channel);
+    while (!wireNodes.empty()) {
+        int nodeX, nodeY, nodeChannel;
+        std::tie(nodeX, nodeY, nodeChannel) = wireNodes.back();
+        wireNodes.pop_back();
+        const uint8_t sides = channelSides(getTileData(nodeX, nodeY), nodeChannel);
+        for (int i = 0; i < 4; ++i) {
+            if (!(sides & (1 << i))) {
+                continue;
+            }
+            const int adjacentX = nodeX + DIRECTION_X[i], adjacentY = nodeY + DIRECTION_Y[i];
+            const TileData adjacentData = getTileData(adjacentX, adjacentY);
+            const Direction::t backDir = opposite(static_cast<Direction::t>(i));
+            if (isWire(adjacentData.id) && (wireSides(adjacentData) & (1 << backDir))) {
+                visit(adjacentX, adjacentY, wireChannel(adjacentData, backDir));
+            }
+        }
+    }
+}
+
+void CircuitGraph::buildLedGroup(int x, int y) {
+    const uint32_t signal = addSignal(getTileData(x, y).state1);
+    ledGroups_.push_back({signal, {}});
+
+    std::vector<sf::Vector2i> ledNodes;
+    tileSignals_[packPosition(x, y)] = {signal, NO_SIGNAL};
+    ledNodes.emplace_back(x, y);
+    while (!ledNodes.empty()) {
+        const sf::Vector2i led = ledNodes.back();
+        ledNodes.pop_back();
+        for (int i = 0; i < 4; ++i) {
+            const sf::Vector2i adjacent(led.x + DIRECTION_X[i], led.y + DIRECTION_Y[i]);
+            if (getTileData(adjacent.x, adjacent.y).id == TileId::outLed && tileSignals_.emplace(packPosition(adjacent.x, adjacent.y), std::array<uint32_t, 2>{{signal, NO_SIGNAL}}).second) {
+                ledNodes.push_back(adjacent);
+            }
+        }
+    }
+}
+
+void CircuitGraph::buildGate(int x, int y, TileData tileData) {
+    Gate gate;
+    gate.id = tileData.id;
+    gate.output = findSignal({x, y});
+    for (unsigned int i = 1; i < 4; ++i) {
+        gate.inputs[i - 1] = findSource(x, y, static_cast<Direction::t>((tileData.dir + i) % 4));
+    }
+    gates_.push_back(gate);
+}
+
+} // namespace sim
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <Tile.h>
+
+#include <SFML/Graphics.hpp>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+class Board;
+
+namespace sim {
+
+/**
+ * The circuit on a board as a graph of signals, for the simulators that work
+ * on the whole circuit at once instead of on tiles. Each wire net, gate, input,
+ * and LED group becomes a signal. Gates read their input signals, while nets
+ * and LED groups take the state of the signals that drive them.
+ *
+ * The graph only depends on the structure of the tiles, so it needs to be
+ * built again after an edit. Signals are numbered in the order they are found
+ * and keep the state of the tiles at the time of the build.
+ */
+class CircuitGraph {
+public:
+    static constexpr uint32_t NO_SIGNAL = std::numeric_limits<uint32_t>::max();
+
+    struct Gate {
+        TileId::t id;
+        uint32_t output;
+        // The input signals from the right, back, and left sides of the gate (same order as
+        // `packGateInputs()`), or `NO_SIGNAL` if nothing is connected on that side.
+        std::array<uint32_t, 3> inputs;
+    };
+
+    // A wire net or LED group.
+    struct Group {
+        uint32_t output;
+        std::vector<uint32_t> drivers;
+    };
+
+    CircuitGraph();
+
+    // Extracts the circuit from the loaded chunks.
+    void build(Board& board);
+    size_t getSignalCount() const;
+    // Finds the signal for a tile (the channel selects the path through a crossover), or `NO_SIGNAL` if none.
+    uint32_t findSignal(const sf::Vector2i& pos, int channel = 0) const;
+    // Visits the position, channel, and signal of each tile in the circuit. Gates, inputs, and LEDs use channel 0.
+    template<typename Func>
+    void forEachTileSignal(Func func) const;
+    // The state of each signal when the graph was built.
+    const std::vector<State::t>& getInitialStates() const;
+    const std::vector<Gate>& getGates() const;
+    const std::vector<Group>& getNets() const;
+    const std::vector<Group>& getLedGroups() const;
+
+private:
+    static uint64_t packPosition(int x, int y);
+    static sf::Vector2i unpackPosition(uint64_t pos);
+    TileData getTileData(int x, int y) const;
+    uint32_t addSignal(State::t state);
+    uint32_t findSource(int x, int y, Direction::t dir) const;
+    void buildWireNet(int x, int y, int channel);
+    void buildLedGroup(int x, int y);
+    void buildGate(int x, int y, TileData tileData);
+
+    Board* board_;
+    // Signal ids at each tile position, the second entry is only used by crossovers.
+    std::unordered_map<uint64_t, std::array<uint32_t, 2>> tileSignals_;
+    std::vector<State::t> initialStates_;
+    std::vector<Gate> gates_;
+    std::vector<Group> nets_, ledGroups_;
+};
+
+template<typename Func>
+void CircuitGraph::forEachTileSignal(Func func) const {
+    for (const auto& tileSignal : tileSignals_) {
+        for (int channel = 0; channel < 2; ++channel) {
+            if (tileSignal.second[channel] != NO_SIGNAL) {
+                func(unpackPosition(tileSignal.first), channel, tileSignal.second[channel]);
+            }
+        }
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,542 @@
+#include <Board.h>
+#include <sim/CompiledNetlist.h>
+#include <sim/TileLogic.h>
+#include <tiles/Wire.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace sim {
+
+namespace {
+
+constexpr int constLog2(int x) {
+    return x == 1 ? 0 : 1 + constLog2(x / 2);
+}
+
+constexpr int WIDTH_LOG2 = constLog2(Chunk::WIDTH);
+constexpr uint32_t UNVISITED = std::numeric_limits<uint32_t>::max();
+
+}
+
+CompiledNetlist::CompiledNetlist(Board& board) :
+    board_(board),
+    graph_(),
+    extraLogicStates_(false),
+    states_(),
+    instructions_(),
+    feedbackInstructions_(),
+    feedbackLoops_(),
+    drivers_(),
+    dependencyOffsets_(),
+    dependencies_(),
+    nextGateStates_(),
+    aliases_(),
+    constants_(),
+    constantInputs_(false),
+    removeDeadLogic_(false),
+    observedTiles_(),
+    levelCount_(0),
+    feedbackGateCount_(0),
+    constantCount_(0),
+    aliasCount_(0),
+    deadCount_(0) {
+}
+
+void CompiledNetlist::build() {
+    graph_.build(board_);
+    extraLogicStates_ = board_.getExtraLogicStates();
+    const uint32_t numSignals = static_cast<uint32_t>(graph_.getSignalCount());
+    const uint32_t disconnectedSignal = numSignals;
+    states_ = graph_.getInitialStates();
+    states_.push_back(State::disconnected);
+    instructions_.clear();
+    feedbackInstructions_.clear();
+    feedbackLoops_.clear();
+    drivers_.clear();
+    levelCount_ = 0;
+    feedbackGateCount_ = 0;
+    constantCount_ = 0;
+    aliasCount_ = 0;
+    deadCount_ = 0;
+
+    // Find the instruction that computes each signal, inputs are left as `blank` since nothing drives them.
+    std::vector<Instruction> signalInstructions(numSignals, Instruction{TileId::blank, {0, 0, 0}, 0});
+    for (const auto& gate : graph_.getGates()) {
+        Instruction& instruction = signalInstructions[gate.output];
+        instruction.op = gate.id;
+        instruction.output = gate.output;
+        for (int i = 0; i < 3; ++i) {
+            instruction.inputs[i] = (gate.inputs[i] != CircuitGraph::NO_SIGNAL ? gate.inputs[i] : disconnectedSignal);
+        }
+    }
+    for (auto groups : {&graph_.getNets(), &graph_.getLedGroups()}) {
+        for (const auto& group : *groups) {
+            Instruction& instruction = signalInstructions[group.output];
+            instruction.op = (groups == &graph_.getNets() ? TileId::wireStraight : TileId::outLed);
+            instruction.inputs[0] = static_cast<uint32_t>(drivers_.size());
+            instruction.inputs[1] = static_cast<uint32_t>(group.drivers.size());
+            instruction.inputs[2] = 0;
+            instruction.output = group.output;
+            drivers_.insert(drivers_.end(), group.drivers.begin(), group.drivers.end());
+        }
+    }
+
+    // The signals each signal reads from, for finding the feedback loops.
+    dependencyOffsets_.assign(numSignals + 1, 0);
+    dependencies_.clear();
+    for (uint32_t signal = 0; signal < numSignals; ++signal) {
+        const Instruction& instruction = signalInstructions[signal];
+        if (isGate(instruction.op)) {
+            for (auto input : instruction.inputs) {
+                if (input != disconnectedSignal) {
+                    dependencies_.push_back(input);
+                }
+            }
+        } else if (instruction.op != TileId::blank) {
+            dependencies_.insert(dependencies_.end(), drivers_.begin() + instruction.inputs[0], drivers_.begin() + instruction.inputs[0] + instruction.inputs[1]);
+        }
+        dependencyOffsets_[signal + 1] = static_cast<uint32_t>(dependencies_.size());
+    }
+
+    // Levelize the components in order. Anything outside a feedback loop becomes a single instruction (unless it
+    // gets folded into a constant or an alias), and each loop becomes one instruction that runs the whole loop.
+    std::vector<uint32_t> componentSignals, componentOffsets;
+    findComponents(componentSignals, componentOffsets);
+    std::vector<uint32_t> signalComponents(numSignals);
+    for (uint32_t component = 0; component + 1 < componentOffsets.size(); ++component) {
+        for (uint32_t i = componentOffsets[component]; i < componentOffsets[component + 1]; ++i) {
+            signalComponents[componentSignals[i]] = component;
+        }
+    }
+    aliases_.resize(numSignals + 1);
+    for (uint32_t signal = 0; signal <= numSignals; ++signal) {
+        aliases_[signal] = signal;
+    }
+    constants_.assign(numSignals + 1, false);
+    constants_[disconnectedSignal] = true;
+
+    std::vector<unsigned int> levels(numSignals + 1, 0);
+    // Index of the feedback loop each signal is part of, or `UNVISITED` if none.
+    std::vector<uint32_t> signalLoops(numSignals, UNVISITED);
+    std::vector<std::pair<unsigned int, Instruction>> levelInstructions;
+    for (uint32_t component = 0; component + 1 < componentOffsets.size(); ++component) {
+        const uint32_t* signalsBegin = componentSignals.data() + componentOffsets[component];
+        const uint32_t* signalsEnd = componentSignals.data() + componentOffsets[component + 1];
+        bool feedback = (signalsEnd - signalsBegin > 1);
+        for (uint32_t i = dependencyOffsets_[*signalsBegin]; i < dependencyOffsets_[*signalsBegin + 1]; ++i) {
+            feedback = feedback || (dependencies_[i] == *signalsBegin);
+        }
+
+        if (!feedback) {
+            Instruction& instruction = signalInstructions[*signalsBegin];
+            if (instruction.op == TileId::blank) {
+                constants_[*signalsBegin] = constantInputs_;
+                constantCount_ += constantInputs_;
+            } else if (foldInstruction(instruction)) {
+                unsigned int level = 0;
+                forEachInput(instruction, [this,&levels,&level](uint32_t input) {
+                    if (!constants_[input]) {
+                        level = std::max(level, levels[input] + 1);
+                    }
+                });
+                levels[*signalsBegin] = level;
+                levelInstructions.emplace_back(level, instruction);
+            } else {
+                levels[*signalsBegin] = levels[aliases_[*signalsBegin]];
+            }
+            continue;
+        }
+
+        // The gates of a loop go first, then the nets and LEDs that take the new gate states.
+        FeedbackLoop loop = {static_cast<uint32_t>(feedbackInstructions_.size()), 0};
+        unsigned int level = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (const uint32_t* signal = signalsBegin; signal != signalsEnd; ++signal) {
+                Instruction& instruction = signalInstructions[*signal];
+                if (instruction.op == TileId::blank || isGate(instruction.op) != (pass == 0)) {
+                    continue;
+                }
+                forEachInput(instruction, [this,&levels,&level,&signalComponents,component](uint32_t& input) {
+                    input = aliases_[input];
+                    if (!constants_[input] && signalComponents[input] != component) {
+                        level = std::max(level, levels[input] + 1);
+                    }
+                });
+                feedbackInstructions_.push_back(instruction);
+                feedbackGateCount_ += (pass == 0);
+                signalLoops[*signal] = static_cast<uint32_t>(feedbackLoops_.size());
+            }
+        }
+        for (const uint32_t* signal = signalsBegin; signal != signalsEnd; ++signal) {
+            levels[*signal] = level;
+        }
+        loop.instructionCount = static_cast<uint32_t>(feedbackInstructions_.size()) - loop.instructionOffset;
+        levelInstructions.emplace_back(level, Instruction{TileId::blank, {static_cast<uint32_t>(feedbackLoops_.size()), 0, 0}, 0});
+        feedbackLoops_.push_back(loop);
+    }
+    if (removeDeadLogic_) {
+        removeDeadInstructions(signalInstructions, signalLoops, levelInstructions);
+    }
+
+    // The components are already in an order that works, sorting by level groups together the instructions that
+    // don't depend on each other.
+    std::stable_sort(levelInstructions.begin(), levelInstructions.end(), [](const std::pair<unsigned int, Instruction>& lhs, const std::pair<unsigned int, Instruction>& rhs) {
+        return lhs.first < rhs.first;
+    });
+    instructions_.reserve(levelInstructions.size());
+    for (const auto& levelInstruction : levelInstructions) {
+        instructions_.push_back(levelInstruction.second);
+        levelCount_ = std::max(levelCount_, levelInstruction.first + 1);
+    }
+}
+
+void CompiledNetlist::setConstantInputs(bool constantInputs) {
+    constantInputs_ = constantInputs;
+}
+
+bool CompiledNetlist::getConstantInputs() const {
+    return constantInputs_;
+}
+
+void CompiledNetlist::setRemoveDeadLogic(bool removeDeadLogic) {
+    removeDeadLogic_ = removeDeadLogic;
+}
+
+bool CompiledNetlist::getRemoveDeadLogic() const {
+    return removeDeadLogic_;
+}
+
+void CompiledNetlist::addObservedTile(const sf::Vector2i& pos, int channel) {
+    observedTiles_.emplace_back(pos, channel);
+}
+
+void CompiledNetlist::clearObservedTiles() {
+    observedTiles_.clear();
+}
+
+bool CompiledNetlist::getExtraLogicStates() const {
+    return extraLogicStates_;
+}
+
+size_t CompiledNetlist::getSignalCount() const {
+    return graph_.getSignalCount();
+}
+
+size_t CompiledNetlist::getInstructionCount() const {
+    return instructions_.size();
+}
+
+unsigned int CompiledNetlist::getLevelCount() const {
+    return levelCount_;
+}
+
+size_t CompiledNetlist::getFeedbackGateCount() const {
+    return feedbackGateCount_;
+}
+
+size_t CompiledNetlist::getConstantCount() const {
+    return constantCount_;
+}
+
+size_t CompiledNetlist::getAliasCount() const {
+    return aliasCount_;
+}
+
+size_t CompiledNetlist::getDeadCount() const {
+    return deadCount_;
+}
+
+State::t CompiledNetlist::getState(const sf::Vector2i& pos, int channel) const {
+    const uint32_t signal = graph_.findSignal(pos, channel);
+    return (signal == CircuitGraph::NO_SIGNAL ? State::disconnected : states_[aliases_[signal]]);
+}
+
+void CompiledNetlist::setState(const sf::Vector2i& pos, State::t state) {
+    const uint32_t signal = graph_.findSignal(pos);
+    if (signal != CircuitGraph::NO_SIGNAL) {
+        states_[signal] = state;
+    }
+}
+
+bool CompiledNetlist::run(unsigned int maxFeedbackTicks) {
+    bool stable = true;
+    for (const auto& instruction : instructions_) {
+        if (instruction.op == TileId::blank) {
+            stable = runFeedbackLoop(feedbackLoops_[instruction.inputs[0]], maxFeedbackTicks) && stable;
+        } else {
+            states_[instruction.output] = evaluate(instruction);
+        }
+    }
+    return stable;
+}
+
+void CompiledNetlist::writeStates() {
+    graph_.forEachTileSignal([this](const sf::Vector2i& pos, int channel, uint32_t signal) {
+        Chunk* chunk = board_.findChunk(ChunkCoords::pack(pos.x >> WIDTH_LOG2, pos.y >> WIDTH_LOG2));
+        const unsigned int tileIndex = (pos.x & (Chunk::WIDTH - 1)) + (pos.y & (Chunk::WIDTH - 1)) * Chunk::WIDTH;
+        if (chunk == nullptr) {
+            return;
+        } else if (channel == 0) {
+            chunk->accessTile(tileIndex).setState(states_[aliases_[signal]]);
+        } else {
+            tiles::Wire::instance()->setState2(*chunk, tileIndex, states_[aliases_[signal]]);
+        }
+    });
+}
+
+template<typename Func>
+void CompiledNetlist::forEachInput(Instruction& instruction, Func func) {
+    if (isGate(instruction.op)) {
+        for (auto& input : instruction.inputs) {
+            func(input);
+        }
+    } else {
+        for (uint32_t i = instruction.inputs[0]; i < instruction.inputs[0] + instruction.inputs[1]; ++i) {
+            func(drivers_[i]);
+        }
+    }
+}
+
+bool CompiledNetlist::foldInstruction(Instruction& instruction) {
+    forEachInput(instruction, [this](uint32_t& input) {
+        input = aliases_[input];
+    });
+    const uint32_t output = instruction.output;
+
+    if (isGate(instruction.op)) {
+        uint32_t variables[3];
+        unsigned int numVariables = 0;
+        for (auto input : instruction.inputs) {
+            if (!constants_[input] && std::find(variables, variables + numVariables, input) == variables + numVariables) {
+                variables[numVariables++] = input;
+            }
+        }
+
+        // Try the gate with every state the other inputs could have, this finds gates that only ever output one
+        // state (constant) or just pass along a single input (alias).
+        const State::t possibleStates[3] = {State::low, State::high, State::middle};
+        const unsigned int numStates = (extraLogicStates_ ? 3 : 2);
+        unsigned int numCombinations = 1;
+        State::t savedStates[3];
+        for (unsigned int i = 0; i < numVariables; ++i) {
+            numCombinations *= numStates;
+            savedStates[i] = states_[variables[i]];
+        }
+        State::t firstState = State::disconnected;
+        bool constant = true, passThrough = (numVariables == 1);
+        for (unsigned int combination = 0; combination < numCombinations; ++combination) {
+            unsigned int remaining = combination;
+            for (unsigned int i = 0; i < numVariables; ++i) {
+                states_[variables[i]] = possibleStates[remaining % numStates];
+                remaining /= numStates;
+            }
+            const State::t nextState = evaluate(instruction);
+            if (combination == 0) {
+                firstState = nextState;
+            }
+            constant = constant && (nextState == firstState);
+            passThrough = passThrough && (nextState == states_[variables[0]]);
+        }
+        for (unsigned int i = 0; i < numVariables; ++i) {
+            states_[variables[i]] = savedStates[i];
+        }
+
+        if (constant) {
+            states_[output] = firstState;
+            constants_[output] = true;
+            ++constantCount_;
+            return false;
+        } else if (passThrough) {
+            aliases_[output] = variables[0];
+            ++aliasCount_;
+            return false;
+        }
+        return true;
+    }
+
+    // When only a high driver matters (always for LEDs), any other constant driver can be dropped and a constant
+    // high driver decides the state.
+    uint32_t* driversBegin = drivers_.data() + instruction.inputs[0];
+    uint32_t* driversEnd = driversBegin + instruction.inputs[1];
+    if (!extraLogicStates_ || instruction.op == TileId::outLed) {
+        if (std::any_of(driversBegin, driversEnd, [this](uint32_t driver) { return constants_[driver] && states_[driver] == State::high; })) {
+            states_[output] = State::high;
+            constants_[output] = true;
+            ++constantCount_;
+            return false;
+        }
+        driversEnd = std::remove_if(driversBegin, driversEnd, [this](uint32_t driver) { return constants_[driver]; });
+        instruction.inputs[1] = static_cast<uint32_t>(driversEnd - driversBegin);
+    }
+    if (std::all_of(driversBegin, driversEnd, [this](uint32_t driver) { return constants_[driver]; })) {
+        states_[output] = evaluate(instruction);
+        constants_[output] = true;
+        ++constantCount_;
+        return false;
+    } else if (driversEnd - driversBegin == 1 && (instruction.op != TileId::outLed || !extraLogicStates_)) {
+        // A net with one driver always has the same state. An LED with one driver does too, except for the middle
+        // state that shows as low.
+        aliases_[output] = *driversBegin;
+        ++aliasCount_;
+        return false;
+    }
+    return true;
+}
+
+void CompiledNetlist::removeDeadInstructions(std::vector<Instruction>& signalInstructions, const std::vector<uint32_t>& signalLoops, std::vector<std::pair<unsigned int, Instruction>>& levelInstructions) {
+    // Work backwards from the LEDs and observed tiles to find everything that can change them.
+    std::vector<bool> live(states_.size(), false), liveLoops(feedbackLoops_.size(), false);
+    std::vector<uint32_t> liveSignals;
+    auto markLive = [this,&live,&liveSignals](uint32_t signal) {
+        signal = aliases_[signal];
+        if (!live[signal] && !constants_[signal]) {
+            live[signal] = true;
+            liveSignals.push_back(signal);
+        }
+    };
+    for (const auto& group : graph_.getLedGroups()) {
+        markLive(group.output);
+    }
+    for (const auto& observedTile : observedTiles_) {
+        const uint32_t signal = graph_.findSignal(observedTile.first, observedTile.second);
+        if (signal != CircuitGraph::NO_SIGNAL) {
+            markLive(signal);
+        }
+    }
+    while (!liveSignals.empty()) {
+        const uint32_t signal = liveSignals.back();
+        liveSignals.pop_back();
+        const uint32_t loopIndex = signalLoops[signal];
+        if (loopIndex == UNVISITED) {
+            if (signalInstructions[signal].op != TileId::blank) {
+                forEachInput(signalInstructions[signal], markLive);
+            }
+        } else if (!liveLoops[loopIndex]) {
+            liveLoops[loopIndex] = true;
+            const FeedbackLoop& loop = feedbackLoops_[loopIndex];
+            for (uint32_t i = loop.instructionOffset; i < loop.instructionOffset + loop.instructionCount; ++i) {
+                markLive(feedbackInstructions_[i].output);
+                forEachInput(feedbackInstructions_[i], markLive);
+            }
+        }
+    }
+
+    auto deadBegin = std::remove_if(levelInstructions.begin(), levelInstructions.end(), [&live,&liveLoops](const std::pair<unsigned int, Instruction>& levelInstruction) {
+        const Instruction& instruction = levelInstruction.second;
+        return (instruction.op == TileId::blank ? !liveLoops[instruction.inputs[0]] : !live[instruction.output]);
+    });
+    deadCount_ = static_cast<size_t>(levelInstructions.end() - deadBegin);
+    levelInstructions.erase(deadBegin, levelInstructions.end());
+}
+
+State::t CompiledNetlist::evaluate(const Instruction& instruction) const {
+    if (isGate(instruction.op)) {
+        const unsigned int inputs = packGateInput(1, states_[instruction.inputs[0]]) | packGateInput(2, states_[instruction.inputs[1]]) | packGateInput(3, states_[instruction.inputs[2]]);
+        return lookupGate(instruction.op, inputs, extraLogicStates_);
+    }
+    unsigned int numLow = 0, numHigh = 0, numMiddle = 0;
+    for (uint32_t i = instruction.inputs[0]; i < instruction.inputs[0] + instruction.inputs[1]; ++i) {
+        const State::t state = states_[drivers_[i]];
+        numLow += (state == State::low);
+        numHigh += (state == State::high);
+        numMiddle += (state == State::middle);
+    }
+    if (instruction.op == TileId::outLed) {
+        return (numHigh > 0 ? State::high : State::low);
+    }
+    bool conflict;
+    return resolveNet(numLow, numHigh, numMiddle, extraLogicStates_, conflict);
+}
+
+bool CompiledNetlist::runFeedbackLoop(const FeedbackLoop& loop, unsigned int maxTicks) {
+    const Instruction* begin = feedbackInstructions_.data() + loop.instructionOffset;
+    const Instruction* end = begin + loop.instructionCount;
+    const Instruction* groupsBegin = std::find_if(begin, end, [](const Instruction& instruction) {
+        return !isGate(instruction.op);
+    });
+
+    // The nets catch up with any changes from outside the loop first, then each tick runs like in the `Simulator`
+    // (the gates all read the states from the last tick).
+    for (const Instruction* instruction = groupsBegin; instruction != end; ++instruction) {
+        states_[instruction->output] = evaluate(*instruction);
+    }
+    for (unsigned int tick = 0; tick < maxTicks; ++tick) {
+        nextGateStates_.clear();
+        for (const Instruction* instruction = begin; instruction != groupsBegin; ++instruction) {
+            nextGateStates_.push_back(evaluate(*instruction));
+        }
+        bool changed = false;
+        for (const Instruction* instruction = begin; instruction != groupsBegin; ++instruction) {
+            const State::t nextState = nextGateStates_[instruction - begin];
+            changed = changed || (states_[instruction->output] != nextState);
+            states_[instruction->output] = nextState;
+        }
+        if (!changed) {
+            return true;
+        }
+        for (const Instruction* instruction = groupsBegin; instruction != end; ++instruction) {
+            states_[instruction->output] = evaluate(*instruction);
+        }
+    }
+    return false;
+}
+
+void CompiledNetlist::findComponents(std::vector<uint32_t>& componentSignals, std::vector<uint32_t>& componentOffsets) const {
+    // Tarjan's algorithm without recursion (a long chain of logic would run out of stack). Each component gets
+    // finished after everything it depends on, so the components come out in the order to evaluate them.
+    const uint32_t numSignals = static_cast<uint32_t>(dependencyOffsets_.size() - 1);
+    std::vector<uint32_t> indices(numSignals, UNVISITED), lowLinks(numSignals, 0);
+    std::vector<bool> onStack(numSignals, false);
+    std::vector<uint32_t> stack;
+    // The signal being visited and the next dependency to check for it.
+    std::vector<std::pair<uint32_t, uint32_t>> callStack;
+    uint32_t nextIndex = 0;
+    componentSignals.clear();
+    componentOffsets.assign(1, 0);
+
+    for (uint32_t root = 0; root < numSignals; ++root) {
+        if (indices[root] != UNVISITED) {
+            continue;
+        }
+        callStack.emplace_back(root, dependencyOffsets_[root]);
+        indices[root] = lowLinks[root] = nextIndex++;
+        stack.push_back(root);
+        onStack[root] = true;
+        while (!callStack.empty()) {
+            const uint32_t signal = callStack.back().first;
+            uint32_t& next = callStack.back().second;
+            if (next < dependencyOffsets_[signal + 1]) {
+                const uint32_t dependency = dependencies_[next++];
+                if (indices[dependency] == UNVISITED) {
+                    callStack.emplace_back(dependency, dependencyOffsets_[dependency]);
+                    indices[dependency] = lowLinks[dependency] = nextIndex++;
+                    stack.push_back(dependency);
+                    onStack[dependency] = true;
+                } else if (onStack[dependency]) {
+                    lowLinks[signal] = std::min(lowLinks[signal], indices[dependency]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                const uint32_t caller = callStack.back().first;
+                lowLinks[caller] = std::min(lowLinks[caller], lowLinks[signal]);
+            }
+            if (lowLinks[signal] == indices[signal]) {
+                uint32_t member;
+                do {
+                    member = stack.back();
+                    stack.pop_back();
+                    onStack[member] = false;
+                    componentSignals.push_back(member);
+                } while (member != signal);
+                componentOffsets.push_back(static_cast<uint32_t>(componentSignals.size()));
+            }
+        }
+    }
+}
+
+} // namespace sim
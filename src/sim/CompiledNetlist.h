@@ -0,0 +1,123 @@
+#pragma once
+
+#include <sim/CircuitGraph.h>
+#include <Tile.h>
+
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+class Board;
+
+namespace sim {
+
+/**
+ * Compiled mode that finds the state a circuit settles at with the inputs held,
+ * without running it one tick at a time.
+ *
+ * The circuit from `CircuitGraph` is split into its strongly connected parts.
+ * Gates and nets outside of a feedback loop get levelized (each one comes
+ * after everything it reads from) and turned into a flat list of instructions
+ * over a contiguous array of signal states. One pass over the instructions
+ * then gives the final state of that logic, the same as the `Simulator` would
+ * reach after as many ticks as the logic is deep. Gates use the truth table
+ * from `lookupGate()`.
+ *
+ * A feedback loop (like a latch) has no single order to evaluate in, so each
+ * loop becomes one instruction that runs its gates and nets tick by tick, the
+ * same way as the `Simulator`, until they stop changing. This keeps the state
+ * a latch holds on to.
+ *
+ * Compiling also simplifies the logic. Gates that can only output one state
+ * (like a gate reading an undriven wire) become constants, and gates or nets
+ * that just pass along a single input (like a chain of diodes) become aliases
+ * of that input. Optionally, the inputs can be treated as constants too, and
+ * any logic that no LED or observed tile depends on gets removed.
+ *
+ * Like the `BatchSimulator`, inputs keep whatever state they are given and the
+ * netlist needs a `build()` after any edit to the board.
+ */
+class CompiledNetlist {
+public:
+    CompiledNetlist(Board& board);
+    CompiledNetlist(const CompiledNetlist& rhs) = delete;
+    CompiledNetlist& operator=(const CompiledNetlist& rhs) = delete;
+
+    // Extracts and compiles the circuit from the loaded chunks, the signals start with the current state of the tiles.
+    void build();
+    // Folds the inputs into the logic with their current state, they can't be changed until the next build.
+    void setConstantInputs(bool constantInputs);
+    bool getConstantInputs() const;
+    // Removes logic that the LEDs and observed tiles don't depend on, it keeps the state from the build.
+    void setRemoveDeadLogic(bool removeDeadLogic);
+    bool getRemoveDeadLogic() const;
+    void addObservedTile(const sf::Vector2i& pos, int channel = 0);
+    void clearObservedTiles();
+    bool getExtraLogicStates() const;
+    size_t getSignalCount() const;
+    size_t getInstructionCount() const;
+    // Number of levels in the compiled logic, a level only reads from the levels before it.
+    unsigned int getLevelCount() const;
+    // Number of gates that are part of a feedback loop.
+    size_t getFeedbackGateCount() const;
+    // Number of signals folded into constants and aliases, and instructions removed as dead logic.
+    size_t getConstantCount() const;
+    size_t getAliasCount() const;
+    size_t getDeadCount() const;
+    // Gets the state of the signal at a tile (the channel selects the path through a crossover), disconnected if none.
+    State::t getState(const sf::Vector2i& pos, int channel = 0) const;
+    // Sets the state of an input. Any other signal gets overwritten the next run.
+    void setState(const sf::Vector2i& pos, State::t state);
+    // Runs the instructions once to settle the circuit. Returns false if a feedback loop is still changing after
+    // `maxFeedbackTicks` (the loop then keeps the state from the last tick).
+    bool run(unsigned int maxFeedbackTicks);
+    // Copies the signal states back to the tiles. The `Simulator` needs a `reset()` after this to pick up the changes.
+    void writeStates();
+
+private:
+    // Gates use the gate id for the op and read from `inputs` (right, back, left side). Nets use `wireStraight` and
+    // LED groups use `outLed`, then `inputs` has the offset and count of the drivers. A feedback loop uses `blank`
+    // and the first input is the index of the loop.
+    struct Instruction {
+        TileId::t op;
+        uint32_t inputs[3];
+        uint32_t output;
+    };
+
+    struct FeedbackLoop {
+        uint32_t instructionOffset, instructionCount;
+    };
+
+    template<typename Func>
+    void forEachInput(Instruction& instruction, Func func);
+    // Updates the inputs for any aliases, then tries to fold the instruction. Returns false if it's no longer needed.
+    bool foldInstruction(Instruction& instruction);
+    void removeDeadInstructions(std::vector<Instruction>& signalInstructions, const std::vector<uint32_t>& signalLoops, std::vector<std::pair<unsigned int, Instruction>>& levelInstructions);
+    State::t evaluate(const Instruction& instruction) const;
+    bool runFeedbackLoop(const FeedbackLoop& loop, unsigned int maxTicks);
+    // Finds the strongly connected components of the signals, the signals of component `i` are from
+    // `componentOffsets[i]` to `componentOffsets[i + 1]`.
+    void findComponents(std::vector<uint32_t>& componentSignals, std::vector<uint32_t>& componentOffsets) const;
+
+    Board& board_;
+    CircuitGraph graph_;
+    bool extraLogicStates_;
+    // One state for each signal, followed by a disconnected state that unused gate inputs read from.
+    std::vector<State::t> states_;
+    std::vector<Instruction> instructions_, feedbackInstructions_;
+    std::vector<FeedbackLoop> feedbackLoops_;
+    std::vector<uint32_t> drivers_;
+    // The signals that each signal reads from, these are at `dependencyOffsets_[i]` up to `dependencyOffsets_[i + 1]`.
+    std::vector<uint32_t> dependencyOffsets_, dependencies_;
+    std::vector<State::t> nextGateStates_;
+    // The signal that each signal reads its state from, this is itself unless the signal was folded into an alias.
+    std::vector<uint32_t> aliases_;
+    std::vector<bool> constants_;
+    bool constantInputs_, removeDeadLogic_;
+    std::vector<std::pair<sf::Vector2i, int>> observedTiles_;
+    unsigned int levelCount_;
+    size_t feedbackGateCount_, constantCount_, aliasCount_, deadCount_;
+};
+
+} // namespace sim
@@ -0,0 +1,76 @@
+#include <sim/InputLog.h>
+
+#include <cassert>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+namespace sim {
+
+constexpr int InputLog::VERSION;
+
+InputLog::InputLog() :
+    events_() {
+}
+
+size_t InputLog::size() const {
+    return events_.size();
+}
+
+bool InputLog::empty() const {
+    return events_.empty();
+}
+
+void InputLog::clear() {
+    events_.clear();
+}
+
+void InputLog::add(uint64_t tick, char keycode) {
+    assert(events_.empty() || events_.back().tick <= tick);
+    events_.push_back({tick, keycode});
+}
+
+void InputLog::truncate(uint64_t tick) {
+    while (!events_.empty() && events_.back().tick >= tick) {
+        events_.pop_back();
+    }
+}
+
+const std::vector<InputLog::Event>& InputLog::getEvents() const {
+    return events_;
+}
+
+bool InputLog::save(std::ostream& out) const {
+    out << "version: " << VERSION << "\n";
+    for (const auto& event : events_) {
+        out << event.tick << " " << static_cast<int>(static_cast<unsigned char>(event.keycode)) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool InputLog::load(std::istream& in) {
+    events_.clear();
+    std::string line;
+    if (!std::getline(in, line) || line.compare(0, 9, "version: ") != 0 || std::atoi(line.c_str() + 9) != VERSION) {
+        return false;
+    }
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream lineStream(line);
+        uint64_t tick;
+        int keycode;
+        if (!(lineStream >> tick >> keycode) || keycode < 0 || keycode > 255 || (!events_.empty() && tick < events_.back().tick)) {
+            events_.clear();
+            return false;
+        }
+        events_.push_back({tick, static_cast<char>(keycode)});
+    }
+    return true;
+}
+
+} // namespace sim
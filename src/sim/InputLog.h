@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace sim {
+
+/**
+ * A recording of the keys pressed during a simulation run, so the run can be
+ * replayed the same way later (see `Simulator::setInputMode()`).
+ *
+ * A key press toggles the switches and presses the buttons with that keycode.
+ * Each press is stored with the number of ticks since the recording started,
+ * so replaying from the same board state gives the same result every time.
+ *
+ * The text format has a version line, followed by one line per press with
+ * the tick and the keycode as a number:
+ *
+ *   version: 1
+ *   120 114
+ *   250 48
+ */
+class InputLog {
+public:
+    static constexpr int VERSION = 1;
+
+    struct Event {
+        uint64_t tick;
+        char keycode;
+    };
+
+    InputLog();
+
+    size_t size() const;
+    bool empty() const;
+    void clear();
+    // Presses need to be added in tick order.
+    void add(uint64_t tick, char keycode);
+    // Drops the presses at or after `tick`.
+    void truncate(uint64_t tick);
+    const std::vector<Event>& getEvents() const;
+    bool save(std::ostream& out) const;
+    // Replaces the events with the ones read from `in`. Returns false (and leaves the log empty) if the format is
+    // invalid.
+    bool load(std::istream& in);
+
+private:
+    std::vector<Event> events_;
+};
+
+} // namespace sim
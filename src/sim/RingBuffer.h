@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Lock-free queue of values from one producer thread to one consumer thread,
+ * with a fixed capacity.
+ *
+ * The producer only writes the tail index and the consumer only writes the
+ * head index, so each side just needs to see the other's index to know which
+ * slots it can use. Neither side ever waits: `push()` fails when the buffer is
+ * full and `pop()` fails when it's empty.
+ */
+template<typename T>
+class RingBuffer {
+public:
+    // The capacity gets rounded up to a power of two.
+    RingBuffer(size_t capacity) :
+        values_(roundCapacity(capacity)),
+        mask_(values_.size() - 1),
+        head_(0),
+        tail_(0) {
+    }
+    RingBuffer(const RingBuffer& rhs) = delete;
+    RingBuffer& operator=(const RingBuffer& rhs) = delete;
+
+    size_t capacity() const {
+        return values_.size();
+    }
+    // Drops the values and changes the capacity (rounded up the same way), only while neither side is using the
+    // buffer.
+    void reset(size_t capacity) {
+        values_.assign(roundCapacity(capacity), T());
+        mask_ = values_.size() - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+
+    // Producer side. Returns false (and drops the value) if the buffer is full, or if it would leave fewer than
+    // `reserve` free slots for other values.
+    bool push(const T& value, size_t reserve = 0) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) + reserve >= values_.size()) {
+            return false;
+        }
+        values_[tail & mask_] = value;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the buffer is empty.
+    bool pop(T& value) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = values_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Number of values waiting, only exact when called from one of the two sides while the other is idle.
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+private:
+    static size_t roundCapacity(size_t capacity) {
+        assert(capacity > 0);
+        size_t rounded = 1;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+    std::vector<T> values_;
+    size_t mask_;
+    // Kept on separate cache lines, since each one is written by a different thread.
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
+
+} // namespace sim
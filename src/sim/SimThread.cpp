@@ -0,0 +1,309 @@
+#include <Board.h>
+#include <sim/SimThread.h>
+#include <Simulator.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace {
+
+constexpr unsigned int CHUNK_AREA = Chunk::WIDTH * Chunk::WIDTH;
+
+// Time between snapshots while ticking, this is a bit faster than most displays refresh.
+constexpr std::chrono::milliseconds PUBLISH_INTERVAL(8);
+
+// Ticks to run at a time during a warp, between checks for a pause.
+constexpr uint64_t WARP_SLICE_TICKS = 64;
+
+}
+
+namespace sim {
+
+constexpr unsigned int SimThread::UNLIMITED_TPS;
+
+SimThread::PauseGuard::PauseGuard(SimThread& simThread) :
+    simThread_(simThread) {
+
+    simThread_.pause();
+}
+
+SimThread::PauseGuard::~PauseGuard() {
+    simThread_.resume();
+}
+
+SimThread::SimThread(Board& board, Simulator& simulator) :
+    board_(board),
+    simulator_(simulator),
+    thread_(),
+    mutex_(),
+    condition_(),
+    pausedCondition_(),
+    threadId_(),
+    maxTps_(0),
+    warpTicksLeft_(0),
+    warpId_(0),
+    pauseCount_(0),
+    threadPaused_(false),
+    stopping_(false),
+    boardTask_(nullptr),
+    unloadPending_(false),
+    tickCount_(0),
+    snapshots_(),
+    resendPending_(false) {
+}
+
+SimThread::~SimThread() {
+    stop();
+}
+
+void SimThread::start() {
+    if (thread_.joinable()) {
+        return;
+    }
+    simulator_.setDetachedDrawing(true);
+    simulator_.setBoardTaskRunner([this](const std::function<void()>& task) {
+        runBoardTask(task);
+    });
+    board_.setSimThread(this);
+    snapshots_.reset();
+    resendPending_ = false;
+    threadPaused_ = false;
+    stopping_ = false;
+    warpTicksLeft_ = 0;
+    unloadPending_.store(false, std::memory_order_relaxed);
+    tickCount_.store(simulator_.getTickCount(), std::memory_order_relaxed);
+    thread_ = std::thread(&SimThread::threadLoop, this);
+}
+
+void SimThread::stop() {
+    if (!thread_.joinable()) {
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stopping_ = true;
+        condition_.notify_all();
+        // The thread may need a chunk loaded before it can finish the tick.
+        while (!threadPaused_) {
+            pausedCondition_.wait(lock, [this]() { return threadPaused_ || boardTask_ != nullptr; });
+            finishBoardTask(lock);
+        }
+    }
+    thread_.join();
+    board_.setSimThread(nullptr);
+    simulator_.setBoardTaskRunner(nullptr);
+    simulator_.setDetachedDrawing(false);
+}
+
+bool SimThread::isRunning() const {
+    return thread_.joinable();
+}
+
+void SimThread::setMaxTps(unsigned int maxTps) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        maxTps_ = maxTps;
+    }
+    condition_.notify_all();
+}
+
+unsigned int SimThread::getMaxTps() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return maxTps_;
+}
+
+void SimThread::warp(uint64_t numTicks) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        warpTicksLeft_ = numTicks;
+        ++warpId_;
+    }
+    condition_.notify_all();
+}
+
+uint64_t SimThread::getWarpTicksLeft() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return warpTicksLeft_;
+}
+
+uint64_t SimThread::getTickCount() const {
+    return tickCount_.load(std::memory_order_relaxed);
+}
+
+void SimThread::pause() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++pauseCount_;
+    if (pauseCount_ > 1 || !thread_.joinable()) {
+        return;
+    }
+    condition_.notify_all();
+    while (!threadPaused_) {
+        pausedCondition_.wait(lock, [this]() { return threadPaused_ || boardTask_ != nullptr; });
+        finishBoardTask(lock);
+    }
+
+    // The thread waits until resumed, so the drawing can catch up with the board. Any snapshot still waiting is
+    // dropped since the edits made during the pause would get drawn over with older tiles.
+    simulator_.flushDrawDirty();
+    snapshots_.reset();
+    resendPending_ = false;
+}
+
+void SimThread::resume() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        assert(pauseCount_ > 0);
+        if (pauseCount_ == 1) {
+            // Pick up any edits (or ticks run from this thread) made during the pause.
+            if (thread_.joinable()) {
+                simulator_.flushDrawDirty();
+                board_.refreshStateSnapshots();
+            }
+            tickCount_.store(simulator_.getTickCount(), std::memory_order_relaxed);
+        }
+        --pauseCount_;
+    }
+    condition_.notify_all();
+}
+
+bool SimThread::consumeSnapshot() {
+    return snapshots_.consume();
+}
+
+const StateSnapshot& SimThread::getSnapshot() const {
+    return snapshots_.accessFront();
+}
+
+void SimThread::updateChunks() {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finishBoardTask(lock);
+    }
+    if (unloadPending_.exchange(false)) {
+        // The pause catches up the drawing first, a chunk that still has changes to draw can't unload.
+        PauseGuard pauseGuard(*this);
+        simulator_.unloadSleepingChunks();
+    }
+}
+
+void SimThread::threadLoop() {
+    using Clock = std::chrono::steady_clock;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    threadId_ = std::this_thread::get_id();
+    Clock::time_point nextTick = Clock::now(), nextPublish = nextTick;
+    while (!stopping_) {
+        if (pauseCount_ > 0) {
+            threadPaused_ = true;
+            pausedCondition_.notify_all();
+            condition_.wait(lock, [this]() { return pauseCount_ == 0 || stopping_; });
+            threadPaused_ = false;
+            nextTick = Clock::now();
+            continue;
+        }
+
+        const unsigned int maxTps = maxTps_;
+        const uint64_t warpTicks = std::min(warpTicksLeft_, WARP_SLICE_TICKS);
+        const uint64_t warpId = warpId_;
+        if (warpTicks == 0 && (maxTps == 0 || !simulator_.hasPendingUpdates())) {
+            // Nothing to run, send out the last changes and wait. The pending updates only change during a pause
+            // (or a new warp), and both of those wake us up.
+            publishSnapshot();
+            if (resendPending_) {
+                condition_.wait_for(lock, PUBLISH_INTERVAL);
+            } else {
+                condition_.wait(lock);
+            }
+            nextTick = Clock::now();
+            continue;
+        }
+
+        lock.unlock();
+        if (warpTicks != 0) {
+            simulator_.warp(warpTicks);
+        } else {
+            simulator_.tick();
+        }
+        tickCount_.store(simulator_.getTickCount(), std::memory_order_relaxed);
+        if (simulator_.hasChunksToUnload()) {
+            unloadPending_.store(true, std::memory_order_relaxed);
+        }
+        const Clock::time_point now = Clock::now();
+        if (now >= nextPublish) {
+            publishSnapshot();
+            nextPublish = now + PUBLISH_INTERVAL;
+        }
+        lock.lock();
+
+        if (warpTicks != 0) {
+            if (warpId_ == warpId) {
+                warpTicksLeft_ -= warpTicks;
+            }
+            nextTick = now;
+        } else if (maxTps != UNLIMITED_TPS) {
+            // Ticks that fall behind are skipped instead of run in a burst to catch up.
+            nextTick = std::max(nextTick + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / maxTps)), now);
+            condition_.wait_until(lock, nextTick, [this,maxTps]() {
+                return pauseCount_ > 0 || stopping_ || maxTps_ != maxTps;
+            });
+        }
+    }
+    threadId_ = std::thread::id();
+    threadPaused_ = true;
+    pausedCondition_.notify_all();
+}
+
+void SimThread::runBoardTask(const std::function<void()>& task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (std::this_thread::get_id() != threadId_) {
+        // Anywhere else the thread is paused (or not running), so the board can be changed right away. The workers
+        // of the simulator also run on other threads during a tick, but they never get here (the simulator asserts
+        // that they don't load chunks).
+        lock.unlock();
+        task();
+        return;
+    }
+    boardTask_ = &task;
+    pausedCondition_.notify_all();
+    condition_.wait(lock, [this]() { return boardTask_ == nullptr; });
+}
+
+void SimThread::finishBoardTask(std::unique_lock<std::mutex>& lock) {
+    if (boardTask_ == nullptr) {
+        return;
+    }
+    // The thread is blocked until the task is cleared, so the task can run without holding the lock.
+    const std::function<void()>* task = boardTask_;
+    lock.unlock();
+    (*task)();
+    lock.lock();
+    boardTask_ = nullptr;
+    condition_.notify_all();
+}
+
+void SimThread::publishSnapshot() {
+    StateSnapshot& snapshot = snapshots_.accessBack();
+    snapshot.chunkCoords.clear();
+    snapshot.tiles.clear();
+    simulator_.visitChangedChunks([&snapshot](ChunkCoords::repr coords, const TileData* tiles) {
+        snapshot.chunkCoords.push_back(coords);
+        snapshot.tiles.insert(snapshot.tiles.end(), tiles, tiles + CHUNK_AREA);
+    });
+    if (snapshot.chunkCoords.empty()) {
+        resendPending_ = false;
+        return;
+    }
+    snapshot.tickCount = simulator_.getTickCount();
+
+    resendPending_ = snapshots_.publish();
+    if (resendPending_) {
+        // The renderer never saw the previous snapshot (now in the back buffer). The newer one may not have all of
+        // the same chunks, so they get copied again from the board for the next snapshot.
+        for (auto coords : snapshots_.accessBack().chunkCoords) {
+            simulator_.markChunkChanged(coords);
+        }
+    }
+}
+
+} // namespace sim
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <Chunk.h>
+#include <ChunkCoords.h>
+#include <sim/TripleBuffer.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Board;
+class Simulator;
+
+namespace sim {
+
+// The tiles of the chunks that changed since the last snapshot the renderer picked up.
+struct StateSnapshot {
+    uint64_t tickCount;
+    std::vector<ChunkCoords::repr> chunkCoords;
+    // `Chunk::WIDTH * Chunk::WIDTH` tiles for each entry in `chunkCoords`, in the same order.
+    std::vector<TileData> tiles;
+};
+
+/**
+ * Runs a `Simulator` on a dedicated thread, so that a slow tick never holds up
+ * drawing (and drawing never limits the tick rate).
+ *
+ * While the thread runs, the simulator uses detached drawing and the board
+ * draws from a copy of the tiles. Every few milliseconds the thread copies the
+ * chunks that changed into a `StateSnapshot` and publishes it through a
+ * `TripleBuffer`, then `Board::updateRender()` takes the newest one without
+ * blocking. A snapshot is only ever taken between ticks, so the frame always
+ * shows the board as it was after a whole tick.
+ *
+ * Anything else that touches the board or the simulator (edits, file i/o,
+ * stepping manually) must happen while the thread is paused. Pausing waits for
+ * the current tick to finish, catches up the drawing with the board, and drops
+ * any snapshot that was not picked up yet (it would be older than the edits).
+ *
+ * A warp runs a fixed number of ticks on the thread as fast as it can, on top
+ * of the normal ticking. It goes in slices of ticks, so a pause (or another
+ * frame) never waits on the whole warp.
+ *
+ * Chunks can still load and unload while the thread runs, but the board is
+ * only changed from the thread that owns it. The unloaded chunks a tick needs
+ * are gathered up front and the thread waits for `updateChunks()` (or a pause)
+ * to load them all at once, so a tick costs at most one frame of waiting. The
+ * chunks that went to sleep are unloaded in `updateChunks()` too, with the
+ * thread paused.
+ */
+class SimThread {
+public:
+    // Max TPS value to run ticks as fast as possible.
+    static constexpr unsigned int UNLIMITED_TPS = std::numeric_limits<unsigned int>::max();
+
+    // Pauses the thread for the lifetime of the guard.
+    class PauseGuard {
+    public:
+        PauseGuard(SimThread& simThread);
+        ~PauseGuard();
+        PauseGuard(const PauseGuard& rhs) = delete;
+        PauseGuard& operator=(const PauseGuard& rhs) = delete;
+
+    private:
+        SimThread& simThread_;
+    };
+
+    SimThread(Board& board, Simulator& simulator);
+    ~SimThread();
+    SimThread(const SimThread& rhs) = delete;
+    SimThread& operator=(const SimThread& rhs) = delete;
+
+    void start();
+    // Waits for the current tick to finish and stops the thread, the board goes back to drawing from the chunks.
+    void stop();
+    bool isRunning() const;
+    // A max TPS of zero stops ticking (the thread still runs and can be paused as usual).
+    void setMaxTps(unsigned int maxTps);
+    unsigned int getMaxTps() const;
+    // Runs the ticks as fast as possible, even with a max TPS of zero. This replaces the ticks left from an earlier
+    // warp, so a warp of zero ticks cancels it.
+    void warp(uint64_t numTicks);
+    uint64_t getWarpTicksLeft() const;
+    // The tick count as of the last tick finished (or the last resume), safe to call at any time.
+    uint64_t getTickCount() const;
+    // Blocks until the thread is between ticks. Calls can be nested, each needs a matching `resume()`.
+    void pause();
+    void resume();
+    // Moves the newest published snapshot to the front, returns false if there is nothing new.
+    bool consumeSnapshot();
+    const StateSnapshot& getSnapshot() const;
+    // Loads the chunks the thread is waiting on and unloads the sleeping ones, this should be called every frame.
+    void updateChunks();
+
+private:
+    void threadLoop();
+    void publishSnapshot();
+    // Runs a task that changes the board. From the thread, this waits until the task has run on the thread that
+    // owns the board.
+    void runBoardTask(const std::function<void()>& task);
+    // Runs the task the thread is waiting on (if any), `lock` must be holding `mutex_`.
+    void finishBoardTask(std::unique_lock<std::mutex>& lock);
+
+    Board& board_;
+    Simulator& simulator_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    // Wakes the thread for a resume, a change in speed, to stop, or when its board task is done. The thread responds
+    // on `pausedCondition_`.
+    std::condition_variable condition_, pausedCondition_;
+    std::thread::id threadId_;
+    unsigned int maxTps_;
+    uint64_t warpTicksLeft_;
+    // Counts the calls to `warp()`, so a slice that finishes after a new warp doesn't count against it.
+    uint64_t warpId_;
+    unsigned int pauseCount_;
+    // Also set once the thread exits.
+    bool threadPaused_;
+    bool stopping_;
+    // The task the thread is waiting on, if any.
+    const std::function<void()>* boardTask_;
+    // Set by the thread when chunks went to sleep and can be unloaded.
+    std::atomic<bool> unloadPending_;
+    std::atomic<uint64_t> tickCount_;
+    TripleBuffer<StateSnapshot> snapshots_;
+    // Set when a snapshot was replaced before the renderer took it, its chunks need to be sent again.
+    bool resendPending_;
+};
+
+} // namespace sim
@@ -0,0 +1,109 @@
+#include <sim/TileLogic.h>
+
+namespace sim {
+
+namespace {
+
+// The gate rules below are all constexpr so the table gets built by the compiler. These only work on the packed
+// inputs from `packGateInputs()`.
+
+constexpr State::t inputState(unsigned int inputs, unsigned int sideOffset) {
+    return static_cast<State::t>((inputs >> ((sideOffset - 1) * 2)) & 0x3);
+}
+
+constexpr unsigned int countState(unsigned int inputs, State::t state) {
+    return (inputState(inputs, 1) == state ? 1 : 0) + (inputState(inputs, 2) == state ? 1 : 0) + (inputState(inputs, 3) == state ? 1 : 0);
+}
+
+constexpr unsigned int countInputs(unsigned int inputs) {
+    return 3 - countState(inputs, State::disconnected);
+}
+
+// The middle state only counts as its own state with extra logic states, otherwise it's just not high.
+constexpr unsigned int countMiddle(unsigned int inputs, bool extraLogicStates) {
+    return (extraLogicStates ? countState(inputs, State::middle) : 0);
+}
+
+constexpr State::t findNextStateDiode(unsigned int inputs, bool extraLogicStates) {
+    return (countInputs(inputs) != 1 ? State::low :
+        countState(inputs, State::high) == 1 ? State::high :
+        countMiddle(inputs, extraLogicStates) == 1 ? State::middle :
+        State::low);
+}
+
+// The tri-state buffer takes the input from the back and the control from the right side (or the left side if the
+// right is disconnected).
+constexpr State::t findNextStateTristate(unsigned int inputs) {
+    return (inputState(inputs, 2) == State::disconnected ? State::low :
+        (inputState(inputs, 1) != State::disconnected ? inputState(inputs, 1) : inputState(inputs, 3)) == State::high ? inputState(inputs, 2) :
+        State::middle);
+}
+
+constexpr State::t findNextStateBuffer(unsigned int inputs, bool extraLogicStates) {
+    return (countInputs(inputs) == 2 && extraLogicStates ? findNextStateTristate(inputs) : findNextStateDiode(inputs, extraLogicStates));
+}
+
+constexpr State::t findNextStateAnd(unsigned int inputs, bool extraLogicStates) {
+    return (countInputs(inputs) < 2 ? State::low :
+        countState(inputs, State::high) == countInputs(inputs) ? State::high :
+        countState(inputs, State::high) + countMiddle(inputs, extraLogicStates) == countInputs(inputs) ? State::middle :
+        State::low);
+}
+
+constexpr State::t findNextStateOr(unsigned int inputs, bool extraLogicStates) {
+    return (countInputs(inputs) < 2 ? State::low :
+        countState(inputs, State::high) >= 1 ? State::high :
+        countMiddle(inputs, extraLogicStates) >= 1 ? State::middle :
+        State::low);
+}
+
+constexpr State::t findNextStateXor(unsigned int inputs, bool extraLogicStates) {
+    return (countInputs(inputs) < 2 ? State::low :
+        countMiddle(inputs, extraLogicStates) != 0 ? State::middle :
+        countState(inputs, State::high) % 2 == 1 ? State::high :
+        State::low);
+}
+
+constexpr State::t findNextState(TileId::t id, unsigned int inputs, bool extraLogicStates) {
+    return (id == TileId::gateDiode ? findNextStateDiode(inputs, extraLogicStates) :
+        id == TileId::gateBuffer ? findNextStateBuffer(inputs, extraLogicStates) :
+        id == TileId::gateNot ? complementState(findNextStateBuffer(inputs, extraLogicStates)) :
+        id == TileId::gateAnd ? findNextStateAnd(inputs, extraLogicStates) :
+        id == TileId::gateNand ? complementState(findNextStateAnd(inputs, extraLogicStates)) :
+        id == TileId::gateOr ? findNextStateOr(inputs, extraLogicStates) :
+        id == TileId::gateNor ? complementState(findNextStateOr(inputs, extraLogicStates)) :
+        id == TileId::gateXor ? findNextStateXor(inputs, extraLogicStates) :
+        complementState(findNextStateXor(inputs, extraLogicStates)));
+}
+
+// A list of indices to expand the table with (C++11 doesn't have `std::integer_sequence`).
+template<unsigned int... Indices>
+struct IndexList {};
+
+template<unsigned int N, unsigned int... Indices>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, Indices...> {};
+
+template<unsigned int... Indices>
+struct MakeIndexList<0, Indices...> {
+    using type = IndexList<Indices...>;
+};
+
+template<unsigned int... Inputs>
+constexpr GateTableRow makeGateTableRow(unsigned int row, IndexList<Inputs...>) {
+    return {{findNextState(static_cast<TileId::t>(TileId::gateDiode + row / 2), Inputs, row % 2 == 1)...}};
+}
+
+template<unsigned int... Rows>
+constexpr GateTable makeGateTable(IndexList<Rows...>) {
+    return {{makeGateTableRow(Rows, MakeIndexList<NUM_GATE_INPUTS>::type())...}};
+}
+
+}
+
+constexpr GateTable GATE_TABLE = makeGateTable(MakeIndexList<NUM_GATE_TYPES * 2>::type());
+
+static_assert(GATE_TABLE.rows[(TileId::gateAnd - TileId::gateDiode) * 2].states[packGateInput(1, State::high) | packGateInput(3, State::high)] == State::high, "And gate with both sides high should be high.");
+static_assert(GATE_TABLE.rows[(TileId::gateNor - TileId::gateDiode) * 2].states[0] == State::high, "Nor gate without inputs should be high.");
+static_assert(GATE_TABLE.rows[(TileId::gateBuffer - TileId::gateDiode) * 2 + 1].states[packGateInput(1, State::low) | packGateInput(2, State::high)] == State::middle, "Tri-state buffer with a low control should be middle.");
+
+} // namespace sim
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <Chunk.h>
+#include <Tile.h>
+
+#include <cstdint>
+
+/**
+ * Stateless helpers that describe how tiles connect to each other and how they
+ * behave during simulation. These work directly on the packed `TileData` so
+ * that the simulator never needs to go through the `TileType` interface in the
+ * hot loop.
+ *
+ * Sides are stored as a bitmask with one bit per `Direction::t` (north is the
+ * least significant bit). Wires have either one or two channels, only the
+ * crossover wire uses the second channel (east-west path, stored in
+ * `TileData::state2`).
+ */
+namespace sim {
+
+constexpr uint8_t ALL_SIDES = 0xf;
+// Offset to the adjacent tile in each `Direction::t`.
+constexpr int DIRECTION_X[4] = {0, 1, 0, -1};
+constexpr int DIRECTION_Y[4] = {-1, 0, 1, 0};
+
+inline Direction::t opposite(Direction::t dir) {
+    return static_cast<Direction::t>((dir + 2) % 4);
+}
+
+inline bool isWire(TileId::t id) {
+    return id >= TileId::wireStraight && id <= TileId::wireCrossover;
+}
+
+inline bool isInput(TileId::t id) {
+    return id == TileId::inSwitch || id == TileId::inButton;
+}
+
+inline bool isGate(TileId::t id) {
+    return id >= TileId::gateDiode && id <= TileId::gateXnor;
+}
+
+// Rotates a side mask clockwise by the given direction.
+inline uint8_t rotateSides(uint8_t sides, Direction::t dir) {
+    return static_cast<uint8_t>(((sides << dir) | (sides >> (4 - dir))) & ALL_SIDES);
+}
+
+// Gets the sides that a wire tile connects to (for all channels).
+inline uint8_t wireSides(TileData tile) {
+    switch (tile.id) {
+    case TileId::wireStraight:
+        return rotateSides(0x5, static_cast<Direction::t>(tile.dir % 2));
+    case TileId::wireCorner:
+        return rotateSides(0x3, tile.dir);
+    case TileId::wireTee:
+        return rotateSides(0x7, tile.dir);
+    case TileId::wireJunction:
+    case TileId::wireCrossover:
+        return ALL_SIDES;
+    default:
+        return 0;
+    }
+}
+
+// Gets the wire channel that connects to the given side. Assumes the tile is a
+// wire and it connects to the side.
+inline int wireChannel(TileData tile, Direction::t side) {
+    return (tile.id == TileId::wireCrossover ? side % 2 : 0);
+}
+
+// Gets the sides that a single channel of a wire connects to.
+inline uint8_t channelSides(TileData tile, int channel) {
+    if (tile.id == TileId::wireCrossover) {
+        return (channel == 0 ? 0x5 : 0xa);
+    }
+    return wireSides(tile);
+}
+
+inline State::t channelState(TileData tile, int channel) {
+    return (channel == 0 ? tile.state1 : tile.state2);
+}
+
+/**
+ * Finds the state that a tile outputs towards an adjacent tile. The
+ * `travelDir` is the direction from the adjacent tile to this one, so the side
+ * of this tile that is checked is the opposite of `travelDir`. Equivalent to
+ * `Tile::checkOutput()` from the legacy simulator.
+ */
+inline State::t outputToward(TileData tile, Direction::t travelDir) {
+    const Direction::t side = opposite(travelDir);
+    if (isWire(tile.id)) {
+        if (wireSides(tile) & (1 << side)) {
+            return channelState(tile, wireChannel(tile, side));
+        }
+    } else if (isInput(tile.id)) {
+        return tile.state1;
+    } else if (isGate(tile.id)) {
+        if (tile.dir == side) {
+            return tile.state1;
+        }
+    }
+    return State::disconnected;
+}
+
+constexpr State::t complementState(State::t state) {
+    return (state == State::low ? State::high : (state == State::high ? State::low : state));
+}
+
+// Gate evaluation uses a truth table built at compile time, see `lookupGate()`.
+constexpr unsigned int NUM_GATE_TYPES = TileId::gateXnor - TileId::gateDiode + 1;
+constexpr unsigned int GATE_INPUT_BITS = 6;
+constexpr unsigned int NUM_GATE_INPUTS = 1u << GATE_INPUT_BITS;
+
+struct GateTableRow {
+    State::t states[NUM_GATE_INPUTS];
+};
+
+// One row for each gate type with and without extra logic states, the row is `(id - gateDiode) * 2 + extraLogicStates`.
+struct GateTable {
+    GateTableRow rows[NUM_GATE_TYPES * 2];
+};
+
+extern const GateTable GATE_TABLE;
+
+/**
+ * Packs the states output towards a gate into a table index. The sides are
+ * taken clockwise starting from the output direction of the gate (right side,
+ * back side, then left side), with two bits per state. The output side is not
+ * an input, so it gets skipped.
+ */
+constexpr unsigned int packGateInput(unsigned int sideOffset, State::t state) {
+    return static_cast<unsigned int>(state) << ((sideOffset - 1) * 2);
+}
+inline unsigned int packGateInputs(Direction::t dir, const State::t adjacent[4]) {
+    unsigned int inputs = 0;
+    for (unsigned int i = 1; i < 4; ++i) {
+        inputs |= packGateInput(i, adjacent[(dir + i) % 4]);
+    }
+    return inputs;
+}
+
+// Gets the next state of a gate from the packed input states. Assumes the tile is a gate.
+inline State::t lookupGate(TileId::t id, unsigned int inputs, bool extraLogicStates) {
+    return GATE_TABLE.rows[(id - TileId::gateDiode) * 2 + extraLogicStates].states[inputs];
+}
+
+/**
+ * Computes the next state of a gate given the states output by each adjacent
+ * tile (indexed by direction). The state from the output side of the gate is
+ * ignored. This matches the gate behavior in the legacy simulator, including
+ * the tri-state buffer when `extraLogicStates` is enabled.
+ */
+inline State::t evaluateGate(TileId::t id, Direction::t dir, const State::t adjacent[4], bool extraLogicStates) {
+    if (!isGate(id)) {
+        return State::disconnected;
+    }
+    return lookupGate(id, packGateInputs(dir, adjacent), extraLogicStates);
+}
+
+/**
+ * Resolves the state of a wire net from the count of drivers outputting each
+ * state. With extra logic states, a conflict between a high and low driver
+ * results in the middle state (and `conflict` is set).
+ */
+inline State::t resolveNet(unsigned int numLow, unsigned int numHigh, unsigned int numMiddle, bool extraLogicStates, bool& conflict) {
+    conflict = false;
+    if (!extraLogicStates) {
+        return (numHigh > 0 ? State::high : State::low);
+    }
+    if (numHigh > 0 && numLow > 0) {
+        conflict = true;
+        return State::middle;
+    } else if (numHigh > 0) {
+        return State::high;
+    } else if (numLow > 0) {
+        return State::low;
+    } else if (numMiddle > 0) {
+        return State::middle;
+    }
+    return State::low;
+}
+
+} // namespace sim
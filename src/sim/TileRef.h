@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace sim {
+
+/**
+ * A reference to a tile within one of the chunks tracked by the `Simulator`.
+ * The slot is an index into the simulator's list of chunks (it's stable until
+ * the simulator is reset), and the index is the position within the chunk.
+ */
+struct TileRef {
+    uint32_t slot;
+    uint16_t index;
+};
+
+inline bool operator==(const TileRef& lhs, const TileRef& rhs) {
+    return lhs.slot == rhs.slot && lhs.index == rhs.index;
+}
+
+inline bool operator!=(const TileRef& lhs, const TileRef& rhs) {
+    return !(lhs == rhs);
+}
+
+} // namespace sim
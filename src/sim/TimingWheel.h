@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Holds values that expire at a future tick, with constant time scheduling and
+ * expiry no matter how many values are waiting.
+ *
+ * The wheel has a few levels of 64 slots. Level 0 has one slot per tick for
+ * the current block of 64 ticks, level 1 has one slot per block of 64 ticks,
+ * and so on. A value goes in the lowest level that can tell its tick apart
+ * from the current tick. Each time the current tick crosses into a new block,
+ * the matching slot from the level above gets moved down (a value moves at
+ * most once per level). Anything past the top level waits in an overflow list
+ * that only gets checked when the top level wraps around.
+ */
+template<typename T>
+class TimingWheel {
+public:
+    static constexpr unsigned int SLOT_BITS = 6;
+    static constexpr unsigned int NUM_SLOTS = 1u << SLOT_BITS;
+    static constexpr unsigned int NUM_LEVELS = 4;
+
+    TimingWheel() :
+        levels_(),
+        overflow_(),
+        cascadeEntries_(),
+        currentTick_(0),
+        size_(0) {
+    }
+
+    // Drops all of the values and moves to a new current tick.
+    void clear(uint64_t currentTick) {
+        for (auto& level : levels_) {
+            for (auto& slot : level) {
+                slot.clear();
+            }
+        }
+        overflow_.clear();
+        currentTick_ = currentTick;
+        size_ = 0;
+    }
+    uint64_t getCurrentTick() const {
+        return currentTick_;
+    }
+    size_t size() const {
+        return size_;
+    }
+    bool empty() const {
+        return size_ == 0;
+    }
+    // Schedules a value to expire at `tick`, a tick before the current one is treated as the current tick.
+    void schedule(uint64_t tick, const T& value) {
+        insert({(tick < currentTick_ ? currentTick_ : tick), value});
+        ++size_;
+    }
+    // Calls `func` with the tick and value of everything waiting, in no particular order.
+    template<typename Func>
+    void forEach(Func func) const {
+        for (const auto& level : levels_) {
+            for (const auto& slot : level) {
+                for (const auto& entry : slot) {
+                    func(entry.tick, entry.value);
+                }
+            }
+        }
+        for (const auto& entry : overflow_) {
+            func(entry.tick, entry.value);
+        }
+    }
+    // Calls `func` with each value that expires at the current tick, then moves to the next tick. Values that
+    // `func` schedules for the current tick expire in the same call.
+    template<typename Func>
+    void advance(Func func) {
+        auto& slot = levels_[0][currentTick_ & (NUM_SLOTS - 1)];
+        for (size_t i = 0; i < slot.size(); ++i) {
+            const T value = slot[i].value;
+            func(value);
+        }
+        size_ -= slot.size();
+        slot.clear();
+        ++currentTick_;
+
+        // Find the highest level that wrapped around, then move slots down starting from there.
+        unsigned int level = 0;
+        while (level + 1 < NUM_LEVELS && (currentTick_ & ((uint64_t(1) << (SLOT_BITS * (level + 1))) - 1)) == 0) {
+            ++level;
+        }
+        if (level + 1 == NUM_LEVELS && (currentTick_ & ((uint64_t(1) << (SLOT_BITS * NUM_LEVELS)) - 1)) == 0) {
+            cascade(overflow_);
+        }
+        for (; level > 0; --level) {
+            cascade(levels_[level][(currentTick_ >> (SLOT_BITS * level)) & (NUM_SLOTS - 1)]);
+        }
+    }
+
+private:
+    struct Entry {
+        uint64_t tick;
+        T value;
+    };
+
+    void insert(const Entry& entry) {
+        const uint64_t differentBits = entry.tick ^ currentTick_;
+        unsigned int level = 0;
+        while (level < NUM_LEVELS && (differentBits >> (SLOT_BITS * (level + 1))) != 0) {
+            ++level;
+        }
+        if (level == NUM_LEVELS) {
+            overflow_.push_back(entry);
+        } else {
+            levels_[level][(entry.tick >> (SLOT_BITS * level)) & (NUM_SLOTS - 1)].push_back(entry);
+        }
+    }
+    void cascade(std::vector<Entry>& slot) {
+        cascadeEntries_.swap(slot);
+        for (const auto& entry : cascadeEntries_) {
+            insert(entry);
+        }
+        cascadeEntries_.clear();
+    }
+
+    std::array<std::array<std::vector<Entry>, NUM_SLOTS>, NUM_LEVELS> levels_;
+    std::vector<Entry> overflow_, cascadeEntries_;
+    uint64_t currentTick_;
+    size_t size_;
+};
+
+template<typename T>
+constexpr unsigned int TimingWheel<T>::SLOT_BITS;
+template<typename T>
+constexpr unsigned int TimingWheel<T>::NUM_SLOTS;
+template<typename T>
+constexpr unsigned int TimingWheel<T>::NUM_LEVELS;
+
+} // namespace sim
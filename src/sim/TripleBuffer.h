@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace sim {
+
+/**
+ * Lock-free handoff of values from one producer thread to one consumer thread.
+ *
+ * There are three buffers: the producer writes into the back buffer, the
+ * consumer reads from the front buffer, and the middle buffer holds the most
+ * recently published value. Publishing and consuming each swap one buffer with
+ * the middle using a single atomic exchange, so neither side ever waits on the
+ * other. If the producer publishes again before the consumer takes the middle,
+ * the older value gets swapped back to the producer without being seen.
+ */
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() :
+        buffers_(),
+        back_(0),
+        middle_(1),
+        front_(2) {
+    }
+    TripleBuffer(const TripleBuffer& rhs) = delete;
+    TripleBuffer& operator=(const TripleBuffer& rhs) = delete;
+
+    // Producer side.
+    T& accessBack() {
+        return buffers_[back_];
+    }
+    // Returns true if the previous value was never consumed, the back buffer then holds that value (instead of
+    // an older one) so the producer can merge it into the next value.
+    bool publish() {
+        const unsigned int previous = middle_.exchange(back_ | FRESH_BIT, std::memory_order_acq_rel);
+        back_ = previous & INDEX_MASK;
+        return (previous & FRESH_BIT) != 0;
+    }
+
+    // Consumer side. Returns true if a new value was moved to the front buffer.
+    bool consume() {
+        if ((middle_.load(std::memory_order_relaxed) & FRESH_BIT) == 0) {
+            return false;
+        }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& accessFront() const {
+        return buffers_[front_];
+    }
+
+    // Drops any value that has not been consumed yet. Only safe while neither side is using the buffer.
+    void reset() {
+        middle_.store(middle_.load(std::memory_order_relaxed) & INDEX_MASK, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr unsigned int INDEX_MASK = 0x3;
+    static constexpr unsigned int FRESH_BIT = 0x4;
+
+    std::array<T, 3> buffers_;
+    unsigned int back_;
+    std::atomic<unsigned int> middle_;
+    unsigned int front_;
+};
+
+template<typename T>
+constexpr unsigned int TripleBuffer<T>::INDEX_MASK;
+template<typename T>
+constexpr unsigned int TripleBuffer<T>::FRESH_BIT;
+
+} // namespace sim
@@ -0,0 +1,171 @@
+#include <sim/WaveformRecorder.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace sim {
+
+constexpr size_t WaveformRecorder::DEFAULT_CAPACITY;
+constexpr uint32_t WaveformRecorder::REWIND_SIGNAL;
+constexpr uint64_t WaveformRecorder::NO_REWIND;
+constexpr size_t WaveformRecorder::REWIND_RESERVE_DIVISOR;
+
+WaveformRecorder::WaveformRecorder(size_t capacity) :
+    signalNames_(),
+    events_(capacity),
+    rewindReserve_(events_.capacity() / REWIND_RESERVE_DIVISOR),
+    droppedCount_(0),
+    pendingRewind_(NO_REWIND),
+    history_() {
+}
+
+void WaveformRecorder::setCapacity(size_t capacity) {
+    events_.reset(capacity);
+    rewindReserve_ = events_.capacity() / REWIND_RESERVE_DIVISOR;
+    pendingRewind_ = NO_REWIND;
+}
+
+size_t WaveformRecorder::getCapacity() const {
+    return events_.capacity();
+}
+
+uint32_t WaveformRecorder::addSignal(const std::string& name) {
+    signalNames_.push_back(name);
+    return static_cast<uint32_t>(signalNames_.size() - 1);
+}
+
+size_t WaveformRecorder::getSignalCount() const {
+    return signalNames_.size();
+}
+
+const std::string& WaveformRecorder::getSignalName(uint32_t signal) const {
+    return signalNames_[signal];
+}
+
+void WaveformRecorder::clear() {
+    Event event;
+    while (events_.pop(event)) {}
+    signalNames_.clear();
+    history_.clear();
+    droppedCount_.store(0, std::memory_order_relaxed);
+    pendingRewind_ = NO_REWIND;
+}
+
+void WaveformRecorder::record(uint64_t tick, uint32_t signal, State::t state) {
+    assert(signal < signalNames_.size());
+    // An event can't go in before the rewind marker it comes after.
+    if (!pushPendingRewind() || !events_.push({tick, signal, state}, rewindReserve_)) {
+        droppedCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void WaveformRecorder::recordRewind(uint64_t tick) {
+    // Two markers waiting for room can become one, the events between them were dropped anyway.
+    pendingRewind_ = std::min(pendingRewind_, tick);
+    pushPendingRewind();
+}
+
+uint64_t WaveformRecorder::getDroppedCount() const {
+    return droppedCount_.load(std::memory_order_relaxed);
+}
+
+size_t WaveformRecorder::getFreeSpace() const {
+    const size_t used = events_.size() + rewindReserve_;
+    return (used < events_.capacity() ? events_.capacity() - used : 0);
+}
+
+bool WaveformRecorder::pushPendingRewind() {
+    if (pendingRewind_ == NO_REWIND) {
+        return true;
+    }
+    if (!events_.push({pendingRewind_, REWIND_SIGNAL, State::disconnected})) {
+        return false;
+    }
+    pendingRewind_ = NO_REWIND;
+    return true;
+}
+
+size_t WaveformRecorder::collect() {
+    size_t count = 0;
+    Event event;
+    while (events_.pop(event)) {
+        if (event.signal == REWIND_SIGNAL) {
+            while (!history_.empty() && history_.back().tick >= event.tick) {
+                history_.pop_back();
+            }
+        } else {
+            history_.push_back(event);
+        }
+        ++count;
+    }
+    return count;
+}
+
+const std::vector<WaveformRecorder::Event>& WaveformRecorder::getHistory() const {
+    return history_;
+}
+
+void WaveformRecorder::clearHistory() {
+    history_.clear();
+}
+
+void WaveformRecorder::writeVcd(std::ostream& out) {
+    collect();
+    out << "$version CircuitSim2 $end\n";
+    out << "$comment One time unit is one tick. $end\n";
+    out << "$timescale 1 ns $end\n";
+    out << "$scope module board $end\n";
+    for (uint32_t i = 0; i < signalNames_.size(); ++i) {
+        // Names in VCD can't have whitespace in them.
+        std::string name = signalNames_[i];
+        for (auto& c : name) {
+            if (c == ' ' || c == '\t' || c == '\n') {
+                c = '_';
+            }
+        }
+        out << "$var wire 1 " << makeIdentifier(i) << " " << name << " $end\n";
+    }
+    out << "$upscope $end\n";
+    out << "$enddefinitions $end\n";
+
+    // Each signal starts out unknown until its first event.
+    out << "#" << (history_.empty() ? 0 : history_.front().tick) << "\n";
+    out << "$dumpvars\n";
+    for (uint32_t i = 0; i < signalNames_.size(); ++i) {
+        out << "x" << makeIdentifier(i) << "\n";
+    }
+    out << "$end\n";
+    uint64_t lastTick = (history_.empty() ? 0 : history_.front().tick);
+    for (const auto& event : history_) {
+        if (event.tick != lastTick) {
+            out << "#" << event.tick << "\n";
+            lastTick = event.tick;
+        }
+        out << stateToChar(event.state) << makeIdentifier(event.signal) << "\n";
+    }
+}
+
+std::string WaveformRecorder::makeIdentifier(uint32_t signal) {
+    // Base 94 using the printable ASCII characters.
+    std::string identifier;
+    do {
+        identifier.push_back(static_cast<char>('!' + signal % 94));
+        signal /= 94;
+    } while (signal > 0);
+    return identifier;
+}
+
+char WaveformRecorder::stateToChar(State::t state) {
+    switch (state) {
+    case State::low:
+        return '0';
+    case State::high:
+        return '1';
+    case State::middle:
+        return 'x';
+    default:
+        return 'z';
+    }
+}
+
+} // namespace sim
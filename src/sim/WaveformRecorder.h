@@ -0,0 +1,97 @@
+#pragma once
+
+#include <sim/RingBuffer.h>
+#include <Tile.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace sim {
+
+/**
+ * Captures the state changes of a set of signals (the probes set on the
+ * `Simulator`) and writes them out as a VCD file for viewing in a waveform
+ * viewer like GTKWave.
+ *
+ * The simulation thread only pushes events into a `sim::RingBuffer`, which
+ * never blocks. If the buffer fills up because nothing collects the events,
+ * new ones get dropped and counted instead. Another thread (or the same one
+ * between ticks) moves the events into the history with `collect()`.
+ *
+ * Time in the VCD is measured in ticks, an event is stamped with the tick that
+ * made the change. When the simulation rewinds, the history from that tick on
+ * gets replaced by the events recorded after it. A rewind marker is never
+ * dropped since the history would go out of order without it: the state
+ * changes leave a part of the buffer free for the markers, and if even that
+ * runs out the marker waits (and the state changes after it get dropped) until
+ * there is room.
+ */
+class WaveformRecorder {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+    struct Event {
+        uint64_t tick;
+        uint32_t signal;
+        State::t state;
+    };
+
+    WaveformRecorder(size_t capacity = DEFAULT_CAPACITY);
+    WaveformRecorder(const WaveformRecorder& rhs) = delete;
+    WaveformRecorder& operator=(const WaveformRecorder& rhs) = delete;
+
+    // The capacity gets rounded up to a power of two. Changing it drops the events in the buffer (but not the
+    // history), so it should only be done while nothing is recording.
+    void setCapacity(size_t capacity);
+    size_t getCapacity() const;
+
+    // Signals should only be added or cleared while nothing is recording.
+    uint32_t addSignal(const std::string& name);
+    size_t getSignalCount() const;
+    const std::string& getSignalName(uint32_t signal) const;
+    // Drops the signals and all events.
+    void clear();
+
+    // Producer side, these never block.
+    void record(uint64_t tick, uint32_t signal, State::t state);
+    void recordRewind(uint64_t tick);
+    uint64_t getDroppedCount() const;
+    // Number of state changes that can be recorded before the buffer fills up, only exact from the producer side or
+    // when it is idle.
+    size_t getFreeSpace() const;
+
+    // Consumer side. Moves the recorded events into the history, returns the number of events moved.
+    size_t collect();
+    const std::vector<Event>& getHistory() const;
+    void clearHistory();
+    // Collects any new events, then writes the whole history.
+    void writeVcd(std::ostream& out);
+
+private:
+    // Signal id of a rewind event, the tick it goes back to is in the event.
+    static constexpr uint32_t REWIND_SIGNAL = std::numeric_limits<uint32_t>::max();
+    static constexpr uint64_t NO_REWIND = std::numeric_limits<uint64_t>::max();
+    // Part of the buffer (as a fraction of the capacity) that only rewind markers can use.
+    static constexpr size_t REWIND_RESERVE_DIVISOR = 16;
+
+    // Pushes the rewind marker that didn't fit yet, returns false if it still doesn't.
+    bool pushPendingRewind();
+
+    static std::string makeIdentifier(uint32_t signal);
+    static char stateToChar(State::t state);
+
+    std::vector<std::string> signalNames_;
+    RingBuffer<Event> events_;
+    size_t rewindReserve_;
+    std::atomic<uint64_t> droppedCount_;
+    // Only touched by the producer.
+    uint64_t pendingRewind_;
+    std::vector<Event> history_;
+};
+
+} // namespace sim
@@ -0,0 +1,312 @@
+#include <MakeUnique.h>
+#include <sim/WireNetlist.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace sim {
+
+namespace {
+
+constexpr int CHANNELS_PER_CHUNK = Chunk::WIDTH * Chunk::WIDTH * 2;
+
+// Minimum amount of unused space in the flat arrays before we consider compacting.
+constexpr size_t MIN_COMPACT_ENTRIES = 4096;
+
+}
+
+constexpr uint32_t WireNetlist::NO_NET;
+
+WireNetlist::WireNetlist() :
+    nets_(),
+    freeNets_(),
+    wires_(),
+    endpoints_(),
+    links_(),
+    removedFragments_(),
+    splitRoots_(),
+    splitFragments_(),
+    chunkNetIds_(),
+    rootCount_(0),
+    liveEntries_(0),
+    deadEntries_(0) {
+}
+
+void WireNetlist::clear() {
+    nets_.clear();
+    freeNets_.clear();
+    wires_.clear();
+    endpoints_.clear();
+    links_.clear();
+    removedFragments_.clear();
+    splitRoots_.clear();
+    splitFragments_.clear();
+    chunkNetIds_.clear();
+    rootCount_ = 0;
+    liveEntries_ = 0;
+    deadEntries_ = 0;
+}
+
+void WireNetlist::resetStates() {
+    for (auto& fragment : nets_) {
+        fragment.lastTick = 0;
+        fragment.state = State::disconnected;
+    }
+}
+
+uint32_t WireNetlist::getNetId(TileRef tile, int channel) {
+    uint32_t fragmentId = getFragmentId(tile, channel);
+    return (fragmentId == NO_NET ? NO_NET : findRoot(fragmentId));
+}
+
+uint32_t WireNetlist::getFragmentId(TileRef tile, int channel) const {
+    if (tile.slot >= chunkNetIds_.size() || !chunkNetIds_[tile.slot]) {
+        return NO_NET;
+    }
+    return chunkNetIds_[tile.slot][tile.index * 2 + channel];
+}
+
+uint32_t WireNetlist::findRoot(uint32_t fragmentId) {
+    uint32_t root = fragmentId;
+    while (nets_[root].parent != root) {
+        root = nets_[root].parent;
+    }
+    while (nets_[fragmentId].parent != root) {
+        uint32_t parent = nets_[fragmentId].parent;
+        nets_[fragmentId].parent = root;
+        fragmentId = parent;
+    }
+    return root;
+}
+
+uint32_t WireNetlist::addNet(const std::vector<WireNode>& wires, const std::vector<Endpoint>& endpoints, const std::vector<uint32_t>& links) {
+    ++rootCount_;
+    const uint32_t fragmentId = addFragment(wires.data(), wires.size(), endpoints.data(), endpoints.size());
+    uint32_t root = fragmentId;
+    for (auto link : links) {
+        links_.push_back({link, nets_[link].generation});
+        root = merge(root, link);
+    }
+    nets_[fragmentId].linkCount = static_cast<uint32_t>(links.size());
+    liveEntries_ += links.size();
+    return root;
+}
+
+void WireNetlist::addEndpoint(uint32_t fragmentId, const Endpoint& endpoint) {
+    // The endpoints of a fragment are kept together, so they move to the end of the array first (unless they are
+    // there already).
+    Net& fragment = nets_[fragmentId];
+    for (uint32_t i = fragment.endpointOffset; i < fragment.endpointOffset + fragment.endpointCount; ++i) {
+        if (endpoints_[i].tile == endpoint.tile && endpoints_[i].wireDir == endpoint.wireDir) {
+            return;
+        }
+    }
+    if (fragment.endpointOffset + fragment.endpointCount != endpoints_.size()) {
+        const uint32_t endpointOffset = static_cast<uint32_t>(endpoints_.size());
+        endpoints_.reserve(endpoints_.size() + fragment.endpointCount + 1);
+        for (uint32_t i = 0; i < fragment.endpointCount; ++i) {
+            endpoints_.push_back(endpoints_[fragment.endpointOffset + i]);
+        }
+        fragment.endpointOffset = endpointOffset;
+        deadEntries_ += fragment.endpointCount;
+    }
+    endpoints_.push_back(endpoint);
+    ++fragment.endpointCount;
+    ++liveEntries_;
+
+    if (deadEntries_ > MIN_COMPACT_ENTRIES && deadEntries_ > liveEntries_) {
+        compact();
+    }
+}
+
+uint32_t WireNetlist::merge(uint32_t netId1, uint32_t netId2) {
+    uint32_t root1 = findRoot(netId1), root2 = findRoot(netId2);
+    if (root1 == root2) {
+        return root1;
+    }
+    if (nets_[root1].fragmentCount < nets_[root2].fragmentCount) {
+        std::swap(root1, root2);
+    }
+    Net& net1 = nets_[root1];
+    Net& net2 = nets_[root2];
+    net2.parent = root1;
+    nets_[net1.tail].next = root2;
+    net1.tail = net2.tail;
+    net1.fragmentCount += net2.fragmentCount;
+    net1.lastTick = std::max(net1.lastTick, net2.lastTick);
+    --rootCount_;
+    return root1;
+}
+
+void WireNetlist::removeFragmentsAt(TileRef tile, std::vector<WireNode>& wires) {
+    for (int channel = 0; channel < 2; ++channel) {
+        const uint32_t fragmentId = getFragmentId(tile, channel);
+        if (fragmentId != NO_NET) {
+            removedFragments_.push_back(fragmentId);
+        }
+    }
+    removeFragments(wires);
+}
+
+void WireNetlist::removeFragmentsIn(uint32_t slot, std::vector<WireNode>& wires) {
+    if (slot >= chunkNetIds_.size() || !chunkNetIds_[slot]) {
+        return;
+    }
+    for (int i = 0; i < CHANNELS_PER_CHUNK; ++i) {
+        const uint32_t fragmentId = chunkNetIds_[slot][i];
+        if (fragmentId != NO_NET && (removedFragments_.empty() || removedFragments_.back() != fragmentId)) {
+            removedFragments_.push_back(fragmentId);
+        }
+    }
+    removeFragments(wires);
+}
+
+WireNetlist::Net& WireNetlist::getNet(uint32_t netId) {
+    return nets_[netId];
+}
+
+const WireNode* WireNetlist::getWires(const Net& net) const {
+    return wires_.data() + net.wireOffset;
+}
+
+const Endpoint* WireNetlist::getEndpoints(const Net& net) const {
+    return endpoints_.data() + net.endpointOffset;
+}
+
+size_t WireNetlist::getNetCount() const {
+    return rootCount_;
+}
+
+uint32_t WireNetlist::addFragment(const WireNode* wires, size_t wireCount, const Endpoint* endpoints, size_t endpointCount) {
+    uint32_t fragmentId;
+    if (!freeNets_.empty()) {
+        fragmentId = freeNets_.back();
+        freeNets_.pop_back();
+        ++nets_[fragmentId].generation;
+    } else {
+        fragmentId = static_cast<uint32_t>(nets_.size());
+        nets_.emplace_back();
+    }
+
+    Net& fragment = nets_[fragmentId];
+    fragment.wireOffset = static_cast<uint32_t>(wires_.size());
+    fragment.wireCount = static_cast<uint32_t>(wireCount);
+    fragment.endpointOffset = static_cast<uint32_t>(endpoints_.size());
+    fragment.endpointCount = static_cast<uint32_t>(endpointCount);
+    fragment.linkOffset = static_cast<uint32_t>(links_.size());
+    fragment.linkCount = 0;
+    fragment.parent = fragmentId;
+    fragment.next = NO_NET;
+    fragment.tail = fragmentId;
+    fragment.fragmentCount = 1;
+    fragment.lastTick = 0;
+    fragment.state = State::disconnected;
+    fragment.valid = true;
+    wires_.insert(wires_.end(), wires, wires + wireCount);
+    endpoints_.insert(endpoints_.end(), endpoints, endpoints + endpointCount);
+    liveEntries_ += wireCount + endpointCount;
+
+    for (size_t i = 0; i < wireCount; ++i) {
+        const auto& wire = wires[i];
+        if (wire.tile.slot >= chunkNetIds_.size()) {
+            chunkNetIds_.resize(wire.tile.slot + 1);
+        }
+        auto& netIds = chunkNetIds_[wire.tile.slot];
+        if (!netIds) {
+            netIds = details::make_unique<uint32_t[]>(CHANNELS_PER_CHUNK);
+            std::fill(netIds.get(), netIds.get() + CHANNELS_PER_CHUNK, NO_NET);
+        }
+        netIds[wire.tile.index * 2 + wire.channel] = fragmentId;
+    }
+    return fragmentId;
+}
+
+void WireNetlist::removeFragments(std::vector<WireNode>& wires) {
+    splitRoots_.clear();
+    for (auto fragmentId : removedFragments_) {
+        splitRoots_.push_back(findRoot(fragmentId));
+    }
+    std::sort(splitRoots_.begin(), splitRoots_.end());
+    splitRoots_.erase(std::unique(splitRoots_.begin(), splitRoots_.end()), splitRoots_.end());
+    for (auto fragmentId : removedFragments_) {
+        if (nets_[fragmentId].valid) {
+            removeFragment(fragmentId, wires);
+        }
+    }
+    removedFragments_.clear();
+
+    // The fragments left in each net start out as nets of their own, then the links join the ones that still touch.
+    // A link to a removed fragment (or to a later fragment that reused its id) is skipped.
+    for (auto root : splitRoots_) {
+        splitFragments_.clear();
+        for (uint32_t fragmentId = root; fragmentId != NO_NET; fragmentId = nets_[fragmentId].next) {
+            if (nets_[fragmentId].valid) {
+                splitFragments_.push_back(fragmentId);
+            }
+        }
+        rootCount_ = rootCount_ + splitFragments_.size() - 1;
+        for (auto fragmentId : splitFragments_) {
+            Net& fragment = nets_[fragmentId];
+            fragment.parent = fragmentId;
+            fragment.next = NO_NET;
+            fragment.tail = fragmentId;
+            fragment.fragmentCount = 1;
+            fragment.lastTick = 0;
+        }
+        for (auto fragmentId : splitFragments_) {
+            const Net& fragment = nets_[fragmentId];
+            for (uint32_t i = fragment.linkOffset; i < fragment.linkOffset + fragment.linkCount; ++i) {
+                const Link link = links_[i];
+                if (nets_[link.fragmentId].valid && nets_[link.fragmentId].generation == link.generation) {
+                    merge(fragmentId, link.fragmentId);
+                }
+            }
+        }
+    }
+
+    if (deadEntries_ > MIN_COMPACT_ENTRIES && deadEntries_ > liveEntries_) {
+        compact();
+    }
+}
+
+void WireNetlist::removeFragment(uint32_t fragmentId, std::vector<WireNode>& wires) {
+    Net& fragment = nets_[fragmentId];
+    assert(fragment.valid);
+    for (uint32_t i = fragment.wireOffset; i < fragment.wireOffset + fragment.wireCount; ++i) {
+        chunkNetIds_[wires_[i].tile.slot][wires_[i].tile.index * 2 + wires_[i].channel] = NO_NET;
+    }
+    wires.insert(wires.end(), wires_.begin() + fragment.wireOffset, wires_.begin() + fragment.wireOffset + fragment.wireCount);
+    const size_t entries = fragment.wireCount + fragment.endpointCount + fragment.linkCount;
+    liveEntries_ -= entries;
+    deadEntries_ += entries;
+    fragment.valid = false;
+    freeNets_.push_back(fragmentId);
+}
+
+void WireNetlist::compact() {
+    std::vector<WireNode> wires;
+    std::vector<Endpoint> endpoints;
+    std::vector<Link> links;
+    wires.reserve(liveEntries_);
+    for (auto& fragment : nets_) {
+        if (!fragment.valid) {
+            continue;
+        }
+        const uint32_t wireOffset = static_cast<uint32_t>(wires.size());
+        const uint32_t endpointOffset = static_cast<uint32_t>(endpoints.size());
+        const uint32_t linkOffset = static_cast<uint32_t>(links.size());
+        wires.insert(wires.end(), wires_.begin() + fragment.wireOffset, wires_.begin() + fragment.wireOffset + fragment.wireCount);
+        endpoints.insert(endpoints.end(), endpoints_.begin() + fragment.endpointOffset, endpoints_.begin() + fragment.endpointOffset + fragment.endpointCount);
+        links.insert(links.end(), links_.begin() + fragment.linkOffset, links_.begin() + fragment.linkOffset + fragment.linkCount);
+        fragment.wireOffset = wireOffset;
+        fragment.endpointOffset = endpointOffset;
+        fragment.linkOffset = linkOffset;
+    }
+    wires_.swap(wires);
+    endpoints_.swap(endpoints);
+    links_.swap(links);
+    deadEntries_ = 0;
+}
+
+} // namespace sim
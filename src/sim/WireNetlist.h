@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Chunk.h>
+#include <sim/TileRef.h>
+#include <Tile.h>
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace sim {
+
+/**
+ * A wire channel is a path through a wire tile. Most wires only have channel
+ * zero, the crossover wire has a second channel for the east-west path.
+ */
+struct WireNode {
+    TileRef tile;
+    uint8_t channel;
+};
+
+/**
+ * A non-wire tile next to a net. The `wireDir` is the direction from the
+ * endpoint to the wire, this is used to determine if a gate is driving the net
+ * or is driven by it.
+ */
+struct Endpoint {
+    TileRef tile;
+    Direction::t wireDir;
+};
+
+/**
+ * Caches the connected groups of wires (nets) along with the endpoints next to
+ * them. Finding the state of a net then only needs to check the endpoints
+ * instead of following the whole wire again.
+ *
+ * Each net is made of one or more fragments joined with a union-find, so nets
+ * can be merged and endpoints added after an edit without following the wire
+ * again. The wires and endpoints of every fragment are stored in flat arrays,
+ * and the fragments of a net form a linked list starting at the root. Removing
+ * a fragment leaves a gap in the arrays that gets reclaimed later by
+ * compacting.
+ *
+ * The wires of a fragment are connected without going through any other
+ * fragment, and each fragment keeps links to the fragments its wires touch.
+ * When a wire is edited only the fragment holding it is removed, and the rest
+ * of the net is split up by joining the remaining fragments along their links
+ * again. The wires of the removed fragment need to be followed again by the
+ * user, this joins back any pieces that were only connected through them.
+ *
+ * Net extraction (following the wire) is done by the `Simulator` since it
+ * knows how to find adjacent tiles across chunks. Endpoints are not checked
+ * when they are added, so an endpoint may show up multiple times or may no
+ * longer be a valid endpoint; users need to check the current tile.
+ */
+class WireNetlist {
+public:
+    static constexpr uint32_t NO_NET = std::numeric_limits<uint32_t>::max();
+
+    struct Net {
+        uint32_t wireOffset, wireCount;
+        uint32_t endpointOffset, endpointCount;
+        uint32_t linkOffset, linkCount;
+        // Union-find parent, and the linked list of fragments (tail and count are only kept in the root).
+        uint32_t parent, next, tail, fragmentCount;
+        // Counts the reuses of this id, so that links to an earlier fragment with the same id can be told apart.
+        uint32_t generation;
+        uint64_t lastTick;
+        // The state last written to the wires of this fragment, disconnected if unknown.
+        State::t state;
+        bool valid;
+    };
+
+    WireNetlist();
+    WireNetlist(const WireNetlist& rhs) = delete;
+    WireNetlist& operator=(const WireNetlist& rhs) = delete;
+
+    void clear();
+    // Forgets the state and last tick of every fragment, for when the tile states change without going through the
+    // nets (like restoring a checkpoint).
+    void resetStates();
+    // Looks up the net (root fragment) containing a wire channel, returns `NO_NET` if none.
+    uint32_t getNetId(TileRef tile, int channel);
+    uint32_t getFragmentId(TileRef tile, int channel) const;
+    uint32_t findRoot(uint32_t fragmentId);
+    // Adds a fragment and joins it with the nets of the fragments in `links` (these must have a wire next to one
+    // of the new wires), returns the root.
+    uint32_t addNet(const std::vector<WireNode>& wires, const std::vector<Endpoint>& endpoints, const std::vector<uint32_t>& links);
+    // Adds an endpoint to the fragment with the wire next to it, unless the fragment has it already.
+    void addEndpoint(uint32_t fragmentId, const Endpoint& endpoint);
+    // Joins two nets together, returns the new root.
+    uint32_t merge(uint32_t netId1, uint32_t netId2);
+    // Removes the fragments on both channels of a tile (if any) and splits up the rest of their nets. The wires of
+    // the removed fragments get added to `wires` so they can be followed again.
+    void removeFragmentsAt(TileRef tile, std::vector<WireNode>& wires);
+    // Same as `removeFragmentsAt()` for every wire in a chunk.
+    void removeFragmentsIn(uint32_t slot, std::vector<WireNode>& wires);
+    Net& getNet(uint32_t netId);
+    const WireNode* getWires(const Net& net) const;
+    const Endpoint* getEndpoints(const Net& net) const;
+    size_t getNetCount() const;
+
+private:
+    using NetIdArray = std::unique_ptr<uint32_t[]>;
+
+    struct Link {
+        uint32_t fragmentId, generation;
+    };
+
+    uint32_t addFragment(const WireNode* wires, size_t wireCount, const Endpoint* endpoints, size_t endpointCount);
+    void removeFragments(std::vector<WireNode>& wires);
+    void removeFragment(uint32_t fragmentId, std::vector<WireNode>& wires);
+    void compact();
+
+    std::vector<Net> nets_;
+    std::vector<uint32_t> freeNets_;
+    std::vector<WireNode> wires_;
+    std::vector<Endpoint> endpoints_;
+    std::vector<Link> links_;
+    std::vector<uint32_t> removedFragments_, splitRoots_, splitFragments_;
+    // Fragment id for each wire channel, indexed by chunk slot then by `tileIndex * 2 + channel`.
+    std::vector<NetIdArray> chunkNetIds_;
+    size_t rootCount_;
+    size_t liveEntries_, deadEntries_;
+};
+
+} // namespace sim
@@ -0,0 +1,132 @@
+#include <MakeUnique.h>
+#include <sim/WorkerPool.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace sim {
+
+WorkerPool::WorkerPool(unsigned int numThreads) :
+    workers_(),
+    threads_(),
+    mutex_(),
+    startCondition_(),
+    doneCondition_(),
+    func_(nullptr),
+    generation_(0),
+    busyThreads_(0),
+    stopping_(false) {
+
+    numThreads = std::max(numThreads, 1u);
+    for (unsigned int i = 0; i < numThreads; ++i) {
+        workers_.push_back(details::make_unique<Worker>());
+    }
+    for (unsigned int i = 1; i < numThreads; ++i) {
+        threads_.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    startCondition_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+unsigned int WorkerPool::getThreadCount() const {
+    return static_cast<unsigned int>(workers_.size());
+}
+
+void WorkerPool::run(size_t numTasks, size_t blockSize, const TaskFunction& func) {
+    assert(blockSize > 0);
+    const size_t numBlocks = (numTasks + blockSize - 1) / blockSize;
+    if (threads_.empty() || numBlocks <= 1) {
+        for (size_t begin = 0; begin < numTasks; begin += blockSize) {
+            func(begin, std::min(begin + blockSize, numTasks), 0);
+        }
+        return;
+    }
+
+    // Deal out consecutive blocks to each worker, nearby tasks tend to touch the same chunks.
+    const size_t numWorkers = workers_.size();
+    for (size_t i = 0; i < numWorkers; ++i) {
+        std::lock_guard<std::mutex> lock(workers_[i]->mutex);
+        for (size_t j = numBlocks * i / numWorkers; j < numBlocks * (i + 1) / numWorkers; ++j) {
+            workers_[i]->blocks.emplace_back(j * blockSize, std::min((j + 1) * blockSize, numTasks));
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        func_ = &func;
+        ++generation_;
+        busyThreads_ = static_cast<unsigned int>(threads_.size());
+    }
+    startCondition_.notify_all();
+
+    runBlocks(0);
+
+    // The function is owned by the caller, so wait until every thread is done with it.
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCondition_.wait(lock, [this]{ return busyThreads_ == 0; });
+    func_ = nullptr;
+}
+
+bool WorkerPool::takeBlock(unsigned int worker, std::pair<size_t, size_t>& block) {
+    {
+        Worker& own = *workers_[worker];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.blocks.empty()) {
+            block = own.blocks.front();
+            own.blocks.pop_front();
+            return true;
+        }
+    }
+    for (size_t i = 1; i < workers_.size(); ++i) {
+        Worker& victim = *workers_[(worker + i) % workers_.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.blocks.empty()) {
+            block = victim.blocks.back();
+            victim.blocks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkerPool::runBlocks(unsigned int worker) {
+    std::pair<size_t, size_t> block;
+    while (takeBlock(worker, block)) {
+        (*func_)(block.first, block.second, worker);
+    }
+}
+
+void WorkerPool::workerLoop(unsigned int worker) {
+    uint64_t lastGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            startCondition_.wait(lock, [this, lastGeneration]{ return stopping_ || generation_ != lastGeneration; });
+            if (stopping_) {
+                return;
+            }
+            lastGeneration = generation_;
+        }
+
+        runBlocks(worker);
+
+        bool lastThread;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lastThread = (--busyThreads_ == 0);
+        }
+        if (lastThread) {
+            doneCondition_.notify_one();
+        }
+    }
+}
+
+} // namespace sim
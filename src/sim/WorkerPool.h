@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sim {
+
+/**
+ * A persistent group of threads for running the parallel parts of a tick.
+ *
+ * Each call to `run()` splits a range of tasks into blocks, and the blocks are
+ * dealt out to a deque for each worker (the calling thread is worker zero).
+ * Workers take blocks from the front of their own deque, and once it runs out
+ * they steal from the back of the other deques. The task function should only
+ * write to the output for its own block, this way the results can be merged in
+ * block order to get the same result no matter how the blocks were scheduled.
+ */
+class WorkerPool {
+public:
+    // Called with the task range `[begin, end)` and the index of the worker running it.
+    using TaskFunction = std::function<void(size_t begin, size_t end, unsigned int worker)>;
+
+    WorkerPool(unsigned int numThreads);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool& rhs) = delete;
+    WorkerPool& operator=(const WorkerPool& rhs) = delete;
+
+    unsigned int getThreadCount() const;
+    // Runs tasks `[0, numTasks)` in blocks of `blockSize` tasks, returns once all of them have finished.
+    void run(size_t numTasks, size_t blockSize, const TaskFunction& func);
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<std::pair<size_t, size_t>> blocks;
+    };
+
+    bool takeBlock(unsigned int worker, std::pair<size_t, size_t>& block);
+    void runBlocks(unsigned int worker);
+    void workerLoop(unsigned int worker);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable startCondition_, doneCondition_;
+    const TaskFunction* func_;
+    uint64_t generation_;
+    unsigned int busyThreads_;
+    bool stopping_;
+};
+
+} // namespace sim
@@ -0,0 +1,137 @@
+#include <Board.h>
+#include <sim/BatchSimulator.h>
+#include <sim/TileLogic.h>
+#include <Simulator.h>
+#include <Tile.h>
+#include <tiles/Gate.h>
+#include <tiles/Input.h>
+#include <tiles/Led.h>
+#include <tiles/Wire.h>
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Batch lanes run independent input vectors", "[BatchSimulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // Half adder, each gate gets its own copy of the inputs.
+    board.accessTile(2, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(2, 1).setType(tiles::Gate::instance(), TileId::gateXor, Direction::east);
+    board.accessTile(2, 2).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+    board.accessTile(3, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(4, 1).setType(tiles::Led::instance());
+    board.accessTile(2, 4).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(2, 5).setType(tiles::Gate::instance(), TileId::gateAnd, Direction::east);
+    board.accessTile(2, 6).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+    board.accessTile(3, 5).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(4, 5).setType(tiles::Led::instance());
+
+    unsigned int numWords = GENERATE(1u, 2u, sim::BatchSimulator::MAX_WORDS);
+    sim::BatchSimulator batch(board, numWords);
+    batch.build();
+    CHECK(batch.getLaneCount() == numWords * 64);
+    CHECK(batch.getGateCount() == 2);
+    CHECK(batch.accessSignal({0, 0}) == nullptr);
+    batch.setCounter({2, 0}, 0, 0);
+    batch.setCounter({2, 4}, 0, 0);
+    batch.setCounter({2, 2}, 1, 0);
+    batch.setCounter({2, 6}, 1, 0);
+    batch.tick();
+
+    const uint64_t* sum = batch.accessSignal({4, 1});
+    const uint64_t* carry = batch.accessSignal({3, 5});
+    REQUIRE(sum != nullptr);
+    REQUIRE(carry != nullptr);
+    for (unsigned int lane = 0; lane < batch.getLaneCount(); ++lane) {
+        const uint64_t a = lane & 1, b = lane >> 1 & 1;
+        CHECK((sum[lane / 64] >> lane % 64 & 1) == (a ^ b));
+        CHECK((carry[lane / 64] >> lane % 64 & 1) == (a & b));
+    }
+}
+
+TEST_CASE("Batch ticks match the simulator", "[BatchSimulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.setExtraLogicStates(GENERATE(false, true));
+    // A ring oscillator feeding a chain of gates, with a crossover and an LED group.
+    board.accessTile(0, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireJunction);
+    board.accessTile(1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(0, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(-1, 1).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+    board.accessTile(2, 0).setType(tiles::Gate::instance(), TileId::gateBuffer, Direction::east);
+    board.accessTile(3, 0).setType(tiles::Wire::instance(), TileId::wireCrossover);
+    board.accessTile(3, -1).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'b');
+    board.accessTile(3, 1).setType(tiles::Gate::instance(), TileId::gateNand, Direction::south);
+    board.accessTile(4, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    board.accessTile(4, 0).setType(tiles::Gate::instance(), TileId::gateXnor, Direction::south);
+    board.accessTile(5, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'c');
+    board.accessTile(3, 2).setType(tiles::Led::instance());
+    board.accessTile(4, 2).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.reset();
+    sim::BatchSimulator batch(board, 2);
+    batch.build();
+    for (int i = 0; i < 8; ++i) {
+        simulator.tick();
+        batch.tick();
+        for (const auto& pos : {sf::Vector2i(1, 0), sf::Vector2i(2, 0), sf::Vector2i(3, 1), sf::Vector2i(4, 1), sf::Vector2i(4, 0), sf::Vector2i(3, 2)}) {
+            INFO("Tick " << i << " at (" << pos.x << ", " << pos.y << ")");
+            CHECK(batch.getLaneState(pos, 0) == board.accessTile(pos).getState());
+            CHECK(batch.getLaneState(pos, 127) == board.accessTile(pos).getState());
+        }
+        CHECK(batch.getLaneState({3, 0}, 0, 1) == board.accessTile(3, 0).getRawData().state2);
+    }
+}
+
+TEST_CASE("Batch extra logic states use two planes", "[BatchSimulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.setExtraLogicStates(true);
+    // Tri-state buffer with the input from the back and the control from the side, driving a net with another switch.
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Gate::instance(), TileId::gateBuffer, Direction::east);
+    board.accessTile(1, 1).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+    board.accessTile(2, 0).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+    board.accessTile(2, 1).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'c');
+    board.accessTile(3, 0).setType(tiles::Gate::instance(), TileId::gateNand, Direction::east);
+    board.accessTile(3, 1).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'd');
+    board.accessTile(4, 0).setType(tiles::Led::instance());
+
+    sim::BatchSimulator batch(board, 2);
+    batch.build();
+    REQUIRE(batch.getExtraLogicStates());
+    batch.setCounter({0, 0}, 0, 0);
+    batch.setCounter({1, 1}, 1, 0);
+    batch.setCounter({2, 1}, 2, 0);
+    batch.setCounter({3, 1}, 3, 0);
+    batch.tick();
+    batch.tick();
+
+    // Check each lane against the scalar rules.
+    for (unsigned int lane = 0; lane < batch.getLaneCount(); ++lane) {
+        INFO("Lane " << lane);
+        const bool input = lane & 1, control = lane >> 1 & 1, otherDriver = lane >> 2 & 1, other = lane >> 3 & 1;
+        const State::t inputState = (input ? State::high : State::low);
+        const State::t controlState = (control ? State::high : State::low);
+        const State::t otherState = (otherDriver ? State::high : State::low);
+        const State::t adjacent[4] = {State::disconnected, State::disconnected, controlState, inputState};
+        const State::t bufferState = sim::evaluateGate(TileId::gateBuffer, Direction::east, adjacent, true);
+        CHECK(batch.getLaneState({1, 0}, lane) == bufferState);
+
+        unsigned int numLow = 0, numHigh = 0, numMiddle = 0;
+        for (auto driver : {bufferState, otherState}) {
+            numLow += (driver == State::low);
+            numHigh += (driver == State::high);
+            numMiddle += (driver == State::middle);
+        }
+        bool conflict;
+        const State::t netState = sim::resolveNet(numLow, numHigh, numMiddle, true, conflict);
+        CHECK(batch.getLaneState({2, 0}, lane) == netState);
+
+        const State::t nandAdjacent[4] = {State::disconnected, State::disconnected, (other ? State::high : State::low), netState};
+        const State::t nandState = sim::evaluateGate(TileId::gateNand, Direction::east, nandAdjacent, true);
+        CHECK(batch.getLaneState({3, 0}, lane) == nandState);
+        CHECK(batch.getLaneState({4, 0}, lane) == (nandState == State::high ? State::high : State::low));
+    }
+}
@@ -0,0 +1,70 @@
+#include <Board.h>
+#include <Chunk.h>
+#include <ChunkSwapFile.h>
+#include <Tile.h>
+#include <tiles/Gate.h>
+#include <tiles/Wire.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <vector>
+
+TEST_CASE("Swapped chunks come back unchanged", "[ChunkSwapFile]") {
+    // Build a few chunks with different tiles in them, then keep a copy of their tiles to compare with.
+    Board board;
+    board.newBoard({0, 0});
+    constexpr int numChunks = 4;
+    for (int i = 0; i < numChunks; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            board.accessTile(i * Chunk::WIDTH + j, j).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east, State::high);
+        }
+        board.accessTile(i * Chunk::WIDTH, Chunk::WIDTH - 1).setType(tiles::Gate::instance(), TileId::gateAnd, Direction::north);
+    }
+    std::vector<std::vector<TileData>> expected(numChunks);
+    for (int i = 0; i < numChunks; ++i) {
+        Chunk& chunk = board.accessChunk(ChunkCoords::pack(i, 0));
+        for (unsigned int j = 0; j < Chunk::WIDTH * Chunk::WIDTH; ++j) {
+            expected[i].push_back(chunk.accessTile(j).getRawData());
+        }
+    }
+
+    ChunkSwapFile swapFile;
+    for (int i = 0; i < numChunks; ++i) {
+        swapFile.store(std::move(board.accessChunk(ChunkCoords::pack(i, 0))));
+    }
+    CHECK(swapFile.getStoredCount() == numChunks);
+    CHECK_FALSE(swapFile.contains(ChunkCoords::pack(numChunks, 0)));
+
+    // Take one back right away (it may not be written yet), then the rest after the writes are done.
+    auto checkTake = [&](int i) {
+        Chunk chunk(nullptr, ChunkCoords::pack(i, 0));
+        REQUIRE(swapFile.take(ChunkCoords::pack(i, 0), chunk));
+        CHECK_FALSE(swapFile.contains(ChunkCoords::pack(i, 0)));
+        unsigned int mismatchCount = 0;
+        for (unsigned int j = 0; j < Chunk::WIDTH * Chunk::WIDTH; ++j) {
+            mismatchCount += (chunk.accessTile(j).getRawData() == expected[i][j] ? 0 : 1);
+        }
+        CHECK(mismatchCount == 0);
+        return chunk;
+    };
+    checkTake(0);
+    swapFile.flush();
+    auto storedCoords = swapFile.getStoredCoords();
+    std::sort(storedCoords.begin(), storedCoords.end());
+    CHECK(storedCoords == std::vector<ChunkCoords::repr>{ChunkCoords::pack(1, 0), ChunkCoords::pack(2, 0), ChunkCoords::pack(3, 0)});
+    checkTake(2);
+
+    // A chunk stored again takes the place of the old one.
+    Chunk third = checkTake(3);
+    third.accessTile(5).setType(tiles::Wire::instance(), TileId::wireJunction);
+    expected[3][5] = third.accessTile(5).getRawData();
+    swapFile.store(std::move(third));
+    swapFile.flush();
+    checkTake(3);
+    CHECK(swapFile.getStoredCount() == 1);
+
+    swapFile.clear();
+    CHECK(swapFile.getStoredCount() == 0);
+    Chunk chunk(nullptr, ChunkCoords::pack(1, 0));
+    CHECK_FALSE(swapFile.take(ChunkCoords::pack(1, 0), chunk));
+}
@@ -0,0 +1,127 @@
+#include <Chunk.h>
+#include <ChunkCoords.h>
+#include <ChunkTable.h>
+
+#include <catch2/catch.hpp>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+TEST_CASE("Test access and modification", "[ChunkTable]") {
+    ChunkTable<int> table;
+    CHECK(table.empty());
+    CHECK(table.begin() == table.end());
+    CHECK(table.find(ChunkCoords::pack(0, 0)) == table.end());
+
+    auto result = table.try_emplace(ChunkCoords::pack(0, 0), 10);
+    CHECK(result.second);
+    CHECK(result.first->first == ChunkCoords::pack(0, 0));
+    CHECK(result.first->second == 10);
+    result = table.try_emplace(ChunkCoords::pack(0, 0), 20);
+    CHECK(!result.second);
+    CHECK(result.first->second == 10);
+    table.try_emplace(ChunkCoords::pack(-1, 5), 30);
+    CHECK(table.size() == 2);
+    CHECK(table.count(ChunkCoords::pack(-1, 5)) == 1);
+    CHECK(table.at(ChunkCoords::pack(-1, 5)) == 30);
+    CHECK_THROWS_AS(table.at(ChunkCoords::pack(5, -1)), std::out_of_range);
+
+    CHECK(table.erase(ChunkCoords::pack(0, 0)) == 1);
+    CHECK(table.erase(ChunkCoords::pack(0, 0)) == 0);
+    CHECK(table.size() == 1);
+    CHECK(table.find(ChunkCoords::pack(0, 0)) == table.end());
+    CHECK(table.at(ChunkCoords::pack(-1, 5)) == 30);
+
+    table.clear();
+    CHECK(table.empty());
+    CHECK(table.count(ChunkCoords::pack(-1, 5)) == 0);
+}
+
+TEST_CASE("Test against unordered_map", "[ChunkTable]") {
+    ChunkTable<int> table;
+    std::unordered_map<ChunkCoords::repr, int> expected;
+    std::mt19937 rng(1234);
+
+    // Keeping the coordinates in a small area means lots of erases and reinserts, which reuse slab slots and
+    // shift back buckets.
+    for (int i = 0; i < 20000; ++i) {
+        const ChunkCoords::repr coords = ChunkCoords::pack(static_cast<int>(rng() % 48) - 24, static_cast<int>(rng() % 48) - 24);
+        if (rng() % 3 == 0) {
+            REQUIRE(table.erase(coords) == expected.erase(coords));
+        } else {
+            const bool inserted = expected.emplace(coords, i).second;
+            const auto result = table.try_emplace(coords, i);
+            REQUIRE(result.second == inserted);
+            REQUIRE(result.first->second == expected.at(coords));
+        }
+        REQUIRE(table.size() == expected.size());
+    }
+
+    size_t visited = 0;
+    for (const auto& value : table) {
+        REQUIRE(expected.count(value.first) == 1);
+        CHECK(expected.at(value.first) == value.second);
+        ++visited;
+    }
+    CHECK(visited == expected.size());
+    for (const auto& value : expected) {
+        REQUIRE(table.find(value.first) != table.end());
+        CHECK(table.find(value.first)->second == value.second);
+    }
+}
+
+TEST_CASE("Test references stay valid", "[ChunkTable]") {
+    ChunkTable<Chunk> table;
+    std::vector<std::pair<ChunkCoords::repr, const Chunk*>> chunks;
+    for (int y = 0; y < 40; ++y) {
+        for (int x = 0; x < 40; ++x) {
+            const ChunkCoords::repr coords = ChunkCoords::pack(x, y);
+            chunks.emplace_back(coords, &table.try_emplace(coords, nullptr, coords).first->second);
+        }
+    }
+    // The table grew several times while adding these, which only moves the buckets around.
+    REQUIRE(table.bucket_count() >= chunks.size());
+    for (const auto& chunk : chunks) {
+        REQUIRE(&table.at(chunk.first) == chunk.second);
+        REQUIRE(chunk.second->getCoords() == chunk.first);
+    }
+
+    // Erasing some chunks doesn't affect the others, and the new chunks go in the free slots.
+    for (size_t i = 0; i < chunks.size(); i += 2) {
+        table.erase(chunks[i].first);
+    }
+    for (size_t i = 0; i < chunks.size(); i += 2) {
+        table.try_emplace(ChunkCoords::pack(-1 - static_cast<int>(i), 0), nullptr, ChunkCoords::pack(-1 - static_cast<int>(i), 0));
+    }
+    for (size_t i = 1; i < chunks.size(); i += 2) {
+        REQUIRE(&table.at(chunks[i].first) == chunks[i].second);
+    }
+
+    ChunkTable<Chunk> movedTable(std::move(table));
+    CHECK(table.empty());
+    for (size_t i = 1; i < chunks.size(); i += 2) {
+        REQUIRE(&movedTable.at(chunks[i].first) == chunks[i].second);
+    }
+}
+
+TEST_CASE("Test values are destroyed", "[ChunkTable]") {
+    auto counter = std::make_shared<int>(0);
+    {
+        ChunkTable<std::shared_ptr<int>> table;
+        for (int x = 0; x < 100; ++x) {
+            table.try_emplace(ChunkCoords::pack(x, 0), counter);
+        }
+        CHECK(counter.use_count() == 101);
+        table.erase(table.find(ChunkCoords::pack(50, 0)));
+        CHECK(counter.use_count() == 100);
+
+        ChunkTable<std::shared_ptr<int>> otherTable;
+        otherTable.try_emplace(ChunkCoords::pack(0, 0), counter);
+        otherTable = std::move(table);
+        CHECK(counter.use_count() == 100);
+    }
+    CHECK(counter.use_count() == 1);
+}
@@ -0,0 +1,190 @@
+#include <Board.h>
+#include <sim/CompiledNetlist.h>
+#include <Simulator.h>
+#include <Tile.h>
+#include <tiles/Gate.h>
+#include <tiles/Input.h>
+#include <tiles/Led.h>
+#include <tiles/Wire.h>
+
+#include <catch2/catch.hpp>
+
+namespace {
+
+// Two cross-coupled nor gates. The set switch is at (1, 1) and the reset switch is at (1, 4), the output of the
+// second gate (the stored bit) runs along the left side. The first gate (and its wire) start high so that the
+// latch is stable.
+void buildNorLatch(Board& board) {
+    board.accessTile(1, 1).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 's');
+    board.accessTile(2, 1).setType(tiles::Gate::instance(), TileId::gateNor, Direction::east, State::high);
+    board.accessTile(3, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south, State::high);
+    board.accessTile(3, 2).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north, State::high);
+    board.accessTile(3, 3).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west, State::high);
+    board.accessTile(2, 3).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east, State::high);
+    board.accessTile(1, 4).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'r');
+    board.accessTile(2, 4).setType(tiles::Gate::instance(), TileId::gateNor, Direction::east);
+    board.accessTile(3, 4).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(3, 5).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    board.accessTile(3, 6).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(2, 6).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(1, 6).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(0, 6).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    for (int y = 3; y <= 5; ++y) {
+        board.accessTile(0, y).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    }
+    board.accessTile(0, 2).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+    board.accessTile(1, 2).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(2, 2).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+}
+
+}
+
+TEST_CASE("Compiled logic settles in one pass", "[CompiledNetlist]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.setExtraLogicStates(GENERATE(false, true));
+    // Switch, five not gates, and an LED.
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x <= 5; ++x) {
+        board.accessTile(x, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    }
+    board.accessTile(6, 0).setType(tiles::Led::instance());
+
+    sim::CompiledNetlist netlist(board);
+    netlist.build();
+    // The LED just follows the last gate, except for the middle state with extra logic states.
+    CHECK(netlist.getSignalCount() == 7);
+    CHECK(netlist.getInstructionCount() == (board.getExtraLogicStates() ? 6 : 5));
+    CHECK(netlist.getLevelCount() == (board.getExtraLogicStates() ? 7 : 6));
+    CHECK(netlist.getConstantCount() == 0);
+    CHECK(netlist.getFeedbackGateCount() == 0);
+    CHECK(netlist.getState({7, 0}) == State::disconnected);
+
+    CHECK(netlist.run(0));
+    CHECK(netlist.getState({5, 0}) == State::high);
+    CHECK(netlist.getState({6, 0}) == State::high);
+    netlist.setState({0, 0}, State::high);
+    CHECK(netlist.run(0));
+    CHECK(netlist.getState({1, 0}) == State::low);
+    CHECK(netlist.getState({5, 0}) == State::low);
+    CHECK(netlist.getState({6, 0}) == State::low);
+
+    // The simulator reaches the same state after enough ticks.
+    board.accessTile(0, 0).setState(State::high);
+    Simulator simulator(board);
+    simulator.reset();
+    REQUIRE(simulator.settle(100).stable);
+    for (int x = 1; x <= 6; ++x) {
+        CHECK(board.accessTile(x, 0).getState() == netlist.getState({x, 0}));
+    }
+}
+
+TEST_CASE("Compiled feedback loops keep their state", "[CompiledNetlist]") {
+    Board board;
+    board.newBoard({0, 0});
+    buildNorLatch(board);
+    Simulator simulator(board);
+    simulator.reset();
+    REQUIRE(simulator.settle(100).stable);
+
+    sim::CompiledNetlist netlist(board);
+    netlist.build();
+    CHECK(netlist.getFeedbackGateCount() == 2);
+    CHECK(netlist.getInstructionCount() == 1);
+    const sf::Vector2i setPos(1, 1), resetPos(1, 4), bitPos(0, 4);
+    CHECK(netlist.run(100));
+    CHECK(netlist.getState(bitPos) == State::low);
+
+    netlist.setState(setPos, State::high);
+    CHECK(netlist.run(100));
+    CHECK(netlist.getState(bitPos) == State::high);
+    netlist.setState(setPos, State::low);
+    CHECK(netlist.run(100));
+    CHECK(netlist.getState(bitPos) == State::high);
+    netlist.setState(resetPos, State::high);
+    CHECK(netlist.run(100));
+    CHECK(netlist.getState(bitPos) == State::low);
+
+    // Write the set state back to the board, the simulator should already be settled there.
+    netlist.setState(resetPos, State::low);
+    netlist.setState(setPos, State::high);
+    REQUIRE(netlist.run(100));
+    netlist.writeStates();
+    CHECK(board.accessTile(bitPos).getState() == State::high);
+    CHECK(board.accessTile(2, 1).getState() == State::low);
+    simulator.reset();
+    REQUIRE(simulator.settle(100).stable);
+    CHECK(board.accessTile(bitPos).getState() == State::high);
+    CHECK(board.accessTile(2, 1).getState() == State::low);
+    CHECK(board.accessTile(2, 4).getState() == State::high);
+
+    // A ring oscillator never settles.
+    board.accessTile(10, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(11, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(11, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(10, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(9, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(9, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+    netlist.build();
+    CHECK(netlist.getFeedbackGateCount() == 3);
+    CHECK_FALSE(netlist.run(100));
+}
+
+TEST_CASE("Compiled logic folds constants and aliases", "[CompiledNetlist]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A not gate with nothing connected is always high, and so is everything after it.
+    board.accessTile(0, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Gate::instance(), TileId::gateDiode, Direction::east);
+    board.accessTile(3, 0).setType(tiles::Led::instance());
+    // Diodes, a wire, and an LED that all follow a switch.
+    board.accessTile(0, 2).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 2).setType(tiles::Gate::instance(), TileId::gateDiode, Direction::east);
+    board.accessTile(2, 2).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(3, 2).setType(tiles::Gate::instance(), TileId::gateDiode, Direction::east);
+    board.accessTile(4, 2).setType(tiles::Led::instance());
+    // Two not gates after a switch that nothing reads from.
+    board.accessTile(0, 4).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+    board.accessTile(1, 4).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(2, 4).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+
+    sim::CompiledNetlist netlist(board);
+    netlist.build();
+    CHECK(netlist.getConstantCount() == 4);
+    CHECK(netlist.getAliasCount() == 4);
+    CHECK(netlist.getInstructionCount() == 2);
+    CHECK(netlist.getState({3, 0}) == State::high);
+    CHECK(netlist.run(0));
+    CHECK(netlist.getState({3, 0}) == State::high);
+    CHECK(netlist.getState({4, 2}) == State::low);
+    netlist.setState({0, 2}, State::high);
+    netlist.setState({0, 4}, State::high);
+    CHECK(netlist.run(0));
+    CHECK(netlist.getState({2, 2}) == State::high);
+    CHECK(netlist.getState({4, 2}) == State::high);
+    CHECK(netlist.getState({2, 4}) == State::high);
+    netlist.writeStates();
+
+    // Nothing depends on the not gates, unless one of them is observed.
+    netlist.setRemoveDeadLogic(true);
+    netlist.build();
+    CHECK(netlist.getDeadCount() == 2);
+    CHECK(netlist.getInstructionCount() == 0);
+    CHECK(netlist.run(0));
+    CHECK(netlist.getState({4, 2}) == State::high);
+    netlist.addObservedTile({1, 4});
+    netlist.build();
+    CHECK(netlist.getDeadCount() == 1);
+    CHECK(netlist.getInstructionCount() == 1);
+    netlist.clearObservedTiles();
+
+    // With constant inputs everything folds away.
+    netlist.setRemoveDeadLogic(false);
+    netlist.setConstantInputs(true);
+    netlist.build();
+    CHECK(netlist.getConstantCount() == 12);
+    CHECK(netlist.getInstructionCount() == 0);
+    CHECK(netlist.getState({2, 4}) == State::high);
+    CHECK(netlist.getState({4, 2}) == State::high);
+}
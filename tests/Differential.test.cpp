@@ -0,0 +1,138 @@
+#include <Board.h>
+#include <DebugScreen.h>
+#include "LegacySimulator.h"
+#include <Locator.h>
+#include <MakeUnique.h>
+#include <ResourceBase.h>
+#include <ResourceNull.h>
+#include <sim/TileLogic.h>
+#include <Simulator.h>
+#include <Tile.h>
+
+// Required for the TestRunListener.
+#define CATCH_CONFIG_EXTERNAL_INTERFACES
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs the boards in both the legacy simulator (src/deadcode) and the current
+// one side by side. Each tick presses some random keys on both, then every LED
+// and gate needs to have the same state. The throughput of both is printed
+// at the end of each board, this only includes the time spent ticking.
+//
+// These tests expect to run from the root of the repository (to find the
+// boards and resources), ctest sets this up.
+
+namespace {
+
+constexpr int NUM_TICKS = 1000;
+constexpr uint32_t RANDOM_SEED = 1234;
+// Chance of a key press in each tick, one in this many.
+constexpr int KEY_PRESS_ODDS = 8;
+
+double ticksPerSecond(int ticks, std::chrono::steady_clock::duration elapsed) {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return (seconds > 0.0 ? ticks / seconds : 0.0);
+}
+
+}
+
+/**
+ * Provides the service locator and sets up the debug screen, the same as the
+ * listener in RegionFileFormat.test.cpp (this test builds into a separate
+ * executable).
+ */
+struct TestRunListener : public Catch::TestEventListenerBase {
+    using TestEventListenerBase::TestEventListenerBase;
+
+    virtual void testRunStarting(const Catch::TestRunInfo& /*testRunInfo*/) override {
+        Locator::provide(details::make_unique<ResourceNull>());
+        DebugScreen::init(Locator::getResource()->getFont("sample_font"), 16, {800, 600});
+    }
+
+    virtual void testRunEnded(const Catch::TestRunStats& /*testRunStats*/) override {
+        Locator::provide(std::unique_ptr<ResourceNull>(nullptr));
+    }
+};
+
+CATCH_REGISTER_LISTENER(TestRunListener)
+
+TEST_CASE("Simulator matches the legacy simulator", "[Differential]") {
+    const std::string filename = GENERATE(as<std::string>(),
+        "boards/Calculator.txt",
+        "boards/Computer.txt",
+        "boards/ComputerGame.txt",
+        "boards/ComputerGuessNum.txt",
+        "boards/tutorials/Tutorial01_TheBasics.txt",
+        "boards/tutorials/Tutorial02_LogicGates.txt",
+        "boards/tutorials/Tutorial03_Binary.txt",
+        "boards/tutorials/Tutorial04_TriState.txt"
+    );
+    INFO("Board " << filename);
+
+    LegacySimulator legacySimulator("resources/consolas.ttf");
+    legacySimulator.loadFile(filename);
+    Board board;
+    REQUIRE(board.loadFromFile(filename));
+    board.forceLoadAllChunks();
+    REQUIRE(board.getMaxSize() == sf::Vector2u(legacySimulator.getWidth(), legacySimulator.getHeight()));
+    REQUIRE(board.getExtraLogicStates() == legacySimulator.getExtraLogicStates());
+    Simulator simulator(board);
+    simulator.reset();
+
+    // Only the LEDs and gates get compared, the wires in between them can get set in a different order.
+    std::vector<sf::Vector2i> outputs;
+    for (unsigned int y = 0; y < board.getMaxSize().y; ++y) {
+        for (unsigned int x = 0; x < board.getMaxSize().x; ++x) {
+            const TileId::t id = board.accessTile(x, y).getId();
+            if (id == TileId::outLed || sim::isGate(id)) {
+                outputs.emplace_back(x, y);
+            }
+        }
+    }
+    const std::vector<char> keycodes = legacySimulator.getKeycodes();
+
+    std::mt19937 rng(RANDOM_SEED);
+    std::chrono::steady_clock::duration legacyElapsed(0), elapsed(0);
+    unsigned int mismatchCount = 0;
+    std::string firstMismatch;
+    int tickCount = 0;
+    for (; tickCount < NUM_TICKS && mismatchCount == 0; ++tickCount) {
+        if (!keycodes.empty() && rng() % KEY_PRESS_ODDS == 0) {
+            const char keycode = keycodes[rng() % keycodes.size()];
+            legacySimulator.pressKey(keycode);
+            simulator.pressKey(keycode);
+        }
+        auto startTime = std::chrono::steady_clock::now();
+        legacySimulator.tick();
+        legacyElapsed += std::chrono::steady_clock::now() - startTime;
+        startTime = std::chrono::steady_clock::now();
+        simulator.tick();
+        elapsed += std::chrono::steady_clock::now() - startTime;
+
+        for (const auto& pos : outputs) {
+            const int legacyState = legacySimulator.getState(pos.x, pos.y);
+            const int state = board.accessTile(pos).getState();
+            if (state != legacyState) {
+                if (mismatchCount == 0) {
+                    std::ostringstream message;
+                    message << "tick " << tickCount << " at (" << pos.x << ", " << pos.y << "): expected " << legacyState << " but got " << state;
+                    firstMismatch = message.str();
+                }
+                ++mismatchCount;
+            }
+        }
+    }
+    INFO("First mismatch on " << firstMismatch);
+    CHECK(mismatchCount == 0);
+
+    std::cout << filename << ": " << outputs.size() << " outputs, " << keycodes.size() << " keys, legacy "
+        << ticksPerSecond(tickCount, legacyElapsed) << " TPS, current " << ticksPerSecond(tickCount, elapsed) << " TPS\n";
+}
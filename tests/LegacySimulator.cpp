@@ -0,0 +1,148 @@
+#include "LegacySimulator.h"
+#include <MakeUnique.h>
+
+// Everything the old sources include needs to come first, so that the headers
+// don't end up inside of the namespace.
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <random>
+#include <SFML/Graphics.hpp>
+#include <stack>
+#include <stdexcept>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace legacy {
+
+// The boards are saved with Windows line endings, which the old app never saw since it read them in text mode. This
+// gets picked over `std::getline()` in the old sources (non-template overloads win).
+std::istream& getline(std::istream& in, std::string& str) {
+    std::getline(in, str);
+    if (!str.empty() && str.back() == '\r') {
+        str.pop_back();
+    }
+    return in;
+}
+
+// The old sources aren't warning clean under the flags for the tests, and they're kept as they were.
+#if defined(_MSC_VER)
+#pragma warning(push, 0)
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wunknown-warning-option"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#pragma GCC diagnostic ignored "-Wignored-qualifiers"
+#pragma GCC diagnostic ignored "-Wrange-loop-construct"
+#pragma GCC diagnostic ignored "-Wrange-loop-analysis"
+#endif
+#include "../src/deadcode/Board.cpp"
+#include "../src/deadcode/Tile.cpp"
+#include "../src/deadcode/TileButton.cpp"
+#include "../src/deadcode/TileGate.cpp"
+#include "../src/deadcode/TileLED.cpp"
+#include "../src/deadcode/TileSwitch.cpp"
+#include "../src/deadcode/TileWire.cpp"
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#else
+#pragma GCC diagnostic pop
+#endif
+
+// The parts of the old app used by the board and tiles, messages are dropped and conflicts don't pause anything.
+const Simulator::Configuration& Simulator::getConfig() {
+    static Configuration config;
+    config.pauseOnConflict = false;
+    return config;
+}
+
+void UserInterface::pushMessage(const string& /*s*/, bool /*isError*/) {
+}
+
+}
+
+struct LegacySimulator::Impl {
+    Impl() :
+        board() {
+    }
+
+    legacy::Board board;
+};
+
+LegacySimulator::LegacySimulator(const std::string& fontFilename) :
+    impl_() {
+
+    legacy::Board::loadFont(fontFilename);
+    legacy::Tile::currentUpdateTime = 1;
+    impl_ = details::make_unique<Impl>();
+}
+
+LegacySimulator::~LegacySimulator() = default;
+
+void LegacySimulator::loadFile(const std::string& filename) {
+    impl_->board.loadFile(filename);
+}
+
+unsigned int LegacySimulator::getWidth() const {
+    return impl_->board.getSize().x;
+}
+
+unsigned int LegacySimulator::getHeight() const {
+    return impl_->board.getSize().y;
+}
+
+bool LegacySimulator::getExtraLogicStates() const {
+    return legacy::Board::enableExtraLogicStates;
+}
+
+std::vector<char> LegacySimulator::getKeycodes() const {
+    std::vector<char> keycodes;
+    for (const auto& keybind : impl_->board.switchKeybinds) {
+        if (!keybind.second.empty()) {
+            keycodes.push_back(keybind.first);
+        }
+    }
+    for (const auto& keybind : impl_->board.buttonKeybinds) {
+        if (!keybind.second.empty()) {
+            keycodes.push_back(keybind.first);
+        }
+    }
+    std::sort(keycodes.begin(), keycodes.end());
+    keycodes.erase(std::unique(keycodes.begin(), keycodes.end()), keycodes.end());
+    return keycodes;
+}
+
+void LegacySimulator::pressKey(char keycode) {
+    // Same as the handling for text entered in `legacy::Simulator::processEvents()`.
+    auto switches = impl_->board.switchKeybinds.find(keycode);
+    if (switches != impl_->board.switchKeybinds.end()) {
+        for (legacy::TileSwitch* switchPtr : switches->second) {
+            switchPtr->setState(switchPtr->getState() == legacy::LOW ? legacy::HIGH : legacy::LOW);
+        }
+    }
+    auto buttons = impl_->board.buttonKeybinds.find(keycode);
+    if (buttons != impl_->board.buttonKeybinds.end()) {
+        for (legacy::TileButton* buttonPtr : buttons->second) {
+            buttonPtr->setState(buttonPtr->getState() == legacy::LOW ? legacy::HIGH : legacy::LOW);
+        }
+    }
+}
+
+void LegacySimulator::tick() {
+    impl_->board.updateTiles();
+    legacy::Board::numStateErrors = 0;
+}
+
+int LegacySimulator::getState(unsigned int x, unsigned int y) const {
+    return static_cast<int>(impl_->board.getTile(sf::Vector2u(x, y))->getState());
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The simulation from the original version of CircuitSim2 (in src/deadcode),
+ * used as a reference to check the current `Simulator` against.
+ *
+ * The old sources are compiled into their own namespace in
+ * LegacySimulator.cpp, since their class names overlap with the current ones.
+ * Only the board and tiles are used, the window and interface are left out.
+ * The old board keeps some state in static members, so only one instance
+ * should be used at a time.
+ */
+class LegacySimulator {
+public:
+    // The font is only used for the labels on inputs, but the old board needs one loaded.
+    LegacySimulator(const std::string& fontFilename);
+    ~LegacySimulator();
+    LegacySimulator(const LegacySimulator& rhs) = delete;
+    LegacySimulator& operator=(const LegacySimulator& rhs) = delete;
+
+    // Throws `std::runtime_error` if the file can't be loaded.
+    void loadFile(const std::string& filename);
+    unsigned int getWidth() const;
+    unsigned int getHeight() const;
+    bool getExtraLogicStates() const;
+    // Keycodes with at least one switch or button bound to them, in sorted order.
+    std::vector<char> getKeycodes() const;
+    // Toggles the switches and buttons with the keycode, the same as a key press in the old app.
+    void pressKey(char keycode);
+    void tick();
+    // Returns the state of the tile as a `State::t` value.
+    int getState(unsigned int x, unsigned int y) const;
+
+private:
+    struct Impl;
+
+    std::unique_ptr<Impl> impl_;
+};
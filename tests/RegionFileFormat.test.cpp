@@ -456,7 +456,8 @@ TEST_CASE("Randomly allocate and free", "[RegionFileFormat]") {
 
 /**
  * Event listener to hook into Catch's test run setup and teardown. This
- * provides the service locator for SFML resources used in the below tests.
+ * provides the service locator for SFML resources and sets up the debug screen
+ * that boards need, for all of the tests in this executable.
  */
 struct TestRunListener : public Catch::TestEventListenerBase {
     using TestEventListenerBase::TestEventListenerBase;
@@ -464,6 +465,7 @@ struct TestRunListener : public Catch::TestEventListenerBase {
     virtual void testRunStarting(const Catch::TestRunInfo& /*testRunInfo*/) override {
         spdlog::info("testRunStarting: providing ResourceNull instance to resource locator.");
         Locator::provide(details::make_unique<ResourceNull>());
+        DebugScreen::init(Locator::getResource()->getFont("sample_font"), 16, {800, 600});
     }
 
     virtual void testRunEnded(const Catch::TestRunStats& /*testRunStats*/) override {
@@ -531,8 +533,6 @@ TEST_CASE("Test save/load chunks", "[.][RegionFileFormat]") {
     spdlog::set_level(spdlog::level::debug);
     fs::path tempDir = details::fs_mktemp(true, fs::absolute("RegionFileFormat.test.XXX"));
 
-    DebugScreen::init(Locator::getResource()->getFont("sample_font"), 16, {800, 600});
-
     {
         fs::path singleTile = tempDir / "singleTile/board.txt";
         Board b1;
@@ -632,6 +632,36 @@ TEST_CASE("Test save/load chunks", "[.][RegionFileFormat]") {
     board.saveAsFile(tempDir / "test1");*/
 }
 
+TEST_CASE("Save writes swapped chunks without loading them", "[RegionFileFormat]") {
+    fs::path tempDir = details::fs_mktemp(true, fs::absolute("RegionFileFormat.test.XXX"));
+    const fs::path filename = tempDir / "swapped/board.txt";
+    const ChunkCoords::repr swappedCoords = ChunkCoords::pack(1, 0);
+
+    Board b1;
+    b1.newBoard({0, 0});
+    b1.accessTile(0, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east, State::high);
+    b1.accessTile(Chunk::WIDTH, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east, State::low);
+    REQUIRE(b1.saveAsFile(filename));
+
+    // Edit both chunks, then unload one of them so that its changes go to the swap file.
+    b1.accessTile(1, 0).setType(tiles::Gate::instance(), TileId::gateAnd, Direction::east);
+    b1.accessTile(Chunk::WIDTH + 1, 0).setType(tiles::Gate::instance(), TileId::gateOr, Direction::west);
+    b1.accessTile(Chunk::WIDTH, Chunk::WIDTH * 2).setType(tiles::Led::instance(), State::high);
+    REQUIRE(b1.unloadChunk(swappedCoords));
+    REQUIRE(b1.unloadChunk(ChunkCoords::pack(1, 2)));
+    REQUIRE(b1.saveToFile());
+    CHECK(b1.findLoadedChunk(swappedCoords) == nullptr);
+    CHECK(b1.findLoadedChunk(ChunkCoords::pack(1, 2)) == nullptr);
+
+    Board b2;
+    REQUIRE(b2.loadFromFile(filename));
+    REQUIRE_NOTHROW(assertBoardsEqual(b1, b2));
+    CHECK(b2.accessTile(Chunk::WIDTH + 1, 0).getId() == TileId::gateOr);
+    CHECK(b2.accessTile(Chunk::WIDTH, Chunk::WIDTH * 2).getId() == TileId::outLed);
+
+    fs::remove_all(tempDir);
+}
+
 /**
  * add some file test cases?
  * failing case:
@@ -0,0 +1,1530 @@
+#include <Board.h>
+#include <commands/RotateTiles.h>
+#include <sim/SimThread.h>
+#include <sim/TileLogic.h>
+#include <sim/TimingWheel.h>
+#include <sim/TripleBuffer.h>
+#include <sim/WaveformRecorder.h>
+#include <Simulator.h>
+#include <Tile.h>
+#include <tiles/Blank.h>
+#include <tiles/Gate.h>
+#include <tiles/Input.h>
+#include <tiles/Led.h>
+#include <tiles/Wire.h>
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+State::t getState2(Board& board, int x, int y) {
+    return board.accessTile(x, y).getRawData().state2;
+}
+
+// Gate rules written out the same way as the legacy simulator, to check the truth table against.
+State::t referenceGateState(TileId::t id, Direction::t dir, const State::t adjacent[4], bool extraLogicStates) {
+    int numInputs = 0, numHigh = 0, numMiddle = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (i != dir && adjacent[i] != State::disconnected) {
+            ++numInputs;
+            numHigh += (adjacent[i] == State::high);
+            numMiddle += (adjacent[i] == State::middle && extraLogicStates);
+        }
+    }
+    const bool invert = (id == TileId::gateNot || id == TileId::gateNand || id == TileId::gateNor || id == TileId::gateXnor);
+    State::t state = State::low;
+    if (id == TileId::gateDiode || id == TileId::gateBuffer || id == TileId::gateNot) {
+        if (numInputs == 1) {
+            state = (numHigh == 1 ? State::high : (numMiddle == 1 ? State::middle : State::low));
+        } else if (numInputs == 2 && extraLogicStates && id != TileId::gateDiode && adjacent[(dir + 2) % 4] != State::disconnected) {
+            State::t control = adjacent[(dir + 1) % 4];
+            if (control == State::disconnected) {
+                control = adjacent[(dir + 3) % 4];
+            }
+            state = (control == State::high ? adjacent[(dir + 2) % 4] : State::middle);
+        }
+    } else if (numInputs >= 2) {
+        if (id == TileId::gateAnd || id == TileId::gateNand) {
+            state = (numHigh == numInputs ? State::high : (numHigh + numMiddle == numInputs ? State::middle : State::low));
+        } else if (id == TileId::gateOr || id == TileId::gateNor) {
+            state = (numHigh >= 1 ? State::high : (numMiddle >= 1 ? State::middle : State::low));
+        } else {
+            state = (numMiddle != 0 ? State::middle : (numHigh % 2 == 1 ? State::high : State::low));
+        }
+    }
+    return (invert ? sim::complementState(state) : state);
+}
+
+}
+
+TEST_CASE("Gate truth table matches the gate rules", "[Simulator]") {
+    int numMismatches = 0;
+    for (int id = TileId::gateDiode; id <= TileId::gateXnor; ++id) {
+        for (int dir = 0; dir < 4; ++dir) {
+            for (unsigned int combination = 0; combination < 256; ++combination) {
+                State::t adjacent[4];
+                for (int i = 0; i < 4; ++i) {
+                    adjacent[i] = static_cast<State::t>((combination >> (i * 2)) & 0x3);
+                }
+                for (int extraLogicStates = 0; extraLogicStates < 2; ++extraLogicStates) {
+                    const State::t expected = referenceGateState(static_cast<TileId::t>(id), static_cast<Direction::t>(dir), adjacent, extraLogicStates != 0);
+                    if (sim::evaluateGate(static_cast<TileId::t>(id), static_cast<Direction::t>(dir), adjacent, extraLogicStates != 0) != expected) {
+                        ++numMismatches;
+                    }
+                }
+            }
+        }
+    }
+    CHECK(numMismatches == 0);
+    const State::t allHigh[4] = {State::high, State::high, State::high, State::high};
+    CHECK(sim::evaluateGate(TileId::wireStraight, Direction::north, allHigh, false) == State::disconnected);
+}
+
+TEST_CASE("Switch drives wire and LED", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(2, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    board.accessTile(2, 2).setType(tiles::Led::instance());
+    board.accessTile(3, 2).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+    CHECK(board.accessTile(2, 0).getState() == State::high);
+    CHECK(board.accessTile(2, 1).getState() == State::high);
+    CHECK(board.accessTile(2, 2).getState() == State::high);
+    CHECK(board.accessTile(3, 2).getState() == State::high);
+    CHECK(simulator.getTickCount() == 1);
+
+    board.accessTile(0, 0).setState(State::low);
+    simulator.addUpdate(0, 0);
+    simulator.tick();
+    CHECK(board.accessTile(2, 1).getState() == State::low);
+    CHECK(board.accessTile(3, 2).getState() == State::low);
+    CHECK_FALSE(simulator.hasPendingUpdates());
+}
+
+TEST_CASE("Gates update one tick after their inputs", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(3, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    CHECK(board.accessTile(2, 0).getState() == State::high);
+    CHECK(board.accessTile(3, 0).getState() == State::high);
+
+    board.accessTile(0, 0).setState(State::high);
+    simulator.addUpdate(0, 0);
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+    CHECK(board.accessTile(2, 0).getState() == State::high);
+    REQUIRE(simulator.hasPendingUpdates());
+    simulator.tick();
+    CHECK(board.accessTile(2, 0).getState() == State::low);
+    CHECK(board.accessTile(3, 0).getState() == State::low);
+    simulator.tick();
+    CHECK_FALSE(simulator.hasPendingUpdates());
+}
+
+TEST_CASE("Wires cross chunk boundaries and crossovers", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(Chunk::WIDTH - 2, 5).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+    for (int x = Chunk::WIDTH - 1; x < Chunk::WIDTH + 4; ++x) {
+        board.accessTile(x, 5).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    board.accessTile(Chunk::WIDTH + 1, 5).setType(tiles::Wire::instance(), TileId::wireCrossover);
+    board.accessTile(Chunk::WIDTH + 1, 4).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north, State::high);
+    board.accessTile(Chunk::WIDTH + 1, 6).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north, State::high);
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    CHECK(board.accessTile(Chunk::WIDTH - 1, 5).getState() == State::high);
+    CHECK(board.accessTile(Chunk::WIDTH + 3, 5).getState() == State::high);
+    CHECK(board.accessTile(Chunk::WIDTH + 1, 5).getState() == State::low);
+    CHECK(getState2(board, Chunk::WIDTH + 1, 5) == State::high);
+    CHECK(board.accessTile(Chunk::WIDTH + 1, 4).getState() == State::low);
+    CHECK(board.accessTile(Chunk::WIDTH + 1, 6).getState() == State::low);
+
+    // Wires traverse into chunks that are created after the simulator is reset.
+    board.accessTile(Chunk::WIDTH + 3, Chunk::WIDTH).setType(tiles::Led::instance());
+    board.notifyTileChanged({Chunk::WIDTH + 3, Chunk::WIDTH}, TileChange::structure);
+    for (int y = 6; y < Chunk::WIDTH; ++y) {
+        board.accessTile(Chunk::WIDTH + 3, y).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+        board.notifyTileChanged({Chunk::WIDTH + 3, y}, TileChange::structure);
+    }
+    board.accessTile(Chunk::WIDTH + 3, 5).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.notifyTileChanged({Chunk::WIDTH + 3, 5}, TileChange::structure);
+    simulator.tick();
+    CHECK(board.accessTile(Chunk::WIDTH + 3, Chunk::WIDTH - 1).getState() == State::high);
+    CHECK(board.accessTile(Chunk::WIDTH + 3, Chunk::WIDTH).getState() == State::high);
+}
+
+TEST_CASE("Driver conflicts with extra logic states", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+
+    Simulator simulator(board);
+    SECTION("Basic states") {
+        simulator.reset();
+        simulator.tick();
+        CHECK(board.accessTile(1, 0).getState() == State::high);
+    }
+    SECTION("Extra states") {
+        board.setExtraLogicStates(true);
+        simulator.reset();
+        simulator.tick();
+        CHECK(board.accessTile(1, 0).getState() == State::middle);
+    }
+}
+
+TEST_CASE("Buttons release after one tick", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inButton, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    board.accessTile(0, 0).setState(State::high);
+    simulator.addUpdate(0, 0);
+    simulator.tick();
+    CHECK(board.accessTile(0, 0).getState() == State::low);
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::low);
+}
+
+TEST_CASE("Cached nets are rebuilt after edits", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x < 40; ++x) {
+        board.accessTile(x, 0).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+    }
+    board.accessTile(39, 1).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    CHECK(board.accessTile(39, 0).getState() == State::low);
+
+    board.accessTile(0, 0).setState(State::high);
+    simulator.addUpdate(0, 0);
+    simulator.tick();
+    CHECK(board.accessTile(39, 0).getState() == State::high);
+    CHECK(board.accessTile(39, 1).getState() == State::high);
+
+    // Split the wire, the far side no longer has a driver.
+    board.accessTile(20, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    board.notifyTileChanged({20, 0}, TileChange::structure);
+    simulator.tick();
+    CHECK(board.accessTile(19, 0).getState() == State::high);
+    CHECK(board.accessTile(21, 0).getState() == State::low);
+    CHECK(board.accessTile(39, 1).getState() == State::low);
+
+    // Add a new driver to the far side.
+    board.accessTile(40, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'b');
+    board.notifyTileChanged({40, 0}, TileChange::structure);
+    simulator.tick();
+    CHECK(board.accessTile(21, 0).getState() == State::high);
+    CHECK(board.accessTile(39, 1).getState() == State::high);
+
+    // Join the wire again, the nets merge and the conflicting drivers settle on high.
+    board.accessTile(0, 0).setState(State::low);
+    simulator.addUpdate(0, 0);
+    board.accessTile(20, 0).setType(tiles::Wire::instance(), TileId::wireJunction);
+    board.notifyTileChanged({20, 0}, TileChange::structure);
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+    CHECK(board.accessTile(20, 0).getState() == State::high);
+    CHECK(board.accessTile(39, 0).getState() == State::high);
+}
+
+TEST_CASE("Commands notify the simulator of edits", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Gate::instance(), TileId::gateBuffer, Direction::west);
+    board.accessTile(3, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    simulator.tick();
+    CHECK(board.accessTile(2, 0).getState() == State::low);
+    CHECK(board.accessTile(3, 0).getState() == State::low);
+
+    // Turn the buffer around so that it reads from the switch.
+    commands::RotateTiles rotate(board, true, false);
+    rotate.pushBackTile({2, 0});
+    rotate.pushBackTile({2, 0});
+    rotate.execute();
+    simulator.tick();
+    simulator.tick();
+    CHECK(board.accessTile(2, 0).getDirection() == Direction::east);
+    CHECK(board.accessTile(2, 0).getState() == State::high);
+    CHECK(board.accessTile(3, 0).getState() == State::high);
+
+    rotate.undo();
+    simulator.tick();
+    simulator.tick();
+    CHECK(board.accessTile(3, 0).getState() == State::low);
+}
+
+TEST_CASE("Stitched nets match following each wire", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A wire along the edge between two rows of chunks, with branches crossing back and forth.
+    board.accessTile(-1, Chunk::WIDTH - 1).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 0; x < Chunk::WIDTH * 3; ++x) {
+        board.accessTile(x, Chunk::WIDTH - 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    for (int x = 4; x < Chunk::WIDTH * 3; x += 8) {
+        board.accessTile(x, Chunk::WIDTH - 1).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+        board.accessTile(x, Chunk::WIDTH).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+        board.accessTile(x, Chunk::WIDTH + 1).setType(tiles::Led::instance());
+    }
+    board.accessTile(Chunk::WIDTH, Chunk::WIDTH - 1).setType(tiles::Wire::instance(), TileId::wireCrossover);
+    board.accessTile(Chunk::WIDTH, Chunk::WIDTH - 2).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'b');
+    board.accessTile(Chunk::WIDTH, Chunk::WIDTH).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    board.accessTile(Chunk::WIDTH * 3, Chunk::WIDTH - 1).setType(tiles::Gate::instance(), TileId::gateBuffer, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    CHECK(simulator.getStitchedNets());
+    bool stitchedNets = false;
+    SECTION("Stitched") {
+        stitchedNets = true;
+    }
+    SECTION("Followed") {
+        stitchedNets = false;
+    }
+    simulator.setStitchedNets(stitchedNets);
+    simulator.tick();
+    CHECK(board.accessTile(Chunk::WIDTH * 3 - 1, Chunk::WIDTH - 1).getState() == State::low);
+    CHECK(board.accessTile(Chunk::WIDTH, Chunk::WIDTH).getState() == State::high);
+
+    board.accessTile(-1, Chunk::WIDTH - 1).setState(State::high);
+    simulator.addUpdate(-1, Chunk::WIDTH - 1);
+    simulator.tick();
+    CHECK(board.accessTile(0, Chunk::WIDTH - 1).getState() == State::high);
+    CHECK(getState2(board, Chunk::WIDTH, Chunk::WIDTH - 1) == State::high);
+    CHECK(board.accessTile(Chunk::WIDTH * 3 - 1, Chunk::WIDTH - 1).getState() == State::high);
+    for (int x = 4; x < Chunk::WIDTH * 3; x += 8) {
+        CHECK(board.accessTile(x, Chunk::WIDTH + 1).getState() == State::high);
+    }
+    simulator.tick();
+    CHECK(board.accessTile(Chunk::WIDTH * 3, Chunk::WIDTH - 1).getState() == State::high);
+
+    // Cut the wire in the middle chunk, only that chunk needs to be summarized again.
+    board.accessTile(Chunk::WIDTH + 10, Chunk::WIDTH - 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::north);
+    board.notifyTileChanged({Chunk::WIDTH + 10, Chunk::WIDTH - 1}, TileChange::structure);
+    simulator.tick();
+    CHECK(board.accessTile(Chunk::WIDTH + 4, Chunk::WIDTH + 1).getState() == State::high);
+    CHECK(board.accessTile(Chunk::WIDTH + 12, Chunk::WIDTH + 1).getState() == State::low);
+    CHECK(board.accessTile(Chunk::WIDTH * 3 - 1, Chunk::WIDTH - 1).getState() == State::low);
+    simulator.tick();
+    CHECK(board.accessTile(Chunk::WIDTH * 3, Chunk::WIDTH - 1).getState() == State::low);
+}
+
+TEST_CASE("Edited nets match following the wires again", "[Simulator]") {
+    // The same random edits go to two boards, one simulator keeps its nets up to date and the other one starts over
+    // after each edit. The area is big enough for the nets to have many fragments.
+    const int width = Chunk::WIDTH * 2 + 8, height = Chunk::WIDTH + 8;
+    std::mt19937 rng(1234);
+    auto randomTile = [&rng](Board& board, int x, int y, int kind, int dir, bool high) {
+        Tile tile = board.accessTile(x, y);
+        if (kind < 8) {
+            tile.setType(tiles::Wire::instance(), TileId::wireJunction);
+        } else if (kind < 10) {
+            tile.setType(tiles::Wire::instance(), TileId::wireCrossover);
+        } else if (kind < 12) {
+            tile.setType(tiles::Wire::instance(), TileId::wireStraight, static_cast<Direction::t>(dir));
+        } else if (kind < 14) {
+            tile.setType(tiles::Wire::instance(), TileId::wireTee, static_cast<Direction::t>(dir));
+        } else if (kind < 16) {
+            tile.setType(tiles::Blank::instance());
+        } else if (kind < 17) {
+            tile.setType(tiles::Input::instance(), TileId::inSwitch, (high ? State::high : State::low), 'a');
+        } else {
+            tile.setType(tiles::Led::instance());
+        }
+    };
+    std::uniform_int_distribution<int> kindDist(0, 17), dirDist(0, 3), xDist(0, width - 1), yDist(0, height - 1);
+    Board board, rebuiltBoard;
+    board.newBoard({0, 0});
+    rebuiltBoard.newBoard({0, 0});
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const int kind = kindDist(rng), dir = dirDist(rng);
+            const bool high = (rng() % 2 == 0);
+            randomTile(board, x, y, kind, dir, high);
+            randomTile(rebuiltBoard, x, y, kind, dir, high);
+        }
+    }
+
+    bool stitchedNets = false;
+    SECTION("Stitched") {
+        stitchedNets = true;
+    }
+    SECTION("Followed") {
+        stitchedNets = false;
+    }
+    Simulator simulator(board), rebuiltSimulator(rebuiltBoard);
+    simulator.reset();
+    simulator.setStitchedNets(stitchedNets);
+    simulator.tick();
+    for (int i = 0; i < 300; ++i) {
+        const int x = xDist(rng), y = yDist(rng), kind = kindDist(rng), dir = dirDist(rng);
+        const bool high = (rng() % 2 == 0);
+        randomTile(board, x, y, kind, dir, high);
+        board.notifyTileChanged({x, y}, TileChange::structure);
+        randomTile(rebuiltBoard, x, y, kind, dir, high);
+        simulator.tick();
+        simulator.tick();
+        if (i % 10 != 9) {
+            continue;
+        }
+        rebuiltSimulator.reset();
+        rebuiltSimulator.setStitchedNets(stitchedNets);
+        rebuiltSimulator.tick();
+        rebuiltSimulator.tick();
+        int mismatches = 0;
+        for (int y2 = 0; y2 < height; ++y2) {
+            for (int x2 = 0; x2 < width; ++x2) {
+                const TileData tileData = board.accessTile(x2, y2).getRawData();
+                const TileData rebuiltData = rebuiltBoard.accessTile(x2, y2).getRawData();
+                mismatches += (tileData.state1 != rebuiltData.state1 || tileData.state2 != rebuiltData.state2);
+            }
+        }
+        INFO("After edit " << i);
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("Multithreaded ticks match a single thread", "[Simulator]") {
+    // Rows of inverters spanning a few chunks, with every fourth row looped back on itself to oscillate.
+    auto buildBoard = [](Board& board) {
+        board.newBoard({0, 0});
+        for (int y = 0; y < Chunk::WIDTH * 2; y += 2) {
+            board.accessTile(-1, y).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+            for (int x = 0; x < Chunk::WIDTH * 3; x += 3) {
+                board.accessTile(x, y).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+                board.accessTile(x + 1, y).setType(tiles::Gate::instance(), (x % 2 == 0 ? TileId::gateNot : TileId::gateBuffer), Direction::east);
+                board.accessTile(x + 2, y).setType(tiles::Wire::instance(), TileId::wireTee, Direction::east);
+                board.accessTile(x + 2, y + 1).setType(tiles::Led::instance());
+            }
+            if (y % 8 == 0) {
+                const int endX = Chunk::WIDTH * 3;
+                board.accessTile(endX, y).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+                board.accessTile(endX, y - 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+                for (int x = 1; x < endX; ++x) {
+                    board.accessTile(x, y - 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+                }
+                board.accessTile(0, y - 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+                board.accessTile(0, y).setType(tiles::Wire::instance(), TileId::wireTee, Direction::north);
+            }
+        }
+    };
+    Board board1, board2;
+    buildBoard(board1);
+    buildBoard(board2);
+    Simulator simulator1(board1), simulator2(board2);
+    simulator1.reset();
+    simulator2.reset();
+    simulator2.setThreadCount(4);
+    CHECK(simulator2.getThreadCount() == 4);
+
+    auto boardsMatch = [&]() {
+        for (const auto& chunk : board1.getLoadedChunks()) {
+            auto chunk2 = board2.getLoadedChunks().find(chunk.first);
+            if (chunk2 == board2.getLoadedChunks().end() || !(chunk.second == chunk2->second)) {
+                return false;
+            }
+        }
+        return board1.getLoadedChunks().size() == board2.getLoadedChunks().size();
+    };
+    for (int i = 0; i < 50; ++i) {
+        if (i == 10) {
+            for (int y = 0; y < Chunk::WIDTH * 2; y += 6) {
+                board1.accessTile(-1, y).setState(State::high);
+                simulator1.addUpdate(-1, y);
+                board2.accessTile(-1, y).setState(State::high);
+                simulator2.addUpdate(-1, y);
+            }
+        }
+        simulator1.tick();
+        simulator2.tick();
+        REQUIRE(simulator1.getPendingUpdateCount() == simulator2.getPendingUpdateCount());
+        REQUIRE(boardsMatch());
+    }
+    CHECK(simulator1.hasPendingUpdates());
+}
+
+TEST_CASE("Warp matches single ticks", "[Simulator]") {
+    // A ring oscillator (never stable) next to a chain of inverters that settles.
+    auto buildBoard = [](Board& board) {
+        board.newBoard({0, 0});
+        board.accessTile(0, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+        board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+        board.accessTile(1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+        board.accessTile(0, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+        board.accessTile(-1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+        board.accessTile(-1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+        board.accessTile(0, 4).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+        for (int x = 1; x < Chunk::WIDTH + 8; x += 2) {
+            board.accessTile(x, 4).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+            board.accessTile(x + 1, 4).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+        }
+    };
+    Board board1, board2;
+    buildBoard(board1);
+    buildBoard(board2);
+    Simulator simulator1(board1), simulator2(board2);
+    simulator1.reset();
+    simulator2.reset();
+
+    for (int i = 0; i < 37; ++i) {
+        simulator1.tick();
+    }
+    simulator2.warp(37);
+    CHECK(simulator2.getTickCount() == 37);
+    CHECK(simulator2.hasPendingUpdates());
+    CHECK(simulator1.getPendingUpdateCount() == simulator2.getPendingUpdateCount());
+    for (const auto& chunk : board1.getLoadedChunks()) {
+        auto chunk2 = board2.getLoadedChunks().find(chunk.first);
+        REQUIRE(chunk2 != board2.getLoadedChunks().end());
+        CHECK(chunk.second == chunk2->second);
+    }
+
+    SECTION("Warp skips ticks once stable") {
+        board2.accessTile(0, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+        board2.notifyTileChanged({0, 0}, TileChange::structure);
+        simulator2.warp(1000000);
+        CHECK(simulator2.getTickCount() == 37 + 1000000);
+        CHECK_FALSE(simulator2.hasPendingUpdates());
+    }
+}
+
+TEST_CASE("Settle stops when stable or oscillating", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A chain of inverters across two chunks that settles.
+    board.accessTile(0, 4).setType(tiles::Input::instance(), TileId::inSwitch, State::high, 'a');
+    for (int x = 1; x < Chunk::WIDTH + 8; x += 2) {
+        board.accessTile(x, 4).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+        board.accessTile(x + 1, 4).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+
+    Simulator simulator(board);
+    simulator.reset();
+    auto result = simulator.settle(1000);
+    CHECK(result.stable);
+    CHECK(result.period == 0);
+    CHECK(result.cycleChunks.empty());
+    CHECK(result.ticks == simulator.getTickCount());
+    CHECK(board.accessTile(Chunk::WIDTH + 8, 4).getState() == State::high);
+
+    SECTION("Ring oscillator") {
+        board.accessTile(0, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+        board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+        board.accessTile(1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+        board.accessTile(0, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+        board.accessTile(-1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+        board.accessTile(-1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+        for (auto pos : {sf::Vector2i(0, 0), sf::Vector2i(1, 0), sf::Vector2i(1, 1), sf::Vector2i(0, 1), sf::Vector2i(-1, 1), sf::Vector2i(-1, 0)}) {
+            board.notifyTileChanged(pos, TileChange::structure);
+        }
+        // Toggle the chain too, it settles again while the ring keeps going.
+        board.accessTile(0, 4).setState(State::low);
+        simulator.addUpdate(0, 4);
+
+        result = simulator.settle(1000);
+        CHECK_FALSE(result.stable);
+        CHECK(result.period == 2);
+        CHECK(result.ticks < 1000);
+        CHECK(result.cycleChunks == std::vector<ChunkCoords::repr>{ChunkCoords::pack(-1, 0), ChunkCoords::pack(0, 0)});
+        CHECK(board.accessTile(Chunk::WIDTH + 8, 4).getState() == State::low);
+    }
+    SECTION("Scheduled update") {
+        // The quiet ticks while waiting on the update aren't a cycle.
+        board.accessTile(0, 4).setState(State::low);
+        simulator.scheduleUpdate(0, 4, 10);
+        const uint64_t startTick = simulator.getTickCount();
+        result = simulator.settle(100);
+        CHECK(result.stable);
+        CHECK(result.period == 0);
+        CHECK(result.cycleChunks.empty());
+        CHECK(result.ticks == simulator.getTickCount() - startTick);
+        CHECK(board.accessTile(Chunk::WIDTH + 8, 4).getState() == State::low);
+    }
+    SECTION("Tick limit") {
+        board.accessTile(0, 4).setState(State::low);
+        simulator.addUpdate(0, 4);
+        result = simulator.settle(3);
+        CHECK_FALSE(result.stable);
+        CHECK(result.period == 0);
+        CHECK(result.ticks == 3);
+    }
+}
+
+TEST_CASE("Triple buffer hands off the newest value", "[Simulator]") {
+    sim::TripleBuffer<int> buffer;
+    CHECK_FALSE(buffer.consume());
+    buffer.accessBack() = 1;
+    CHECK_FALSE(buffer.publish());
+    CHECK(buffer.consume());
+    CHECK(buffer.accessFront() == 1);
+    CHECK_FALSE(buffer.consume());
+
+    // Publishing twice returns the skipped value to the producer.
+    buffer.accessBack() = 2;
+    CHECK_FALSE(buffer.publish());
+    buffer.accessBack() = 3;
+    CHECK(buffer.publish());
+    CHECK(buffer.accessBack() == 2);
+    CHECK(buffer.consume());
+    CHECK(buffer.accessFront() == 3);
+
+    buffer.accessBack() = 4;
+    buffer.publish();
+    buffer.reset();
+    CHECK_FALSE(buffer.consume());
+    CHECK(buffer.accessFront() == 3);
+}
+
+TEST_CASE("Simulation thread publishes whole ticks", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // Ring oscillator across two chunks.
+    board.accessTile(0, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(0, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(-1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(-1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    sim::SimThread simThread(board, simulator);
+    simThread.start();
+    CHECK(simulator.getDetachedDrawing());
+    simThread.setMaxTps(sim::SimThread::UNLIMITED_TPS);
+
+    // Each snapshot should show the gate and the wire it drives in the same state.
+    int numSnapshots = 0;
+    uint64_t lastSnapshotTick = 0;
+    const auto startTime = std::chrono::steady_clock::now();
+    while (numSnapshots < 5 && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10)) {
+        if (!simThread.consumeSnapshot()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        const auto& snapshot = simThread.getSnapshot();
+        auto chunkIter = std::find(snapshot.chunkCoords.begin(), snapshot.chunkCoords.end(), ChunkCoords::pack(0, 0));
+        REQUIRE(chunkIter != snapshot.chunkCoords.end());
+        const TileData* tiles = &snapshot.tiles[(chunkIter - snapshot.chunkCoords.begin()) * Chunk::WIDTH * Chunk::WIDTH];
+        CHECK(tiles[0].id == TileId::gateNot);
+        CHECK(tiles[0].state1 == tiles[1 + Chunk::WIDTH].state1);
+        CHECK(tiles[0].state1 == (snapshot.tickCount % 2 == 1 ? State::high : State::low));
+        CHECK(snapshot.tickCount > lastSnapshotTick);
+        lastSnapshotTick = snapshot.tickCount;
+        ++numSnapshots;
+    }
+    CHECK(numSnapshots == 5);
+
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread);
+        const uint64_t tickCount = simulator.getTickCount();
+        CHECK(tickCount == simThread.getTickCount());
+        CHECK(tickCount >= lastSnapshotTick);
+        // Ticks can run from here while paused.
+        simulator.tick();
+        CHECK(board.accessTile(0, 0).getState() == board.accessTile(1, 1).getState());
+        CHECK_FALSE(simThread.consumeSnapshot());
+    }
+    CHECK(simThread.getTickCount() > lastSnapshotTick);
+
+    simThread.setMaxTps(0);
+    simThread.stop();
+    CHECK_FALSE(simThread.isRunning());
+    CHECK_FALSE(simulator.getDetachedDrawing());
+    CHECK(board.accessTile(0, 0).getState() == (simulator.getTickCount() % 2 == 1 ? State::high : State::low));
+}
+
+TEST_CASE("Simulation thread runs a warp in slices", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A ring oscillator, so every tick of the warp does some work.
+    board.accessTile(0, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(0, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(-1, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(-1, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    sim::SimThread simThread(board, simulator);
+    simThread.start();
+    auto waitForWarp = [&simThread]() {
+        const auto startTime = std::chrono::steady_clock::now();
+        while (simThread.getWarpTicksLeft() != 0 && std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return simThread.getWarpTicksLeft() == 0;
+    };
+
+    // The warp runs with the max TPS at zero, and a pause can happen in the middle of it.
+    simThread.warp(5000);
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread);
+        CHECK(simulator.getTickCount() % 64 == 0);
+    }
+    REQUIRE(waitForWarp());
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread);
+        CHECK(simulator.getTickCount() == 5000);
+    }
+
+    // A new warp replaces the ticks left, so a warp of zero cancels it.
+    simThread.warp(std::numeric_limits<uint64_t>::max());
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    simThread.warp(0);
+    CHECK(simThread.getWarpTicksLeft() == 0);
+    uint64_t tickCount;
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread);
+        tickCount = simulator.getTickCount();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread);
+        CHECK(simulator.getTickCount() == tickCount);
+    }
+    simThread.stop();
+    CHECK(board.accessTile(0, 0).getState() == (tickCount % 2 == 1 ? State::high : State::low));
+}
+
+TEST_CASE("Timing wheel expires values on their tick", "[Simulator]") {
+    sim::TimingWheel<uint64_t> wheel;
+    const std::vector<uint64_t> delays = {0, 1, 63, 64, 65, 4095, 4096, 300000, (uint64_t(1) << 24) + 5};
+    for (auto delay : delays) {
+        wheel.schedule(delay, delay);
+    }
+    CHECK(wheel.size() == delays.size());
+
+    std::vector<uint64_t> expired;
+    while (!wheel.empty()) {
+        const uint64_t tick = wheel.getCurrentTick();
+        wheel.advance([&expired,tick](uint64_t value) {
+            CHECK(value == tick);
+            expired.push_back(value);
+        });
+    }
+    CHECK(expired == delays);
+    CHECK(wheel.getCurrentTick() == (uint64_t(1) << 24) + 6);
+
+    // Values scheduled while expiring (or in the past) go off in the same call.
+    wheel.schedule(0, 1);
+    int count = 0;
+    wheel.advance([&wheel,&count](uint64_t value) {
+        ++count;
+        if (value == 1) {
+            wheel.schedule(wheel.getCurrentTick(), 2);
+        }
+    });
+    CHECK(count == 2);
+    CHECK(wheel.empty());
+}
+
+TEST_CASE("Scheduled updates run on a later tick", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.tick();
+    REQUIRE_FALSE(simulator.hasPendingUpdates());
+
+    board.accessTile(0, 0).setState(State::high);
+    simulator.scheduleUpdate(0, 0, 3);
+    CHECK(simulator.hasPendingUpdates());
+    CHECK(simulator.getPendingUpdateCount() == 1);
+    simulator.tick();
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::low);
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+
+    // A warp keeps ticking through the wait, then skips ahead once nothing is left.
+    board.accessTile(0, 0).setState(State::low);
+    simulator.scheduleUpdate(0, 0, 100);
+    simulator.warp(1000);
+    CHECK(board.accessTile(1, 0).getState() == State::low);
+    CHECK(simulator.getTickCount() == 1004);
+    CHECK_FALSE(simulator.hasPendingUpdates());
+
+    board.accessTile(0, 0).setState(State::high);
+    simulator.scheduleUpdate(0, 0, 1);
+    simulator.tick();
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+}
+
+TEST_CASE("Quiet chunks go to sleep and wake up", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A switch in one chunk with a wire to an LED in the next chunk.
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x < Chunk::WIDTH + 8; ++x) {
+        board.accessTile(x, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    board.accessTile(Chunk::WIDTH + 8, 0).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.setThreadCount(GENERATE(1u, 4u));
+    simulator.setSleepTicks(64);
+    simulator.reset();
+    REQUIRE(simulator.settle(100).stable);
+    // Saved chunks can also be unloaded from the board while asleep (if the file storage allows it).
+    for (const auto& chunk : board.getLoadedChunks()) {
+        chunk.second.markAsSaved();
+    }
+    CHECK(simulator.getSleepingChunkCount() == 0);
+    simulator.warp(100);
+    CHECK(simulator.getSleepingChunkCount() == 2);
+
+    board.accessTile(0, 0).setState(State::high);
+    simulator.addUpdate(0, 0);
+    REQUIRE(simulator.settle(100).stable);
+    CHECK(simulator.getSleepingChunkCount() == 0);
+    CHECK(board.accessTile(Chunk::WIDTH + 8, 0).getState() == State::high);
+
+    // Chunks that wake up stay awake longer the next time.
+    simulator.warp(100);
+    CHECK(simulator.getSleepingChunkCount() == 0);
+    simulator.warp(100);
+    CHECK(simulator.getSleepingChunkCount() == 2);
+    board.accessTile(0, 0).setState(State::low);
+    simulator.addUpdate(0, 0);
+    REQUIRE(simulator.settle(100).stable);
+    CHECK(board.accessTile(Chunk::WIDTH + 8, 0).getState() == State::low);
+}
+
+TEST_CASE("Sleeping chunks unload once they can", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x < Chunk::WIDTH; ++x) {
+        board.accessTile(x, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    board.accessTile(Chunk::WIDTH, 0).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.setSleepTicks(64);
+    simulator.reset();
+    REQUIRE(simulator.settle(100).stable);
+    for (const auto& chunk : board.getLoadedChunks()) {
+        chunk.second.markAsSaved();
+    }
+
+    // With detached drawing the chunks go to sleep, but only unload when asked to.
+    simulator.setDetachedDrawing(true);
+    simulator.warp(100);
+    CHECK(simulator.getSleepingChunkCount() == 2);
+    CHECK(simulator.getResidentChunkCount() == 2);
+    CHECK(simulator.hasChunksToUnload());
+    simulator.flushDrawDirty();
+    simulator.unloadSleepingChunks();
+    CHECK(simulator.getResidentChunkCount() == 0);
+    CHECK_FALSE(simulator.hasChunksToUnload());
+    simulator.setDetachedDrawing(false);
+
+    // Taking checkpoints loads the chunks once, after that they can sleep and unload again.
+    simulator.setCheckpointInterval(50);
+    CHECK(simulator.getResidentChunkCount() == 2);
+    simulator.warp(200);
+    CHECK(simulator.getSleepingChunkCount() == 2);
+    CHECK(simulator.getResidentChunkCount() == 0);
+
+    const uint64_t pressTick = simulator.getTickCount();
+    simulator.pressKey('a');
+    REQUIRE(simulator.settle(100).stable);
+    CHECK(board.accessTile(Chunk::WIDTH, 0).getState() == State::high);
+    for (const auto& chunk : board.getLoadedChunks()) {
+        chunk.second.markAsSaved();
+    }
+    // The chunks woke up twice, so they take longer to go back to sleep.
+    simulator.warp(400);
+    CHECK(simulator.getResidentChunkCount() == 0);
+
+    // The checkpoints taken while the chunks were unloaded still have their tiles.
+    REQUIRE(simulator.rewind(simulator.getTickCount() - pressTick + 1));
+    CHECK(board.accessTile(0, 0).getState() == State::low);
+    CHECK(board.accessTile(Chunk::WIDTH, 0).getState() == State::low);
+}
+
+TEST_CASE("Sleeping chunks unload while the simulation thread runs", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x < Chunk::WIDTH; ++x) {
+        board.accessTile(x, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    board.accessTile(Chunk::WIDTH, 0).setType(tiles::Led::instance());
+    // A ring oscillator further down keeps the thread ticking.
+    const int ringY = Chunk::WIDTH * 4;
+    board.accessTile(1, ringY).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(2, ringY).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(2, ringY + 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(1, ringY + 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(0, ringY + 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(0, ringY).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+
+    Simulator simulator(board);
+    simulator.setSleepTicks(64);
+    simulator.reset();
+    simulator.warp(10);
+    for (const auto& chunk : board.getLoadedChunks()) {
+        chunk.second.markAsSaved();
+    }
+    sim::SimThread simThread(board, simulator);
+    simThread.start();
+    simThread.setMaxTps(sim::SimThread::UNLIMITED_TPS);
+
+    // The frame loop unloads the chunks once they go to sleep.
+    auto runFramesUntil = [&simThread](const std::function<bool()>& done) {
+        const auto startTime = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - startTime < std::chrono::seconds(10)) {
+            simThread.updateChunks();
+            sim::SimThread::PauseGuard pauseGuard(simThread);
+            if (done()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    CHECK(runFramesUntil([&simulator]() { return simulator.getResidentChunkCount() == 1; }));
+
+    // The press loads the chunk with the switch, and the thread waits on the frame loop to load the one with the LED.
+    {
+        sim::SimThread::PauseGuard pauseGuard(simThread);
+        simulator.pressKey('a');
+    }
+    CHECK(runFramesUntil([&simulator]() { return simulator.getResidentChunkCount() == 3; }));
+    simThread.stop();
+    simulator.warp(10);
+    CHECK(board.accessTile(Chunk::WIDTH, 0).getState() == State::high);
+}
+
+TEST_CASE("Rewind restores an earlier tick", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A ring oscillator in the first chunk.
+    board.accessTile(10, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(11, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(11, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(10, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(9, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(9, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+    // A switch with a chain of not gates to an LED in the next chunk, the switch gets turned on by a timed update.
+    board.accessTile(Chunk::WIDTH, 5).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x <= 5; ++x) {
+        board.accessTile(Chunk::WIDTH + x, 5).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    }
+    board.accessTile(Chunk::WIDTH + 6, 5).setType(tiles::Led::instance());
+    auto getStates = [&board]() {
+        std::vector<int> states;
+        for (int y = 0; y < 8; ++y) {
+            for (int x = 0; x < Chunk::WIDTH * 2; ++x) {
+                const TileData tileData = board.accessTile(x, y).getRawData();
+                states.push_back(tileData.state1 | tileData.state2 << 2);
+            }
+        }
+        return states;
+    };
+
+    Simulator simulator(board);
+    simulator.setThreadCount(GENERATE(1u, 4u));
+    simulator.setCheckpointInterval(16);
+    simulator.reset();
+    std::vector<std::vector<int>> tickStates;
+    for (int i = 0; i < 100; ++i) {
+        if (i == 10) {
+            board.accessTile(Chunk::WIDTH, 5).setState(State::high);
+            simulator.scheduleUpdate(Chunk::WIDTH, 5, 40);
+        }
+        tickStates.push_back(getStates());
+        simulator.tick();
+    }
+    CHECK(simulator.getCheckpointLog().size() == 7);
+    CHECK(board.accessTile(Chunk::WIDTH + 6, 5).getState() == State::low);
+
+    // Go back to before the timed update, then run forward again and get the same states.
+    REQUIRE(simulator.rewind(70));
+    CHECK(simulator.getTickCount() == 30);
+    CHECK(board.accessTile(Chunk::WIDTH + 6, 5).getState() == State::high);
+    for (int i = 30; i < 100; ++i) {
+        CHECK(getStates() == tickStates[i]);
+        simulator.tick();
+    }
+    REQUIRE(simulator.rewind(95));
+    CHECK(simulator.getTickCount() == 5);
+    CHECK(getStates() == tickStates[5]);
+    CHECK(simulator.getCheckpointLog().size() == 1);
+    CHECK_FALSE(simulator.rewind(10));
+
+    // Checkpoints can't be replayed across an edit.
+    board.accessTile(20, 20).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.notifyTileChanged({20, 20}, TileChange::structure);
+    CHECK(simulator.getCheckpointLog().empty());
+    CHECK_FALSE(simulator.rewind(1));
+}
+
+TEST_CASE("Warp takes checkpoints over quiet ticks", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.setCheckpointInterval(16);
+    simulator.reset();
+    simulator.warp(20);
+    CHECK_FALSE(simulator.hasPendingUpdates());
+    CHECK(simulator.getCheckpointLog().size() == 2);
+
+    // The ticks from 20 on get skipped over, the first interval in them still gets a checkpoint.
+    simulator.warp(1000);
+    CHECK(simulator.getTickCount() == 1020);
+    CHECK(simulator.getCheckpointLog().size() == 3);
+    simulator.pressKey('a');
+    simulator.warp(10);
+    CHECK(board.accessTile(2, 0).getState() == State::low);
+    REQUIRE(simulator.rewind(900));
+    CHECK(simulator.getTickCount() == 130);
+    CHECK(board.accessTile(2, 0).getState() == State::high);
+    // The rewind went from the checkpoint at tick 32, and took a new one at tick 48 on the way.
+    CHECK(simulator.getCheckpointLog().size() == 4);
+}
+
+TEST_CASE("Rewind applies the edits after the checkpoint again", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A switch with a chain of not gates to an LED, and another switch wired straight to an LED.
+    board.accessTile(0, 5).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x <= 5; ++x) {
+        board.accessTile(x, 5).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    }
+    board.accessTile(6, 5).setType(tiles::Led::instance());
+    board.accessTile(0, 8).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+    for (int x = 1; x <= 3; ++x) {
+        board.accessTile(x, 8).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    board.accessTile(4, 8).setType(tiles::Led::instance());
+    auto getStates = [&board]() {
+        std::vector<int> states;
+        for (int y = 0; y < 10; ++y) {
+            for (int x = 0; x < 8; ++x) {
+                const TileData tileData = board.accessTile(x, y).getRawData();
+                states.push_back(tileData.state1 | tileData.state2 << 2);
+            }
+        }
+        return states;
+    };
+
+    Simulator simulator(board);
+    simulator.setThreadCount(GENERATE(1u, 4u));
+    simulator.setCheckpointInterval(16);
+    simulator.reset();
+    std::vector<std::vector<int>> tickStates;
+    for (int i = 0; i < 40; ++i) {
+        if (i == 20) {
+            simulator.pressKey('a');
+        } else if (i == 23) {
+            board.accessTile(0, 8).setState(State::high);
+            board.notifyTileChanged({0, 8}, TileChange::state);
+        }
+        tickStates.push_back(getStates());
+        simulator.tick();
+    }
+    CHECK(board.accessTile(6, 5).getState() == State::low);
+    CHECK(board.accessTile(4, 8).getState() == State::high);
+
+    // The checkpoint at tick 16 is from before both edits, so they get applied again on the way to tick 30.
+    REQUIRE(simulator.rewind(10));
+    CHECK(simulator.getTickCount() == 30);
+    for (int i = 30; i < 40; ++i) {
+        CHECK(getStates() == tickStates[i]);
+        simulator.tick();
+    }
+
+    // Going back to tick 22 keeps the key press, but drops the edit that came after.
+    REQUIRE(simulator.rewind(18));
+    CHECK(simulator.getTickCount() == 22);
+    CHECK(getStates() == tickStates[22]);
+    simulator.warp(18);
+    CHECK(board.accessTile(6, 5).getState() == State::low);
+    CHECK(board.accessTile(4, 8).getState() == State::low);
+}
+
+TEST_CASE("Resident chunks stay under the limit", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A switch and an LED in each of eight chunks in a row.
+    constexpr int numChunks = 8;
+    for (int i = 0; i < numChunks; ++i) {
+        board.accessTile(i * Chunk::WIDTH, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+        board.accessTile(i * Chunk::WIDTH + 1, 0).setType(tiles::Led::instance());
+    }
+    auto markAllSaved = [&board]() {
+        for (const auto& chunk : board.getLoadedChunks()) {
+            chunk.second.markAsSaved();
+        }
+    };
+
+    Simulator simulator(board);
+    simulator.setThreadCount(GENERATE(1u, 4u));
+    simulator.setSleepTicks(0);
+    simulator.setMaxResidentChunks(4);
+    simulator.reset();
+    REQUIRE(simulator.settle(100).stable);
+    markAllSaved();
+    CHECK(simulator.getResidentChunkCount() == numChunks);
+    simulator.warp(200);
+    CHECK(simulator.getResidentChunkCount() <= 4);
+    CHECK(simulator.getSleepingChunkCount() >= numChunks - 4);
+
+    // The chunks load again as each switch is turned on.
+    for (int i = 0; i < numChunks; ++i) {
+        board.accessTile(i * Chunk::WIDTH, 0).setState(State::high);
+        simulator.addUpdate(i * Chunk::WIDTH, 0);
+        REQUIRE(simulator.settle(100).stable);
+        CHECK(board.accessTile(i * Chunk::WIDTH + 1, 0).getState() == State::high);
+        markAllSaved();
+        simulator.warp(200);
+        CHECK(simulator.getResidentChunkCount() <= 4);
+    }
+    for (int i = 0; i < numChunks; ++i) {
+        CHECK(board.accessTile(i * Chunk::WIDTH + 1, 0).getState() == State::high);
+    }
+}
+
+TEST_CASE("Waveform recorder writes a VCD", "[Simulator]") {
+    sim::WaveformRecorder waveform(4);
+    CHECK(waveform.addSignal("out") == 0);
+    CHECK(waveform.addSignal("bus wire") == 1);
+    waveform.record(0, 0, State::low);
+    waveform.record(0, 1, State::disconnected);
+    waveform.record(3, 0, State::high);
+    waveform.record(5, 1, State::middle);
+    // The buffer is full, so this one gets dropped.
+    waveform.record(6, 0, State::low);
+    CHECK(waveform.getDroppedCount() == 1);
+    CHECK(waveform.collect() == 4);
+
+    // Going back to tick 3 replaces the events from there on.
+    waveform.recordRewind(3);
+    waveform.record(4, 0, State::high);
+    CHECK(waveform.collect() == 2);
+    REQUIRE(waveform.getHistory().size() == 3);
+    CHECK(waveform.getHistory().back().tick == 4);
+
+    std::ostringstream out;
+    waveform.writeVcd(out);
+    CHECK(out.str() ==
+        "$version CircuitSim2 $end\n"
+        "$comment One time unit is one tick. $end\n"
+        "$timescale 1 ns $end\n"
+        "$scope module board $end\n"
+        "$var wire 1 ! out $end\n"
+        "$var wire 1 \" bus_wire $end\n"
+        "$upscope $end\n"
+        "$enddefinitions $end\n"
+        "#0\n"
+        "$dumpvars\n"
+        "x!\n"
+        "x\"\n"
+        "$end\n"
+        "0!\n"
+        "z\"\n"
+        "#4\n"
+        "1!\n");
+}
+
+TEST_CASE("Waveform recorder keeps rewinds when the buffer is full", "[Simulator]") {
+    sim::WaveformRecorder waveform(4);
+    waveform.setCapacity(32);
+    CHECK(waveform.getCapacity() == 32);
+    waveform.addSignal("out");
+
+    // The last two slots are kept for rewinds.
+    CHECK(waveform.getFreeSpace() == 30);
+    for (uint64_t tick = 0; tick < 40; ++tick) {
+        waveform.record(tick, 0, (tick % 2 == 0 ? State::low : State::high));
+    }
+    CHECK(waveform.getFreeSpace() == 0);
+    CHECK(waveform.getDroppedCount() == 10);
+    waveform.recordRewind(20);
+    waveform.recordRewind(25);
+    // This marker has to wait, so the state changes after it get dropped until it fits.
+    waveform.recordRewind(10);
+    waveform.record(10, 0, State::high);
+    CHECK(waveform.getDroppedCount() == 11);
+    CHECK(waveform.collect() == 32);
+    REQUIRE(waveform.getHistory().size() == 20);
+    CHECK(waveform.getHistory().back().tick == 19);
+
+    waveform.record(11, 0, State::low);
+    CHECK(waveform.collect() == 2);
+    REQUIRE(waveform.getHistory().size() == 11);
+    CHECK(waveform.getHistory()[9].tick == 9);
+    CHECK(waveform.getHistory()[10].tick == 11);
+    CHECK(waveform.getDroppedCount() == 11);
+}
+
+TEST_CASE("Probes record state changes", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A ring oscillator, and a switch driving a not gate through a crossover in the next chunk.
+    board.accessTile(10, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(11, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::south);
+    board.accessTile(11, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::west);
+    board.accessTile(10, 1).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    board.accessTile(9, 1).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::north);
+    board.accessTile(9, 0).setType(tiles::Wire::instance(), TileId::wireCorner, Direction::east);
+    board.accessTile(Chunk::WIDTH, 5).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(Chunk::WIDTH + 1, 5).setType(tiles::Wire::instance(), TileId::wireCrossover);
+    board.accessTile(Chunk::WIDTH + 2, 5).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+
+    Simulator simulator(board);
+    simulator.setThreadCount(GENERATE(1u, 4u));
+    simulator.setCheckpointInterval(16);
+    simulator.reset();
+    const std::vector<std::pair<sf::Vector2i, int>> probeTiles = {
+        {{10, 0}, 0}, {{10, 1}, 0}, {{Chunk::WIDTH, 5}, 0}, {{Chunk::WIDTH + 1, 5}, 0}, {{Chunk::WIDTH + 1, 5}, 1}, {{Chunk::WIDTH + 2, 5}, 0}
+    };
+    for (const auto& probeTile : probeTiles) {
+        simulator.addProbe(probeTile.first, probeTile.second);
+    }
+    CHECK(simulator.getWaveformRecorder().getSignalName(4) == "tile_" + std::to_string(Chunk::WIDTH + 1) + "_5_1");
+
+    // Keep the states seen after each tick, then check the waveform gives the same states.
+    auto getProbeStates = [&]() {
+        std::vector<State::t> states;
+        for (const auto& probeTile : probeTiles) {
+            const TileData tileData = board.accessTile(probeTile.first).getRawData();
+            states.push_back(static_cast<State::t>(probeTile.second == 0 ? tileData.state1 : tileData.state2));
+        }
+        return states;
+    };
+    std::vector<std::vector<State::t>> tickStates(60);
+    auto runTicks = [&]() {
+        for (uint64_t i = simulator.getTickCount(); i < tickStates.size(); ++i) {
+            if (i % 20 == 5) {
+                const State::t state = board.accessTile(Chunk::WIDTH, 5).getState();
+                board.accessTile(Chunk::WIDTH, 5).setState(state == State::high ? State::low : State::high);
+                simulator.addUpdate(Chunk::WIDTH, 5);
+            }
+            simulator.tick();
+            tickStates[i] = getProbeStates();
+        }
+    };
+    runTicks();
+    auto checkWaveform = [&]() {
+        auto& waveform = simulator.getWaveformRecorder();
+        waveform.collect();
+        CHECK(waveform.getDroppedCount() == 0);
+        std::vector<State::t> states(probeTiles.size(), State::disconnected);
+        size_t eventIndex = 0;
+        unsigned int mismatchCount = 0;
+        for (uint64_t tick = 0; tick < tickStates.size(); ++tick) {
+            for (; eventIndex < waveform.getHistory().size() && waveform.getHistory()[eventIndex].tick <= tick; ++eventIndex) {
+                const auto& event = waveform.getHistory()[eventIndex];
+                states[event.signal] = event.state;
+            }
+            mismatchCount += (states == tickStates[tick] ? 0 : 1);
+        }
+        CHECK(mismatchCount == 0);
+        CHECK(eventIndex == waveform.getHistory().size());
+    };
+    checkWaveform();
+
+    // Running again after a rewind replaces the later part of the waveform (the switch needs to be set again).
+    REQUIRE(simulator.rewind(25));
+    runTicks();
+    checkWaveform();
+
+    simulator.clearProbes();
+    CHECK(simulator.getProbeCount() == 0);
+    CHECK(simulator.getWaveformRecorder().getSignalCount() == 0);
+    simulator.warp(10);
+    CHECK(simulator.getWaveformRecorder().collect() == 0);
+}
+
+TEST_CASE("Recorded key presses replay the same run", "[Simulator]") {
+    auto buildBoard = [](Board& board) {
+        board.newBoard({0, 0});
+        // Switches and a button in two chunks, each driving a not gate and an LED.
+        board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+        board.accessTile(Chunk::WIDTH, 2).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+        board.accessTile(0, 4).setType(tiles::Input::instance(), TileId::inButton, State::low, 'b');
+        for (int y : {0, 4}) {
+            board.accessTile(1, y).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+            board.accessTile(2, y).setType(tiles::Led::instance());
+        }
+        board.accessTile(Chunk::WIDTH + 1, 2).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+        board.accessTile(Chunk::WIDTH + 2, 2).setType(tiles::Led::instance());
+    };
+    auto getStates = [](Board& board) {
+        std::vector<int> states;
+        for (int y = 0; y < 5; ++y) {
+            for (int x = 0; x < Chunk::WIDTH + 3; ++x) {
+                states.push_back(board.accessTile(x, y).getState());
+            }
+        }
+        return states;
+    };
+    const std::vector<std::pair<int, char>> presses = {{3, 'a'}, {10, 'b'}, {11, 'b'}, {11, 'a'}, {25, 'c'}, {40, 'a'}, {41, 'b'}};
+
+    Board board;
+    buildBoard(board);
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.warp(5);
+    simulator.setInputMode(Simulator::InputMode::record);
+    std::vector<std::vector<int>> tickStates;
+    size_t pressIndex = 0;
+    for (int i = 0; i < 60; ++i) {
+        for (; pressIndex < presses.size() && presses[pressIndex].first == i; ++pressIndex) {
+            simulator.pressKey(presses[pressIndex].second);
+        }
+        simulator.tick();
+        tickStates.push_back(getStates(board));
+    }
+    CHECK(board.accessTile(2, 0).getState() == State::low);
+    CHECK(board.accessTile(Chunk::WIDTH + 2, 2).getState() == State::high);
+    REQUIRE(simulator.accessInputLog().size() == presses.size());
+    CHECK(simulator.accessInputLog().getEvents()[2].tick == 11);
+
+    // Save and load the log, then replay it on a new copy of the board after the same start.
+    std::stringstream logStream;
+    REQUIRE(simulator.accessInputLog().save(logStream));
+    Board replayBoard;
+    buildBoard(replayBoard);
+    Simulator replaySimulator(replayBoard);
+    REQUIRE(replaySimulator.accessInputLog().load(logStream));
+    CHECK(replaySimulator.accessInputLog().size() == presses.size());
+    replaySimulator.reset();
+    replaySimulator.warp(5);
+    replaySimulator.setInputMode(Simulator::InputMode::replay);
+    SECTION("Single ticks") {
+        unsigned int mismatchCount = 0;
+        for (int i = 0; i < 60; ++i) {
+            replaySimulator.tick();
+            mismatchCount += (getStates(replayBoard) == tickStates[i] ? 0 : 1);
+        }
+        CHECK(mismatchCount == 0);
+    }
+    SECTION("Warp") {
+        // The warp skips ahead over the quiet ticks between presses.
+        replaySimulator.warp(30);
+        CHECK(getStates(replayBoard) == tickStates[29]);
+        replaySimulator.warp(30);
+        CHECK(getStates(replayBoard) == tickStates[59]);
+    }
+    SECTION("Settle") {
+        // The board goes quiet in the gaps between presses, which shouldn't look like a cycle.
+        const auto result = replaySimulator.settle(1000);
+        CHECK(result.stable);
+        CHECK(result.period == 0);
+        CHECK(result.ticks < 60);
+        CHECK(getStates(replayBoard) == tickStates[59]);
+    }
+    SECTION("Rewind after the replay") {
+        // Going back to before the presses once the replay finished runs them again from the log.
+        replaySimulator.setCheckpointInterval(8);
+        replaySimulator.warp(60);
+        CHECK(replaySimulator.getInputMode() == Simulator::InputMode::none);
+        REQUIRE(replaySimulator.rewind(55));
+        CHECK(replaySimulator.getInputMode() == Simulator::InputMode::replay);
+        CHECK(getStates(replayBoard) == tickStates[4]);
+        unsigned int mismatchCount = 0;
+        for (int i = 5; i < 60; ++i) {
+            replaySimulator.tick();
+            mismatchCount += (getStates(replayBoard) == tickStates[i] ? 0 : 1);
+        }
+        CHECK(mismatchCount == 0);
+    }
+    CHECK(replaySimulator.getInputMode() == Simulator::InputMode::none);
+    CHECK_FALSE(replaySimulator.hasPendingUpdates());
+
+    std::stringstream badLog("version: 1\n5 97\n3 98\n");
+    CHECK_FALSE(replaySimulator.accessInputLog().load(badLog));
+    CHECK(replaySimulator.accessInputLog().empty());
+}
+
+TEST_CASE("Rewind while recording keeps the presses before the target", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(2, 0).setType(tiles::Led::instance());
+
+    Simulator simulator(board);
+    simulator.setCheckpointInterval(16);
+    simulator.reset();
+    simulator.warp(5);
+    simulator.setInputMode(Simulator::InputMode::record);
+    for (int i = 5; i < 40; ++i) {
+        if (i == 20 || i == 30) {
+            simulator.pressKey('a');
+        }
+        simulator.tick();
+    }
+    const auto& events = simulator.accessInputLog().getEvents();
+    REQUIRE(events.size() == 2);
+
+    // The checkpoint is at tick 16, the press at tick 20 stays in the log and gets applied again.
+    REQUIRE(simulator.rewind(15));
+    CHECK(simulator.getTickCount() == 25);
+    REQUIRE(events.size() == 1);
+    CHECK(events[0].tick == 15);
+    CHECK(board.accessTile(0, 0).getState() == State::high);
+    CHECK(board.accessTile(2, 0).getState() == State::low);
+    simulator.pressKey('a');
+    REQUIRE(events.size() == 2);
+    CHECK(events[1].tick == 20);
+
+    // Going back to before the recording started, the recording starts over from there.
+    REQUIRE(simulator.rewind(22));
+    CHECK(simulator.getTickCount() == 3);
+    CHECK(events.empty());
+    CHECK(board.accessTile(0, 0).getState() == State::low);
+    simulator.warp(2);
+    simulator.pressKey('a');
+    REQUIRE(events.size() == 1);
+    CHECK(events[0].tick == 2);
+}
+
+TEST_CASE("Key presses follow edits and loaded chunks", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.accessTile(1, 0).setType(tiles::Led::instance());
+    Simulator simulator(board);
+    simulator.reset();
+    auto pressAndRun = [&](char keycode) {
+        simulator.pressKey(keycode);
+        simulator.warp(10);
+    };
+    pressAndRun('a');
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+
+    // A new switch with the same key.
+    board.accessTile(0, 2).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    board.notifyTileChanged({0, 2}, TileChange::structure);
+    board.accessTile(1, 2).setType(tiles::Led::instance());
+    board.notifyTileChanged({1, 2}, TileChange::structure);
+    pressAndRun('a');
+    CHECK(board.accessTile(1, 0).getState() == State::low);
+    CHECK(board.accessTile(1, 2).getState() == State::high);
+
+    // Changing the key of the first switch and removing the second.
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'b');
+    board.notifyTileChanged({0, 0}, TileChange::structure);
+    board.accessTile(0, 2).setType(tiles::Blank::instance());
+    board.notifyTileChanged({0, 2}, TileChange::structure);
+    simulator.warp(10);
+    CHECK(board.accessTile(1, 2).getState() == State::low);
+    pressAndRun('a');
+    CHECK(board.accessTile(1, 0).getState() == State::low);
+    CHECK(board.accessTile(1, 2).getState() == State::low);
+    pressAndRun('b');
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+
+    // A chunk loaded into the board after the reset.
+    Chunk chunk(nullptr, ChunkCoords::pack(2, 0));
+    chunk.accessTile(0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    chunk.accessTile(1).setType(tiles::Led::instance());
+    board.loadChunk(std::move(chunk));
+    pressAndRun('a');
+    CHECK(board.accessTile(Chunk::WIDTH * 2 + 1, 0).getState() == State::high);
+    CHECK(board.accessTile(1, 0).getState() == State::high);
+}
+
+TEST_CASE("Chunk profiling counts activity per chunk", "[Simulator]") {
+    Board board;
+    board.newBoard({0, 0});
+    // A switch driving a wire into the next chunk, then a not gate and an LED there.
+    board.accessTile(0, 0).setType(tiles::Input::instance(), TileId::inSwitch, State::low, 'a');
+    for (int x = 1; x < Chunk::WIDTH + 2; ++x) {
+        board.accessTile(x, 0).setType(tiles::Wire::instance(), TileId::wireStraight, Direction::east);
+    }
+    board.accessTile(Chunk::WIDTH + 2, 0).setType(tiles::Gate::instance(), TileId::gateNot, Direction::east);
+    board.accessTile(Chunk::WIDTH + 3, 0).setType(tiles::Led::instance());
+    Simulator simulator(board);
+    simulator.reset();
+    simulator.warp(10);
+    CHECK(simulator.getChunkActivity().empty());
+    CHECK(simulator.getProfiledTickCount() == 0);
+
+    const unsigned int threadCount = GENERATE(1, 2);
+    simulator.setThreadCount(threadCount);
+    simulator.setChunkProfiling(true);
+    simulator.pressKey('a');
+    simulator.warp(10);
+    CHECK(board.accessTile(Chunk::WIDTH + 3, 0).getState() == State::low);
+    CHECK(simulator.getProfiledTickCount() == 10);
+    auto activity = simulator.getChunkActivity();
+    std::sort(activity.begin(), activity.end(), [](const std::pair<ChunkCoords::repr, Simulator::ChunkActivity>& lhs, const std::pair<ChunkCoords::repr, Simulator::ChunkActivity>& rhs) {
+        return ChunkCoords::x(lhs.first) < ChunkCoords::x(rhs.first);
+    });
+    REQUIRE(activity.size() == 2);
+    // The switch (and the wire next to it) schedules the net in the first chunk, the gate and LED get updates in the
+    // second.
+    CHECK(activity[0].first == ChunkCoords::pack(0, 0));
+    CHECK(activity[0].second.updates == 2);
+    CHECK(activity[0].second.netEvaluations == 1);
+    CHECK(activity[0].second.nanoseconds > 0);
+    CHECK(activity[1].first == ChunkCoords::pack(1, 0));
+    CHECK(activity[1].second.updates >= 1);
+    CHECK(activity[1].second.netEvaluations == 0);
+
+    simulator.clearChunkActivity();
+    CHECK(simulator.getChunkActivity().empty());
+    CHECK(simulator.getProfiledTickCount() == 0);
+    simulator.setChunkProfiling(false);
+    simulator.pressKey('a');
+    simulator.warp(10);
+    CHECK(board.accessTile(Chunk::WIDTH + 3, 0).getState() == State::high);
+    CHECK(simulator.getChunkActivity().empty());
+}